@@ -0,0 +1,381 @@
+#include <ReliableUDP/PacketHandler.h>
+#include <ReliableUDP/Utils/Core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Latencies in microseconds
+struct LatencySummary
+{
+public:
+	static LatencySummary From(std::vector<double>& samples)
+	{
+		LatencySummary summary;
+		summary.m_Samples = samples.size();
+		if (samples.empty())
+			return summary;
+
+		std::sort(samples.begin(), samples.end());
+		auto percentile { [&](double p) { return samples[std::min<std::size_t>(static_cast<std::size_t>(p * static_cast<double>(samples.size())), samples.size() - 1)]; } };
+		double sum { 0.0 };
+		for (double sample : samples)
+			sum += sample;
+		summary.m_Mean = sum / static_cast<double>(samples.size());
+		summary.m_P50  = percentile(0.5);
+		summary.m_P90  = percentile(0.9);
+		summary.m_P99  = percentile(0.99);
+		summary.m_P999 = percentile(0.999);
+		summary.m_Max  = samples.back();
+		return summary;
+	}
+
+	void write(std::ostream& out) const
+	{
+		out << "\"samples\": " << m_Samples << ", \"mean_us\": " << m_Mean << ", \"p50_us\": " << m_P50 << ", \"p90_us\": " << m_P90 << ", \"p99_us\": " << m_P99 << ", \"p999_us\": " << m_P999 << ", \"max_us\": " << m_Max;
+	}
+
+public:
+	std::size_t m_Samples { 0U };
+	double      m_Mean { 0.0 };
+	double      m_P50 { 0.0 };
+	double      m_P90 { 0.0 };
+	double      m_P99 { 0.0 };
+	double      m_P999 { 0.0 };
+	double      m_Max { 0.0 };
+};
+
+static double MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::uint64_t NowNanoseconds()
+{
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void ServerFunc(ReliableUDP::PacketHandler* handler, std::atomic<bool>* running)
+{
+	while (running->load())
+		handler->waitAndUpdate(0.01f);
+}
+
+static bool BindLoopback(ReliableUDP::PacketHandler& handler)
+{
+	auto& socket { handler.getSocket() };
+	socket.setNonBlocking();
+	// 127.0.0.1 in host byte order
+	return socket.bind({ ReliableUDP::Networking::IPv4Address { 0x7F000001U }, 0U });
+}
+
+//---------
+// Latency
+//---------
+
+struct LatencyResult
+{
+public:
+	std::uint32_t  m_Size { 0U };
+	std::uint32_t  m_Lost { 0U };
+	LatencySummary m_Summary;
+};
+
+static std::atomic<std::uint32_t> g_Echoes { 0U };
+
+static void EchoHandler(ReliableUDP::PacketHandler* handler, ReliableUDP::Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
+{
+	handler->sendPacket(endpoint, packet, size);
+}
+
+static void EchoReceivedHandler([[maybe_unused]] ReliableUDP::PacketHandler* handler, [[maybe_unused]] ReliableUDP::Networking::Endpoint endpoint, [[maybe_unused]] std::uint8_t* packet, [[maybe_unused]] std::uint32_t size)
+{
+	g_Echoes.fetch_add(1U);
+}
+
+// One message at a time, echoed back by the server
+static std::vector<LatencyResult> RunLatency(std::uint32_t iterations)
+{
+	std::vector<LatencyResult> results;
+
+	ReliableUDP::PacketHandler server { 1U << 20, 1U << 20, 64, 64, 8, &EchoHandler, nullptr };
+	ReliableUDP::PacketHandler client { 1U << 20, 1U << 20, 64, 64, 8, &EchoReceivedHandler, nullptr };
+	if (!BindLoopback(server) || !BindLoopback(client))
+		return results;
+
+	std::atomic<bool> running { true };
+	std::thread       serverThread { &ServerFunc, &server, &running };
+
+	auto                      endpoint { server.getSocket().getLocalEndpoint() };
+	std::vector<std::uint8_t> message(4096);
+	for (std::uint32_t size : { 64U, 256U, 1024U, 4096U })
+	{
+		LatencyResult result;
+		result.m_Size = size;
+
+		std::vector<double> samples;
+		samples.reserve(iterations);
+		// The first tenth is warm up
+		std::uint32_t warmup { iterations / 10U };
+		for (std::uint32_t i { 0 }; i < warmup + iterations; ++i)
+		{
+			std::uint32_t expected { g_Echoes.load() + 1U };
+			auto          start { std::chrono::steady_clock::now() };
+			client.sendPacket(endpoint, message.data(), size);
+			while (g_Echoes.load() < expected && std::chrono::steady_clock::now() - start < std::chrono::seconds(1))
+				client.waitAndUpdate(0.001f);
+
+			if (g_Echoes.load() < expected)
+			{
+				++result.m_Lost;
+				g_Echoes.store(expected);
+			}
+			else if (i >= warmup)
+			{
+				samples.push_back(MicrosecondsSince(start));
+			}
+		}
+		result.m_Summary = LatencySummary::From(samples);
+		results.push_back(result);
+		std::cerr << "latency " << size << " B: p50 " << result.m_Summary.m_P50 << " us, p99 " << result.m_Summary.m_P99 << " us\n";
+	}
+
+	running.store(false);
+	serverThread.join();
+	return results;
+}
+
+//------------
+// Throughput
+//------------
+
+struct ThroughputResult
+{
+public:
+	std::uint32_t m_Size { 0U };
+	std::uint32_t m_Messages { 0U };
+	std::uint64_t m_Bytes { 0U };
+	double        m_Seconds { 0.0 };
+	std::uint64_t m_SectionsSent { 0U };
+	std::uint64_t m_SectionsRetransmitted { 0U };
+	std::uint64_t m_WriteTimeouts { 0U };
+};
+
+static std::atomic<std::uint32_t> g_SinkMessages { 0U };
+static std::atomic<std::uint64_t> g_SinkBytes { 0U };
+
+static void SinkHandler([[maybe_unused]] ReliableUDP::PacketHandler* handler, [[maybe_unused]] ReliableUDP::Networking::Endpoint endpoint, [[maybe_unused]] std::uint8_t* packet, std::uint32_t size)
+{
+	g_SinkBytes.fetch_add(size);
+	g_SinkMessages.fetch_add(1U);
+}
+
+static std::vector<ThroughputResult> RunThroughput(std::uint32_t messages)
+{
+	std::vector<ThroughputResult> results;
+	for (std::uint32_t size : { 45056U, 262144U })
+	{
+		ReliableUDP::PacketHandler server { 32U << 20, 1U << 20, 256, 64, 8, &SinkHandler, nullptr };
+		ReliableUDP::PacketHandler client { 1U << 20, 32U << 20, 64, 256, 8, nullptr, nullptr };
+		if (!BindLoopback(server) || !BindLoopback(client))
+			return results;
+
+		g_SinkMessages.store(0U);
+		g_SinkBytes.store(0U);
+		std::atomic<bool> running { true };
+		std::thread       serverThread { &ServerFunc, &server, &running };
+
+		auto                      endpoint { server.getSocket().getLocalEndpoint() };
+		std::vector<std::uint8_t> message(size, 0x5AU);
+		std::uint32_t             sent { 0U };
+		auto                      start { std::chrono::steady_clock::now() };
+		while (g_SinkMessages.load() + client.getStats().m_WriteTimeouts.get() < messages && std::chrono::steady_clock::now() - start < std::chrono::seconds(30))
+		{
+			while (sent < messages && client.sendPacket(endpoint, message.data(), size))
+				++sent;
+			client.waitAndUpdate(0.001f);
+		}
+
+		ThroughputResult result;
+		result.m_Size                  = size;
+		result.m_Messages              = g_SinkMessages.load();
+		result.m_Bytes                 = g_SinkBytes.load();
+		result.m_Seconds               = MicrosecondsSince(start) / 1e6;
+		result.m_SectionsSent          = client.getStats().m_SectionsSent.get();
+		result.m_SectionsRetransmitted = client.getStats().m_SectionsRetransmitted.get();
+		result.m_WriteTimeouts         = client.getStats().m_WriteTimeouts.get();
+		results.push_back(result);
+		std::cerr << "throughput " << size << " B: " << static_cast<double>(result.m_Bytes) / result.m_Seconds / 1e6 << " MB/s\n";
+
+		running.store(false);
+		serverThread.join();
+	}
+	return results;
+}
+
+//--------
+// Fan-in
+//--------
+
+struct FanInResult
+{
+public:
+	std::uint32_t  m_Peers { 0U };
+	std::uint32_t  m_MessagesPerPeer { 0U };
+	std::uint32_t  m_Size { 0U };
+	std::uint32_t  m_Delivered { 0U };
+	double         m_Seconds { 0.0 };
+	LatencySummary m_Summary;
+};
+
+static std::vector<double> g_FanInLatencies;
+
+static void FanInHandler([[maybe_unused]] ReliableUDP::PacketHandler* handler, [[maybe_unused]] ReliableUDP::Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
+{
+	std::uint64_t sendTime { 0U };
+	if (size >= sizeof(sendTime))
+		std::memcpy(&sendTime, packet, sizeof(sendTime));
+	g_FanInLatencies.push_back(static_cast<double>(NowNanoseconds() - sendTime) / 1e3);
+	g_SinkMessages.fetch_add(1U);
+}
+
+// Many peers with their own sockets send small messages to one server
+static FanInResult RunFanIn(std::uint32_t peers, std::uint32_t messagesPerPeer)
+{
+	FanInResult result;
+	result.m_Peers           = peers;
+	result.m_MessagesPerPeer = messagesPerPeer;
+	result.m_Size            = 512U;
+
+	ReliableUDP::PacketHandler server { 8U << 20, 1U << 20, 1024, 256, 8, &FanInHandler, nullptr };
+	if (!BindLoopback(server))
+		return result;
+
+	std::vector<std::unique_ptr<ReliableUDP::PacketHandler>> clients;
+	for (std::uint32_t i { 0 }; i < peers; ++i)
+	{
+		clients.push_back(std::make_unique<ReliableUDP::PacketHandler>(65536U, 262144U, 16U, 32U, 8U, nullptr, nullptr));
+		if (!BindLoopback(*clients.back()))
+			return result;
+	}
+
+	g_SinkMessages.store(0U);
+	g_FanInLatencies.clear();
+	g_FanInLatencies.reserve(static_cast<std::size_t>(peers) * messagesPerPeer);
+	std::atomic<bool> running { true };
+	std::thread       serverThread { &ServerFunc, &server, &running };
+
+	auto                       endpoint { server.getSocket().getLocalEndpoint() };
+	std::vector<std::uint32_t> sent(peers, 0U);
+	std::vector<std::uint8_t>  message(result.m_Size, 0xA5U);
+	std::uint32_t              total { peers * messagesPerPeer };
+	auto                       start { std::chrono::steady_clock::now() };
+	while (g_SinkMessages.load() < total && std::chrono::steady_clock::now() - start < std::chrono::seconds(30))
+	{
+		for (std::uint32_t i { 0 }; i < peers; ++i)
+		{
+			ReliableUDP::PacketHandler& client { *clients[i] };
+			while (sent[i] < messagesPerPeer)
+			{
+				std::uint64_t sendTime { NowNanoseconds() };
+				std::memcpy(message.data(), &sendTime, sizeof(sendTime));
+				if (!client.sendPacket(endpoint, message.data(), result.m_Size))
+					break;
+				++sent[i];
+			}
+			client.updatePackets();
+		}
+	}
+	result.m_Seconds = MicrosecondsSince(start) / 1e6;
+
+	running.store(false);
+	serverThread.join();
+	result.m_Delivered = g_SinkMessages.load();
+	result.m_Summary   = LatencySummary::From(g_FanInLatencies);
+	std::cerr << "fan-in " << peers << " peers: " << static_cast<double>(result.m_Delivered) / result.m_Seconds << " msg/s, p99 " << result.m_Summary.m_P99 << " us\n";
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	// --quick for a smoke test, --output writes the JSON to a file
+	bool        quick { false };
+	std::string output;
+	for (int i { 1 }; i < argc; ++i)
+	{
+		std::string_view arg { argv[i] };
+		if (arg == "--quick")
+			quick = true;
+		else if (arg == "--output" && i + 1 < argc)
+			output = argv[++i];
+	}
+
+	auto latency { RunLatency(quick ? 200U : 5000U) };
+	auto throughput { RunThroughput(quick ? 50U : 1000U) };
+	auto fanIn { RunFanIn(quick ? 16U : 64U, quick ? 50U : 500U) };
+
+	std::ostringstream json;
+	json << "{\n";
+	json << "  \"benchmark\": \"ReliableUDP\",\n";
+	json << "  \"schema\": 1,\n";
+	json << "  \"timestamp\": " << static_cast<std::uint64_t>(std::time(nullptr)) << ",\n";
+#if BUILD_CONFIG == BUILD_CONFIG_DEBUG
+	json << "  \"config\": \"debug\",\n";
+#elif BUILD_CONFIG == BUILD_CONFIG_RELEASE
+	json << "  \"config\": \"release\",\n";
+#elif BUILD_CONFIG == BUILD_CONFIG_DIST
+	json << "  \"config\": \"dist\",\n";
+#else
+	json << "  \"config\": \"unknown\",\n";
+#endif
+	json << "  \"quick\": " << (quick ? "true" : "false") << ",\n";
+
+	json << "  \"latency\": [";
+	for (std::size_t i { 0 }; i < latency.size(); ++i)
+	{
+		json << (i ? ",\n" : "\n") << "    { \"size\": " << latency[i].m_Size << ", \"lost\": " << latency[i].m_Lost << ", ";
+		latency[i].m_Summary.write(json);
+		json << " }";
+	}
+	json << "\n  ],\n";
+
+	json << "  \"throughput\": [";
+	for (std::size_t i { 0 }; i < throughput.size(); ++i)
+	{
+		const ThroughputResult& result { throughput[i] };
+		json << (i ? ",\n" : "\n") << "    { \"size\": " << result.m_Size << ", \"messages\": " << result.m_Messages << ", \"bytes\": " << result.m_Bytes << ", \"seconds\": " << result.m_Seconds
+		     << ", \"megabytes_per_second\": " << static_cast<double>(result.m_Bytes) / result.m_Seconds / 1e6 << ", \"messages_per_second\": " << static_cast<double>(result.m_Messages) / result.m_Seconds
+		     << ", \"sections_sent\": " << result.m_SectionsSent << ", \"sections_retransmitted\": " << result.m_SectionsRetransmitted << ", \"write_timeouts\": " << result.m_WriteTimeouts << " }";
+	}
+	json << "\n  ],\n";
+
+	json << "  \"fan_in\": { \"peers\": " << fanIn.m_Peers << ", \"messages_per_peer\": " << fanIn.m_MessagesPerPeer << ", \"size\": " << fanIn.m_Size << ", \"delivered\": " << fanIn.m_Delivered << ", \"seconds\": " << fanIn.m_Seconds
+	     << ", \"messages_per_second\": " << static_cast<double>(fanIn.m_Delivered) / fanIn.m_Seconds << ", ";
+	fanIn.m_Summary.write(json);
+	json << " }\n";
+	json << "}\n";
+
+	if (output.empty())
+	{
+		std::cout << json.str();
+	}
+	else
+	{
+		std::ofstream file { output };
+		if (!file)
+		{
+			std::cerr << "Failed to open " << output << "\n";
+			return 1;
+		}
+		file << json.str();
+	}
+	return 0;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "PacketHandler.h"
+
+#include <random>
+
+namespace ReliableUDP
+{
+	// One direction of a simulated link, all off by default
+	struct LinkConditions
+	{
+	public:
+		float m_Loss { 0.0f }; // Chance of losing any datagram
+		// Gilbert-Elliott burst loss
+		float m_BurstStart { 0.0f };
+		float m_BurstEnd { 1.0f };
+		float m_BurstLoss { 1.0f };
+
+		float m_Delay { 0.0f };  // Seconds
+		float m_Jitter { 0.0f }; // Up to this many seconds are added to the delay, so datagrams sent closer together than that can swap places
+		// Chance of holding a datagram back by m_ReorderDelay seconds
+		float m_Reorder { 0.0f };
+		float m_ReorderDelay { 0.0f };
+		float m_Duplicate { 0.0f }; // Chance of delivering a datagram twice
+
+		// Bytes per second, 0 for unlimited, dropping past m_QueueSize queued bytes
+		std::uint64_t m_Bandwidth { 0U };
+		std::uint32_t m_QueueSize { 1U << 16 };
+		std::uint32_t m_MaxDatagramSize { 0U };
+	};
+
+	struct SimulatorStats
+	{
+	public:
+		std::uint64_t m_Sent { 0U };
+		std::uint64_t m_Delivered { 0U };
+		std::uint64_t m_Lost { 0U };
+		std::uint64_t m_BurstLost { 0U };
+		std::uint64_t m_Duplicated { 0U };
+		std::uint64_t m_Reordered { 0U };
+		std::uint64_t m_QueueDropped { 0U }; // Over the link's bandwidth queue
+		std::uint64_t m_Oversized { 0U };    // Over the link's datagram size limit
+		std::uint64_t m_Overflowed { 0U };   // The receiving socket's queue was full
+		std::uint64_t m_Unroutable { 0U };   // No socket is attached at the destination
+	};
+
+	// Connects in-memory sockets through lossy links on simulated time.
+	// Single threaded, the same seed and calls give the same run.
+	// Only handlers made after the simulator became current run on simulated time
+	struct NetworkSimulator
+	{
+	public:
+		static constexpr std::uint32_t s_MaxSockets = 16U;
+
+	public:
+		NetworkSimulator(std::uint64_t seed = 1U);
+		NetworkSimulator(const NetworkSimulator&) = delete;
+		~NetworkSimulator();
+
+		NetworkSimulator& operator=(const NetworkSimulator&) = delete;
+
+		// Binds the socket in memory to endpoint, the socket has to outlive the simulator.
+		// A capture callback set afterwards takes the socket off the simulator
+		bool attach(Networking::Socket& socket, Networking::Endpoint endpoint, std::uint32_t queueSize = 1U << 20);
+
+		void setConditions(const LinkConditions& conditions);
+		void setConditions(Networking::Endpoint source, Networking::Endpoint destination, const LinkConditions& conditions);
+
+		// Makes Clock::now() on the calling thread return the simulated time
+		void useSimulatedTime();
+		void useRealTime();
+
+		void advance(Clock::duration duration);
+		// Updates the handlers, jumping from deadline to deadline without sleeping
+		void run(PacketHandler* const* handlers, std::size_t count, Clock::duration duration);
+
+		Clock::time_point getNextDelivery() const;
+
+		auto        now() const { return m_Now; }
+		auto&       getStats() const { return m_Stats; }
+		const auto& getDefaultConditions() const { return m_Conditions; }
+
+	private:
+		struct SocketEntry
+		{
+		public:
+			Networking::Socket*                 m_Socket { nullptr };
+			Networking::Endpoint                m_Endpoint;
+			Networking::Socket::CaptureCallback m_CaptureCallback { nullptr };
+			void*                               m_CaptureData { nullptr };
+		};
+
+		struct LinkState
+		{
+		public:
+			LinkConditions    m_Conditions;
+			bool              m_Custom { false };
+			bool              m_Bad { false };
+			Clock::time_point m_BusyUntil;
+		};
+
+		struct InFlight
+		{
+		public:
+			Clock::time_point    m_Time;
+			std::uint64_t        m_Order { 0U }; // Keeps datagrams due at the same time in the order they were sent
+			std::uint32_t        m_Destination { 0U };
+			Networking::Endpoint m_Source;
+			std::uint8_t*        m_Data { nullptr };
+			std::uint32_t        m_Size { 0U };
+		};
+
+		static Clock::time_point Now(void* userData);
+		static void              Route(Networking::Socket* socket, void* captureData, bool sent, Networking::Endpoint endpoint, const Networking::Buffer* buffers, std::size_t count);
+
+		std::uint32_t findSocket(Networking::Endpoint endpoint) const;
+		void          send(std::uint32_t source, std::uint32_t destination, const Networking::Buffer* buffers, std::size_t count);
+		void          schedule(Clock::time_point time, std::uint32_t destination, Networking::Endpoint source, const Networking::Buffer* buffers, std::size_t count, std::uint32_t size);
+		void          deliverNext();
+		float         random();
+
+		static bool Earlier(const InFlight& lhs, const InFlight& rhs) { return lhs.m_Time < rhs.m_Time || (lhs.m_Time == rhs.m_Time && lhs.m_Order < rhs.m_Order); }
+
+	private:
+		std::mt19937_64   m_Random;
+		Clock::time_point m_Now;
+		bool              m_Current { false };
+
+		SocketEntry    m_Sockets[s_MaxSockets];
+		std::uint32_t  m_SocketCount { 0U };
+		LinkState*     m_Links;
+		LinkConditions m_Conditions;
+
+		InFlight*     m_InFlight { nullptr };
+		std::uint32_t m_InFlightCount { 0U };
+		std::uint32_t m_InFlightCapacity { 0U };
+		std::uint64_t m_NextOrder { 0U };
+
+		SimulatorStats m_Stats;
+	};
+} // namespace ReliableUDP
@@ -26,6 +26,8 @@ namespace ReliableUDP::Networking
 
 		std::string toString() const;
 		std::string toHost() const;
+		// For hash tables keyed by endpoint
+		std::uint64_t hash() const;
 
 		bool operator==(Endpoint other) const;
 
@@ -33,4 +35,10 @@ namespace ReliableUDP::Networking
 		Address       m_Address;
 		std::uint16_t m_Port;
 	};
+
+	struct EndpointHash
+	{
+	public:
+		static std::uint64_t Hash(Endpoint endpoint) { return endpoint.hash(); }
+	};
 } // namespace ReliableUDP::Networking
\ No newline at end of file
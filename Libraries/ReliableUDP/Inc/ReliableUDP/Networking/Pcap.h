@@ -0,0 +1,102 @@
+#pragma once
+
+#include "../Utils/Metrics.h"
+#include "../Utils/SPSCRing.h"
+#include "Socket.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace ReliableUDP::Networking
+{
+	// Writes captured datagrams to a pcap file as raw IP packets with nanosecond timestamps.
+	// A background thread writes the buffer out, datagrams that do not fit are dropped
+	struct PcapWriter
+	{
+	public:
+		static void Capture(Socket* socket, void* captureData, bool sent, Endpoint endpoint, const Buffer* buffers, std::size_t count);
+
+	public:
+		PcapWriter(std::uint32_t bufferSize = 1U << 22);
+		PcapWriter(const PcapWriter&) = delete;
+		~PcapWriter();
+
+		PcapWriter& operator=(const PcapWriter&) = delete;
+
+		bool open(std::string_view path);
+		void close();
+		bool isOpen() const { return m_File != nullptr; }
+
+		// Several sockets can share one writer
+		void attach(Socket& socket) { socket.setCaptureCallback(&Capture, this); }
+
+		// Safe to call from any thread
+		void record(bool sent, Endpoint local, Endpoint remote, const Buffer* buffers, std::size_t count);
+
+		std::uint64_t getRecorded() const { return m_Recorded.get(); }
+		std::uint64_t getDropped() const { return m_Dropped.get(); }
+
+	private:
+		void threadFunc();
+		bool drain();
+
+	private:
+		std::FILE* m_File { nullptr };
+
+		// Producers take the mutex, the writer thread reads without it
+		std::mutex       m_BufferMutex;
+		Utils::SPSCRing* m_Buffer;
+
+		std::thread             m_Thread;
+		std::atomic<bool>       m_Running { false };
+		std::mutex              m_WakeMutex;
+		std::condition_variable m_Wake;
+
+		Utils::Counter m_Recorded;
+		Utils::Counter m_Dropped;
+	};
+
+	struct PcapRecord
+	{
+	public:
+		std::uint64_t       m_Time { 0U };
+		Endpoint            m_Source;
+		Endpoint            m_Destination;
+		const std::uint8_t* m_Data { nullptr };
+		std::uint32_t       m_Size { 0U };
+	};
+
+	// Reads the UDP datagrams out of a pcap file.
+	// Raw IP, Ethernet, BSD loopback and Linux cooked captures
+	struct PcapReader
+	{
+	public:
+		PcapReader()                  = default;
+		PcapReader(const PcapReader&) = delete;
+		~PcapReader();
+
+		PcapReader& operator=(const PcapReader&) = delete;
+
+		bool open(std::string_view path);
+		void close();
+		bool isOpen() const { return m_File != nullptr; }
+
+		// The record's data stays valid until the next call
+		bool next(PcapRecord& record);
+
+	private:
+		std::uint32_t read32(const std::uint8_t* data) const;
+
+	private:
+		std::FILE*    m_File { nullptr };
+		bool          m_Swapped { false };
+		bool          m_Nanoseconds { false };
+		std::uint32_t m_LinkType { 0U };
+
+		std::uint8_t* m_Packet { nullptr };
+		std::uint32_t m_PacketSize { 0U };
+	};
+} // namespace ReliableUDP::Networking
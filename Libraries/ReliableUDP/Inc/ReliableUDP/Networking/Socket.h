@@ -4,6 +4,11 @@
 
 #include <string_view>
 
+namespace ReliableUDP::Utils
+{
+	struct SPSCRing;
+}
+
 namespace ReliableUDP::Networking
 {
 	enum class ESocketError : std::uint32_t
@@ -25,7 +30,8 @@ namespace ReliableUDP::Networking
 		ListenUnsupported,
 		AlreadyConnected,
 		NetworkDown,
-		HostDown
+		HostDown,
+		MessageTooLarge
 	};
 
 	std::string_view GetSocketErrorString(ESocketError error);
@@ -36,14 +42,49 @@ namespace ReliableUDP::Networking
 		UDP
 	};
 
+	struct Buffer
+	{
+	public:
+		const void* m_Data { nullptr };
+		std::size_t m_Size { 0U };
+	};
+
+	// Built once, so sends to known peers skip converting the endpoint
+	struct SocketAddress
+	{
+	public:
+		static SocketAddress FromEndpoint(Endpoint endpoint);
+
+	public:
+		alignas(8) std::uint8_t m_Data[28] {};
+		std::uint32_t m_Size { 0U };
+	};
+
+	struct Datagram
+	{
+	public:
+		void*       m_Buffer { nullptr };
+		std::size_t m_Size { 0U }; // readFromMany: Capacity of m_Buffer in, received size out. writeToMany: Size to send
+		Endpoint    m_Endpoint;
+		// writeToMany only: Sent after m_Buffer without being copied
+		const void* m_Payload { nullptr };
+		std::size_t m_PayloadSize { 0U };
+		// writeToMany only: Has to match m_Endpoint
+		const SocketAddress* m_Address { nullptr };
+		// writeToMany only: Set if the socket refused the datagram
+		bool m_Rejected { false };
+	};
+
 	class Socket
 	{
 	public:
 		using ErrorReportCallback = void (*)(Socket* socket, void* userData, ESocketError error);
+		// Called on the thread doing the I/O with every datagram sent or received
+		using CaptureCallback = void (*)(Socket* socket, void* captureData, bool sent, Endpoint endpoint, const Buffer* buffers, std::size_t count);
 
 	public:
-		Socket() : m_Type(ESocketType::TCP), m_WriteTimeout(2000), m_ReadTimeout(2000), m_Socket(~0ULL), m_ErrorCallback(nullptr), m_UserData(nullptr) {}
-		Socket(ESocketType type, std::uint32_t writeTimeout = 2000, std::uint32_t readTimeout = 2000) : m_Type(type), m_WriteTimeout(writeTimeout), m_ReadTimeout(readTimeout), m_Socket(~0ULL), m_ErrorCallback(nullptr), m_UserData(nullptr) {}
+		Socket() : m_Type(ESocketType::TCP), m_WriteTimeout(2000), m_ReadTimeout(2000), m_Socket(~0ULL), m_ErrorCallback(nullptr), m_UserData(nullptr), m_CaptureCallback(nullptr), m_CaptureData(nullptr) {}
+		Socket(ESocketType type, std::uint32_t writeTimeout = 2000, std::uint32_t readTimeout = 2000) : m_Type(type), m_WriteTimeout(writeTimeout), m_ReadTimeout(readTimeout), m_Socket(~0ULL), m_ErrorCallback(nullptr), m_UserData(nullptr), m_CaptureCallback(nullptr), m_CaptureData(nullptr) {}
 		Socket(Socket&& move) noexcept;
 		~Socket();
 
@@ -51,8 +92,25 @@ namespace ReliableUDP::Networking
 		std::size_t readFrom(void* buf, std::size_t len, Endpoint& endpoint);
 		std::size_t write(const void* buf, std::size_t len);
 		std::size_t writeTo(const void* buf, std::size_t len, Endpoint endpoint);
+		// Gathers up to 16 buffers into a single datagram
+		std::size_t writeToV(const Buffer* buffers, std::size_t count, Endpoint endpoint);
+		// Uses recvmmsg where available
+		std::size_t readFromMany(Datagram* datagrams, std::size_t count);
+		// Uses sendmmsg where available.
+		// Returns how many datagrams were sent or rejected before the socket would block
+		std::size_t writeToMany(Datagram* datagrams, std::size_t count);
+		// Returns false on timeout
+		bool waitReadable(std::uint32_t timeout);
+		// Waits on the first 8 bound sockets, returns false on timeout.
+		// In-memory sockets never block
+		static bool WaitReadable(Socket* const* sockets, std::size_t count, std::uint32_t timeout);
 
 		bool bind(Endpoint endpoint);
+		// Binds to an in-memory queue instead of a native socket.
+		// Writes only reach the capture callback
+		bool bindMemory(Endpoint endpoint, std::uint32_t queueSize = 1U << 20);
+		// In-memory sockets only, returns false if the queue is full.
+		bool inject(const void* data, std::size_t size, Endpoint endpoint);
 		bool connect(Endpoint endpoint);
 		void close();
 
@@ -69,7 +127,15 @@ namespace ReliableUDP::Networking
 		// timeout == 0: Non blocking
 		void setReadTimeout(std::uint32_t timeout);
 		void setNonBlocking();
+		// Needs SO_REUSEPORT
+		void setReusePort(bool reusePort);
+		// Kernel buffer sizes in bytes. Sizes below the system default are ignored, the system may cap larger ones
+		void setBufferSizes(std::uint32_t receiveSize, std::uint32_t sendSize);
+		// Sets Don't-Fragment on IPv4 and IPv6 datagrams, larger ones than the link allows fail with MessageTooLarge.
+		// Linux ignores the cached path MTU in this mode
+		void setDontFragment(bool dontFragment);
 		void setErrorCallback(ErrorReportCallback callback, void* userData);
+		void setCaptureCallback(CaptureCallback callback, void* captureData);
 
 		auto getType() const { return m_Type; }
 		auto getLocalEndpoint() const { return m_LocalEndpoint; }
@@ -77,16 +143,39 @@ namespace ReliableUDP::Networking
 		auto getWriteTimeout() const { return m_WriteTimeout; }
 		auto getReadTimeout() const { return m_ReadTimeout; }
 		auto isNonBlocking() const { return m_ReadTimeout == 0 || m_WriteTimeout == 0; }
+		auto isReusePort() const { return m_ReusePort; }
+		auto isDontFragment() const { return m_DontFragment; }
+		auto getReceiveBufferSize() const { return m_ReceiveBufferSize; }
+		auto getSendBufferSize() const { return m_SendBufferSize; }
 		auto getSocket() const { return m_Socket; }
-		bool isBound() const { return m_Socket != ~0ULL; }
+		bool isBound() const { return m_Socket != ~0ULL || m_Memory; }
+		bool isMemory() const { return m_Memory != nullptr; }
 		bool isConnected() const { return m_RemoteEndpoint.isValid(); }
 		auto getErrorCallback() const { return m_ErrorCallback; }
 		auto getUserData() const { return m_UserData; }
+		auto getCaptureCallback() const { return m_CaptureCallback; }
+		auto getCaptureData() const { return m_CaptureData; }
 
 	private:
 		void reportError(std::uint32_t errorCode);
 		void reportError(ESocketError error);
 
+		bool isNative() const { return m_Socket != ~0ULL; }
+		void applyBufferSizes();
+		void applyDontFragment(bool isIPv4);
+		void capture(bool sent, Endpoint endpoint, const Buffer* buffers, std::size_t count)
+		{
+			if (m_CaptureCallback)
+				m_CaptureCallback(this, m_CaptureData, sent, endpoint, buffers, count);
+		}
+		void capture(bool sent, Endpoint endpoint, const void* data, std::size_t size)
+		{
+			Buffer buffer { data, size };
+			capture(sent, endpoint, &buffer, 1U);
+		}
+
+		std::size_t readFromMemory(Datagram* datagrams, std::size_t count);
+
 	private:
 		ESocketType m_Type;
 		Endpoint    m_LocalEndpoint;
@@ -96,8 +185,16 @@ namespace ReliableUDP::Networking
 		std::uint32_t m_ReadTimeout;
 
 		std::uintptr_t m_Socket;
+		bool           m_ReusePort { false };
+		bool           m_DontFragment { false };
+		std::uint32_t  m_ReceiveBufferSize { 0U };
+		std::uint32_t  m_SendBufferSize { 0U };
+
+		Utils::SPSCRing* m_Memory { nullptr };
 
 		ErrorReportCallback m_ErrorCallback;
 		void*               m_UserData;
+		CaptureCallback     m_CaptureCallback;
+		void*               m_CaptureData;
 	};
 } // namespace ReliableUDP::Networking
\ No newline at end of file
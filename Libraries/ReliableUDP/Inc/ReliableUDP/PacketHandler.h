@@ -2,14 +2,78 @@
 
 #include "Networking/Socket.h"
 #include "PacketHeader.h"
-#include "Utils/RotatingArray.h"
+#include "PacketStats.h"
+#include "Utils/Clock.h"
+#include "Utils/CongestionController.h"
+#include "Utils/PathMTUSearch.h"
+#include "Utils/BlockAllocator.h"
+#include "Utils/RoundTripEstimator.h"
+#include "Utils/SPSCRing.h"
+#include "Utils/SequenceWindow.h"
+#include "Utils/SlotIndex.h"
+#include "Utils/TimerWheel.h"
 
+#include <atomic>
 #include <chrono>
 #include <random>
+#include <thread>
 
 namespace ReliableUDP
 {
-	using Clock = std::chrono::system_clock;
+	using Clock = Utils::Clock;
+
+	enum class EDelivery : std::uint8_t
+	{
+		Reliable, // Acknowledged and retransmitted until every section arrived
+		Sequenced // Sent once, the receiver drops anything older than the newest sequenced packet it delivered from the peer
+	};
+
+	// Packet IDs are numbered per peer
+	struct PacketKey
+	{
+	public:
+		bool operator==(const PacketKey& other) const = default;
+
+	public:
+		Networking::Endpoint m_Endpoint;
+		std::uint16_t        m_ID { 0U };
+	};
+
+	struct PacketKeyHash
+	{
+	public:
+		static std::uint64_t Hash(const PacketKey& key) { return key.m_Endpoint.hash() + key.m_ID; }
+	};
+
+	// Ordered packets are held by their place in the channel
+	struct HeldPacketKey
+	{
+	public:
+		bool operator==(const HeldPacketKey& other) const = default;
+
+	public:
+		Networking::Endpoint m_Endpoint;
+		std::uint16_t        m_Channel { 0U };
+		std::uint16_t        m_Order { 0U };
+	};
+
+	struct HeldPacketKeyHash
+	{
+	public:
+		static std::uint64_t Hash(const HeldPacketKey& key) { return key.m_Endpoint.hash() + (static_cast<std::uint64_t>(key.m_Channel) << 16 | key.m_Order); }
+	};
+
+	struct ChannelInfo
+	{
+	public:
+		// Lower priorities go first, equal ones take turns of m_Weight sections
+		std::uint8_t m_Priority { 0U };
+		std::uint8_t m_Weight { 1U };
+		// Reliable packets reach the receiver's callback in the order they were marked ready
+		bool m_Ordered { false };
+		// One parity section every m_ParityGroup sections, 0 for none
+		std::uint8_t m_ParityGroup { 0U };
+	};
 
 	struct ReadPacketInfo
 	{
@@ -18,74 +82,265 @@ namespace ReliableUDP
 		std::uint16_t        m_Rev { 0U };
 		std::uint32_t        m_Start { ~0U };
 		std::uint32_t        m_Size { 0U };
+		std::uint32_t        m_SectionSize { 0U };
 		Networking::Endpoint m_Endpoint;
+		std::uint32_t        m_Peer { ~0U };
+		EDelivery            m_Delivery { EDelivery::Reliable };
+		std::uint16_t        m_Channel { 0U };
+		std::uint16_t        m_Order { 0U };
+		std::uint8_t         m_ParityGroup { 0U };
+		bool                 m_Ordered { false };
+		// Complete, but waiting for an earlier ordered packet of the channel
+		bool m_Held { false };
+		bool m_Coalesced { false };
+		// Streamed packets only hold a window of m_StreamWindow sections
+		bool          m_Stream { false };
+		std::uint32_t m_StreamWindow { 0U };
+		std::uint32_t m_StreamBase { 0U };
 		union
 		{
 			std::uint32_t m_Bits { 0U };
 			std::uint8_t* m_BitsDynamic;
 		};
+		// Range of sections waiting to be acknowledged, m_AckStart == ~0U if none
+		std::uint32_t     m_AckStart { ~0U };
+		std::uint32_t     m_AckEnd { 0U };
 		Clock::time_point m_Time {};
 	};
 
+	// Sections come from m_Data if set, m_Read otherwise
+	struct StreamSource
+	{
+	public:
+		// Called once per section in order, returning false aborts the stream
+		using ReadCallback = bool (*)(void* userData, std::uint32_t offset, std::uint8_t* buffer, std::uint32_t size);
+		// delivered is set if the peer acknowledged the whole stream
+		using DoneCallback = void (*)(void* userData, bool delivered);
+
+	public:
+		// Has to stay valid until m_Done is called
+		const std::uint8_t* m_Data { nullptr };
+		ReadCallback        m_Read { nullptr };
+		DoneCallback        m_Done { nullptr };
+		void*               m_UserData { nullptr };
+	};
+
 	struct WritePacketInfo
 	{
 	public:
-		EPacketHeaderType    m_Type { EPacketHeaderType::Normal };
-		std::uint16_t        m_ID { 0U };
-		std::uint32_t        m_Index : 20 { 0U };
-		std::uint32_t        m_Rev : 12 { 0U };
-		std::uint32_t        m_Start { ~0U };
-		std::uint32_t        m_Size { 0U };
+		EPacketHeaderType m_Type { EPacketHeaderType::Normal };
+		// Local handle, normal packets take m_Sequence from the peer on their first send
+		std::uint16_t m_ID { 0U };
+		std::uint16_t m_Sequence { 0U };
+		std::uint32_t m_Index : 20 { 0U };
+		std::uint32_t m_Rev : 12 { 0U };
+		std::uint32_t m_Start { ~0U };
+		std::uint32_t m_Size { 0U };
+		// Only valid once the packet was first sent
+		std::uint32_t        m_SectionSize { 0U };
 		Networking::Endpoint m_Endpoint;
+		EDelivery            m_Delivery { EDelivery::Reliable };
+		std::uint16_t        m_Channel { 0U };
+		std::uint16_t        m_Order { 0U };
+		std::uint8_t         m_ParityGroup { 0U };
+		bool                 m_Ordered { false };
 		bool                 m_Ready { false };
+		// Messages get appended while m_Coalescing is set
+		bool m_Coalesced { false };
+		bool m_Coalescing { false };
 		union
 		{
 			std::uint32_t m_Bits { 0U };
 			std::uint8_t* m_BitsDynamic;
 		};
 		Clock::time_point m_Time {};
+		std::uint32_t     m_SendIndex { 0U };
+		std::uint32_t     m_InFlight { 0U };
+		std::uint32_t     m_Peer { ~0U };
+		// ~0U while not in the send list
+		std::uint32_t m_SendListIndex { ~0U };
+		// m_RetransmitTime is zero until every section went out once
+		Clock::time_point m_SendTime {};
+		Clock::time_point m_RetransmitTime {};
+		std::uint32_t     m_SampleIndex { 0U };
+		std::uint32_t     m_Retransmissions { 0U };
+		Clock::time_point m_ReadyTime {};
+
+		// Streams send from m_Source, the write buffer only holds a window for read callbacks
+		// m_StreamWindow is in bytes until the section size is picked, in sections after
+		bool          m_Stream { false };
+		StreamSource  m_Source;
+		std::uint32_t m_StreamWindow { 0U };
+		std::uint32_t m_StreamBase { 0U };
+		std::uint32_t m_StreamLoaded { 0U };
+		std::uint32_t m_StreamResent { 0U };
+	};
+
+	struct PeerChannelInfo
+	{
+	public:
+		std::uint16_t m_SendOrder { 0U };
+		std::uint16_t m_ReceiveOrder { 0U };
+
+		// 12 bit sequence numbers of sequenced packets
+		std::uint16_t     m_SendSequence { 0U };
+		std::uint16_t     m_ReceiveSequence { 0U };
+		Clock::time_point m_ReceiveTime {};
+		// Newest sequenced packet still queued or being received, checked on use since the slot may have been freed
+		std::uint32_t m_SequencedWriteSlot { ~0U };
+		std::uint32_t m_SequencedReadSlot { ~0U };
+	};
+
+	struct PeerInfo
+	{
+	public:
+		Networking::Endpoint        m_Endpoint;
+		Networking::SocketAddress   m_Address;
+		Utils::RoundTripEstimator   m_RoundTrip;
+		Utils::CongestionController m_Congestion;
+		Clock::time_point           m_LastSeen {};
+		Clock::time_point           m_LastRefill {};
+		Clock::time_point           m_LastLoss {};
+
+		// 0 until the peer answered the MaxSize request
+		std::uint32_t        m_MaxDatagramSize { 0U };
+		std::uint32_t        m_MaxPacketSize { 0U };
+		Utils::PathMTUSearch m_PathMTU;
+		std::uint32_t        m_ProbeSize { 0U };
+		std::uint32_t        m_RequestCount { 0U };
+		Clock::time_point    m_RequestTime {};
+		bool                 m_Sending { false };
+
+		PeerChannelInfo m_Channels[s_MaxChannels];
+		// Only valid while that slot is still coalescing
+		std::uint32_t m_CoalesceSlots[s_MaxChannels] {};
+		// Counts up from a random start, skipping 0
+		std::uint16_t m_SendPacketID { 1U };
+		// Retransmits of handled packets only get acknowledged again
+		Utils::SequenceWindow m_HandledPacketIDs;
+		Clock::time_point     m_HandledPacketTime {};
+
+		// Read and write slots using the peer, unused peers are linked from oldest to newest
+		std::uint32_t m_Slots { 0U };
+		std::uint32_t m_Older { ~0U };
+		std::uint32_t m_Newer { ~0U };
+
+		PeerStats m_Stats;
 	};
 
 	struct PacketHandler
 	{
 	public:
+		// packet is only valid during the call
 		using HandleCallback = void (*)(ReliableUDP::PacketHandler* handler, ReliableUDP::Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size);
+		// Streamed packet parts in order, complete once offset + size == totalSize
+		// packet is nullptr if it timed out after offset bytes
+		using StreamCallback = void (*)(ReliableUDP::PacketHandler* handler, ReliableUDP::Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t offset, std::uint8_t* packet, std::uint32_t size, std::uint32_t totalSize);
 
 	public:
-		// ESP32 example: 45056, 45056, 64, 64, 8
-		PacketHandler(std::uint32_t readBufferSize, std::uint32_t writeBufferSize, std::uint32_t maxReadPackets, std::uint32_t maxWritePackets, std::uint32_t sendCount, HandleCallback handleCallback, void* userData);
+		// ESP32 example: 45056, 45056, 64, 64, 8, ..., 1
+		// sendCount: Sections per peer every sendout timer with ECongestionControl::Fixed
+		// batchSize: Max datagrams per socket call
+		// maxDatagramSize: Largest datagram sent or received
+		PacketHandler(std::uint32_t readBufferSize, std::uint32_t writeBufferSize, std::uint32_t maxReadPackets, std::uint32_t maxWritePackets, std::uint32_t sendCount, HandleCallback handleCallback, void* userData, std::uint32_t batchSize = 16U, std::uint32_t maxDatagramSize = 4096U);
 		~PacketHandler();
 
 		void updatePackets();
+		// Sleeps until the socket is readable or the next deadline, at most timeout seconds
+		void waitAndUpdate(float timeout);
+		// Clock::time_point::max() if nothing is pending
+		Clock::time_point getNextDeadline(Clock::time_point now) const;
+
+		// Moves the socket onto a network thread talking to one application thread through lock-free rings.
+		// Until stopThread only sendPacket, handleReceivedPackets and the getters may be used.
+		// receiveRingSize == 0: The callbacks run on the network thread instead
+		bool startThread(std::uint32_t receiveRingSize = 1U << 20, std::uint32_t sendRingSize = 1U << 20);
+		void stopThread();
+		bool isThreaded() const { return m_Thread.joinable(); }
+		bool isNetworkThread() const { return std::this_thread::get_id() == m_Thread.get_id(); }
+		auto getThreadHandle() { return m_Thread.native_handle(); }
+		// Returns how many packets got handled
+		std::uint32_t handleReceivedPackets();
+		// Returns false if there is no room for the packet or it is too large for the peer.
+		// When threaded too large packets only show up in PacketStats::m_OversizedPackets,
+		// calls from the network thread skip the send ring
+		bool sendPacket(Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery = EDelivery::Reliable, std::uint16_t channel = 0U);
+		// Sends size reliable bytes pulled from the source as sections go out.
+		// A read callback gets a window of windowSize bytes, about what is sent per round trip.
+		// Not while the network thread runs, returns 0 if there is no room
+		std::uint16_t sendStream(Networking::Endpoint endpoint, std::uint32_t size, const StreamSource& source, std::uint16_t channel = 0U, std::uint32_t windowSize = 1U << 15);
 
 		std::uint32_t availableReadPackets() const;
 		std::uint32_t availableWritePackets() const;
 		std::uint32_t availableReadPacketSize() const;
 		std::uint32_t availableWritePacketSize() const;
 
-		std::uint8_t* getReadPacket(std::uint16_t id, std::uint32_t& size);
+		std::uint8_t* getReadPacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t& size);
 		std::uint8_t* getWritePacket(std::uint16_t id, std::uint32_t& size);
-		void          markWritePacketReady(std::uint16_t id);
-		void          setPacketEndpoint(std::uint16_t id, Networking::Endpoint endpoint);
-		void          freeReadPacket(std::uint16_t id);
-		void          freeWritePacket(std::uint16_t id);
+		// Sequenced packets replace the one still queued for the endpoint and channel.
+		// Ordered packets need their endpoint set first. Frees the packet and returns false if it is too large for the peer
+		bool markWritePacketReady(std::uint16_t id);
+		void setPacketEndpoint(std::uint16_t id, Networking::Endpoint endpoint);
+		void freeReadPacket(Networking::Endpoint endpoint, std::uint16_t id);
+		void freeWritePacket(std::uint16_t id);
 
-		[[nodiscard]] std::uint8_t* allocateReadPacket(std::uint32_t size, std::uint16_t id, std::uint16_t rev, Networking::Endpoint endpoint);
-		[[nodiscard]] std::uint8_t* allocateWritePacket(std::uint32_t size, std::uint16_t& id);
+		[[nodiscard]] std::uint8_t* allocateReadPacket(std::uint32_t size, std::uint16_t id, std::uint16_t rev, Networking::Endpoint endpoint, std::uint32_t sectionSize);
+		[[nodiscard]] std::uint8_t* allocateWritePacket(std::uint32_t size, std::uint16_t& id, EDelivery delivery = EDelivery::Reliable, std::uint16_t channel = 0U);
 
-		void acknowledgePacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint16_t index, std::uint16_t rev);
+		void acknowledgePacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t index, std::uint16_t rev);
+		void flushAcknowledges();
 		void rejectPacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint16_t rev);
 		void sendMaxSizePacket(Networking::Endpoint endpoint, std::uint16_t id);
+		void requestMaxSize(Networking::Endpoint endpoint);
 
-		bool hasHandledSection(std::uint16_t id, std::uint32_t index, std::uint16_t rev);
-		bool receivedSection(std::uint16_t id, std::uint32_t index, std::uint16_t rev);
-		bool readPacketDone(std::uint16_t id);
+		bool hasHandledSection(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t index, std::uint16_t rev);
+		bool receivedSection(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t index, std::uint16_t rev, const std::uint8_t* section, std::uint32_t dataSize);
+		bool readPacketDone(Networking::Endpoint endpoint, std::uint16_t id);
 
 		std::uint16_t newPacketID();
 		bool          hasUsedPacketID(std::uint16_t id) const;
-		bool          hasHandledPacketID(std::uint16_t id) const;
+		// Within the last SequenceWindow::s_Size IDs
+		bool hasHandledPacketID(Networking::Endpoint endpoint, std::uint16_t id) const;
+
+		std::uint32_t getRequiredSections(std::uint32_t size, std::uint32_t sectionSize) const;
+		// Grows once the peer answered the MaxSize request or a probe
+		std::uint32_t getSectionSize(Networking::Endpoint endpoint) const;
+
+		const Utils::RoundTripEstimator*   getRoundTrip(Networking::Endpoint endpoint) const;
+		const Utils::CongestionController* getCongestion(Networking::Endpoint endpoint) const;
+
+		// Resets the congestion state of every known peer
+		void setCongestionControl(Utils::ECongestionControl control);
+		auto getCongestionControl() const { return m_CongestionControl; }
+
+		// Only affects packets marked ready afterwards
+		void               setChannel(std::uint16_t channel, std::uint8_t priority, std::uint8_t weight = 1U, bool ordered = false);
+		void               setChannelParity(std::uint16_t channel, std::uint8_t parityGroup);
+		const ChannelInfo& getChannel(std::uint16_t channel) const { return m_Channels[channel < s_MaxChannels ? channel : 0U]; }
+
+		// Packs reliable messages per endpoint and channel into packets of up to maxSize bytes.
+		// A packet goes out when full or delay seconds after its first message, 0 disables it
+		void setCoalescing(std::uint32_t maxSize, float delay = 0.001f);
+		auto getCoalescingSize() const { return m_CoalesceSize; }
+		auto getCoalescingDelay() const { return m_CoalesceDelay; }
+		void flushCoalescedPackets();
+
+		// Reliable packets of at least minSize bytes go to the callback part by part,
+		// sections more than windowSize bytes ahead are dropped unacknowledged.
+		// Ordered and coalesced packets are never streamed
+		void setStreamReceive(StreamCallback callback, std::uint32_t minSize, std::uint32_t windowSize = 1U << 16);
+		auto getStreamCallback() const { return m_StreamCallback; }
+		auto getStreamMinSize() const { return m_StreamMinSize; }
 
-		std::uint32_t getRequiredSections(std::uint32_t size) const;
+		// Safe from any thread
+		PacketStats getStats() const { return m_Stats; }
+		// Only safe on the thread running updatePackets
+		bool getPeerStats(Networking::Endpoint endpoint, PeerStats& stats) const;
+
+		// Probes every peer for the largest datagram that is not fragmented.
+		// Sets Don't-Fragment on the socket while probing
+		void setPathProbing(bool probing);
+		auto isPathProbing() const { return m_PathProbing; }
 
 		auto& getSocket() { return m_Socket; }
 		auto& getSocket() const { return m_Socket; }
@@ -97,39 +352,183 @@ namespace ReliableUDP
 		auto  getReadPacketInfos() const { return m_ReadPacketInfos; }
 		auto  getMaxWritePackets() const { return m_MaxWritePackets; }
 		auto  getWritePacketInfos() const { return m_WritePacketInfos; }
-		auto& getUsedPacketIDs() const { return m_UsedPacketIDs; }
-		auto& getHandledPacketIDs() const { return m_HandledPacketIDs; }
+		auto  getBatchSize() const { return m_BatchSize; }
+		auto  getMaxDatagramSize() const { return m_MaxDatagramSize; }
+		auto  getMaxPeers() const { return m_MaxPeers; }
+		auto  getPeerInfos() const { return m_PeerInfos; }
 		auto  getHandleCallback() const { return m_HandleCallback; }
 		auto  getUserData() const { return m_UserData; }
 
+	private:
+		void handleDatagram(std::uint8_t* data, std::size_t size, Networking::Endpoint endpoint);
+		void handleSequencedSection(PeerInfo& peer, const PacketHeader& header, std::uint8_t* section, std::uint32_t dataSize, Clock::time_point now);
+		bool isSequenceNewer(const PeerChannelInfo& channel, std::uint16_t sequence, Clock::time_point now) const;
+		// Holds the packet while an earlier ordered one is missing
+		void deliverReadSlot(std::uint32_t slot);
+		// Returns false if another packet is already held in the same place
+		bool holdReadSlot(std::uint32_t slot);
+		void deliverHeldPackets(PeerInfo& peer, std::uint16_t channel);
+		void deliverStreamSections(std::uint32_t slot);
+		bool isStreamed(const PacketHeader& header) const;
+		// False if the receive ring is full
+		[[nodiscard]] bool handOff(Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size, bool coalesced);
+		[[nodiscard]] bool handOffStream(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t offset, std::uint8_t* packet, std::uint32_t size, std::uint32_t totalSize);
+		void               dispatchPacket(Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size, bool coalesced);
+
+		bool queuePacket(Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery, std::uint16_t channel);
+		void flushCoalescedSlot(std::uint32_t slot);
+
+		void threadFunc();
+		void wakeThread();
+		void drainSendRing();
+
+		// Channel, then order, then round robin from m_SendPacket
+		bool          sendsBefore(std::uint32_t lhs, std::uint32_t rhs) const;
+		bool          prepareWritePacket(std::uint32_t slot, Clock::time_point now);
+		std::uint32_t sendSections(std::uint32_t slot, Clock::time_point now, std::uint32_t maxSections);
+		bool          sendParitySection(WritePacketInfo& info, PeerInfo& peer);
+		// Returns the rebuilt section index or ~0U
+		std::uint32_t recoverSection(std::uint32_t slot, std::uint32_t group, std::uint16_t rev, const std::uint8_t* parity, std::uint32_t paritySize);
+		// Rounds up so deadlines never fire early
+		std::uint64_t deadlineTick(Clock::time_point time) const;
+		void          setReadTime(std::uint32_t slot, Clock::time_point time);
+		void          setWriteTime(std::uint32_t slot, Clock::time_point time);
+		// Slots with sections or a reply to send
+		void listWriteSlot(std::uint32_t slot);
+		void unlistWriteSlot(std::uint32_t slot);
+		void waitForRetransmit(std::uint32_t slot);
+
+		// Streams with a window wrap around it
+		const std::uint8_t* sectionData(const WritePacketInfo& info, std::uint32_t index) const;
+		std::uint8_t*       sectionData(const ReadPacketInfo& info, std::uint32_t index) const;
+
+		// Windows idle for a read timeout count as empty
+		Utils::ESequenceState getPacketIDState(const PeerInfo& peer, std::uint16_t id, Clock::time_point now) const;
+		void                  markPacketIDHandled(PeerInfo& peer, std::uint16_t id, Clock::time_point now);
+
+		void flushAcknowledge(std::uint32_t slot);
+		void sendAcknowledgeRange(Networking::Endpoint endpoint, std::uint16_t id, std::uint16_t rev, std::uint32_t first, std::uint32_t last, const ReadPacketInfo* info);
+
+		std::uint8_t* beginDatagram();
+		// The payload is not copied and has to stay valid until flushDatagrams
+		void endDatagram(std::size_t size, Networking::Endpoint endpoint, const void* payload = nullptr, std::size_t payloadSize = 0U);
+		void endDatagram(std::size_t size, const PeerInfo& peer, const void* payload = nullptr, std::size_t payloadSize = 0U);
+		void flushDatagrams();
+
+		std::uint32_t findReadSlot(Networking::Endpoint endpoint, std::uint16_t id) const;
+		std::uint32_t findWriteSlot(std::uint16_t id) const;
+		std::uint32_t findSentSlot(Networking::Endpoint endpoint, std::uint16_t id) const;
+		std::uint32_t acquireReadSlot();
+		std::uint32_t acquireWriteSlot();
+		std::uint8_t* allocateReadBlock(std::uint32_t size, std::uint32_t blockSize, std::uint16_t id, std::uint16_t rev, Networking::Endpoint endpoint, std::uint32_t sectionSize);
+		void          releaseReadSlot(std::uint32_t slot);
+		void          releaseWriteSlot(std::uint32_t slot);
+		void          freeReadSlot(std::uint32_t slot);
+		void          freeWriteSlot(std::uint32_t slot);
+
+		PeerInfo* findPeer(Networking::Endpoint endpoint) const;
+		// Replaces the least recently seen unused peer, nullptr if every peer is used
+		PeerInfo* acquirePeer(Networking::Endpoint endpoint);
+		PeerInfo& packetPeer(WritePacketInfo& info);
+		void      usePeer(std::uint32_t peer);
+		void      unusePeer(std::uint32_t peer);
+		void      touchPeer(PeerInfo& peer, Clock::time_point now);
+		void      peerLost(PeerInfo& peer, Clock::time_point now);
+		void      linkPeer(std::uint32_t peer);
+		void      unlinkPeer(std::uint32_t peer);
+		// Sends the due MaxSize request or path probe
+		void          updatePeer(PeerInfo& peer, Clock::time_point now);
+		void          schedulePeer(const PeerInfo& peer, Clock::time_point time);
+		void          peerMaxSize(PeerInfo& peer, std::uint32_t maxPacketSize, std::uint32_t maxDatagramSize);
+		std::uint32_t peerDatagramSize(const PeerInfo& peer) const;
+		bool          fitsPeer(const PeerInfo* peer, std::uint32_t size) const;
+		std::uint32_t maxReadPacketSize() const;
+
 	private:
 		Networking::Socket m_Socket;
 
 		std::uint32_t m_ReadBufferSize;
 		std::uint32_t m_WriteBufferSize;
-		std::uint32_t m_UsedReadBufferSize;
-		std::uint32_t m_UsedWriteBufferSize;
 		std::uint8_t* m_ReadBuffer;
 		std::uint8_t* m_WriteBuffer;
 
+		// The first 4096 bytes of each buffer are scratch space
+		Utils::BlockAllocator m_ReadAllocator;
+		Utils::BlockAllocator m_WriteAllocator;
+
 		std::uint32_t    m_MaxReadPackets;
 		std::uint32_t    m_MaxWritePackets;
 		ReadPacketInfo*  m_ReadPacketInfos;
 		WritePacketInfo* m_WritePacketInfos;
+		std::uint32_t*   m_FreeReadSlots;
+		std::uint32_t*   m_FreeWriteSlots;
+		std::uint32_t    m_FreeReadSlotCount;
+		std::uint32_t    m_FreeWriteSlotCount;
+		std::uint32_t*   m_PendingAcks;
+		std::uint32_t    m_PendingAckCount { 0U };
 		std::uint32_t    m_SendPacket { 0U };
-		std::uint32_t    m_SendIndex { 0U };
-		std::uint32_t    m_ToSend;
 		std::uint32_t    m_SendCount;
+		std::uint32_t*   m_SendQueue;
+		std::uint32_t*   m_SendList;
+		std::uint32_t    m_SendListCount { 0U };
+		bool             m_SendPending { false };
+		std::uint32_t    m_ReadyPackets { 0U };
+
+		ChannelInfo   m_Channels[s_MaxChannels];
+		std::uint16_t m_ChannelOrder[s_MaxChannels];
+
+		std::uint32_t              m_BatchSize;
+		std::uint32_t              m_MaxDatagramSize;
+		std::uint8_t*              m_ReceiveBatch;
+		std::uint8_t*              m_SendBatch;
+		Networking::Datagram*      m_ReceiveDatagrams;
+		Networking::Datagram*      m_SendDatagrams;
+		Networking::SocketAddress* m_SendAddresses;
+		std::uint32_t              m_SendDatagramCount { 0U };
 
-		Utils::RotatingArray<std::uint16_t, 16U> m_UsedPacketIDs;
-		Utils::RotatingArray<std::uint16_t, 16U> m_HandledPacketIDs;
+		std::uint32_t                                                    m_MaxPeers;
+		PeerInfo*                                                        m_PeerInfos;
+		Utils::SlotIndex<Networking::Endpoint, Networking::EndpointHash> m_PeerIndex;
+		// Peers used by no slot, the oldest gets replaced when full
+		std::uint32_t m_OldestPeer { ~0U };
+		std::uint32_t m_NewestPeer { ~0U };
+
+		// Only reliable packets are indexed, replies are never looked up
+		Utils::SlotIndex<PacketKey, PacketKeyHash> m_ReadPacketIndex;
+		Utils::SlotIndex<std::uint16_t>            m_WritePacketIndex;
+		Utils::SlotIndex<PacketKey, PacketKeyHash> m_SentPacketIndex;
+		std::uint16_t                              m_NextPacketID { 1U };
+		// Held ordered packets, so the next one in order is found without a scan
+		Utils::SlotIndex<HeldPacketKey, HeldPacketKeyHash> m_HeldPacketIndex;
+
+		// Read slot timeouts, write slot timeouts, write slot send timers, then peer timers
+		Utils::TimerWheel m_Timers;
+		Clock::time_point m_TimerStart { Clock::now() };
+		// A complete packet found the receive ring full
+		bool m_RetryHeld { false };
 
 		HandleCallback m_HandleCallback;
 		void*          m_UserData;
+		StreamCallback m_StreamCallback { nullptr };
+		std::uint32_t  m_StreamMinSize { 0U };
+		std::uint32_t  m_StreamWindowSize { 1U << 16 };
+
+		Utils::ECongestionControl m_CongestionControl { Utils::ECongestionControl::AIMD };
+		bool                      m_PathProbing { false };
+		PacketStats               m_Stats;
+		std::uint32_t             m_CoalesceSize { 0U };
+		float                     m_CoalesceDelay { 0.001f };
+
+		// Only set while the network thread runs
+		std::thread        m_Thread;
+		std::atomic<bool>  m_Running { false };
+		std::atomic<bool>  m_WakePending { false };
+		Networking::Socket m_WakeSocket { Networking::ESocketType::UDP, 0U, 0U };
+		Utils::SPSCRing*   m_ReceiveRing { nullptr };
+		Utils::SPSCRing*   m_SendRing { nullptr };
 
-		Clock::time_point m_LastSendout;
-		float             m_ReadTimeout { 2.0f };
-		float             m_WriteTimeout { 2.0f };
-		float             m_SendoutTimer { 0.1f };
+		float m_ReadTimeout { 2.0f };
+		float m_WriteTimeout { 2.0f };
+		float m_SendoutTimer { 0.1f };
 	};
 } // namespace ReliableUDP
\ No newline at end of file
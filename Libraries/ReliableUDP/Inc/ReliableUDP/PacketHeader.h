@@ -4,7 +4,9 @@
 
 namespace ReliableUDP
 {
-	static constexpr std::uint16_t s_MagicNumber = 0x2FDE;
+	// Changes whenever the header layout does, 14 bits
+	static constexpr std::uint16_t s_MagicNumber = 0x35A1;
+	static constexpr std::uint16_t s_MaxChannels = 8U;
 
 	enum class EPacketHeaderType : std::uint8_t
 	{
@@ -14,6 +16,25 @@ namespace ReliableUDP
 		MaxSize     = 0b11
 	};
 
+	enum class EMaxSizeProbe : std::uint16_t
+	{
+		None     = 0, // m_Size == 0 asks for the max packet size, anything else is the reply
+		Probe    = 1, // Padded to m_DatagramSize bytes, answered with ProbeAck if it arrived in one piece
+		ProbeAck = 2
+	};
+
+	namespace PacketFlag
+	{
+		// Never acknowledged, m_Rev carries the sequence number
+		static constexpr std::uint16_t Unreliable = 1U;
+		// Delivered in m_Order order
+		static constexpr std::uint16_t Ordered = 2U;
+		// XOR of the data sections of group m_Index
+		static constexpr std::uint16_t Parity = 4U;
+		// Small messages, each prefixed with its 16 bit size
+		static constexpr std::uint16_t Coalesced = 8U;
+	} // namespace PacketFlag
+
 	struct PacketHeader
 	{
 	public:
@@ -22,6 +43,12 @@ namespace ReliableUDP
 		std::uint32_t m_Index : 20;
 		std::uint32_t m_Rev : 12;
 		std::uint32_t m_Size;
+		// Every section but the last carries exactly m_SectionSize bytes
+		std::uint16_t m_SectionSize;
+		std::uint16_t m_Flags { 0U };
+		std::uint8_t  m_Channel { 0U };
+		std::uint8_t  m_ParityGroup { 0U };
+		std::uint16_t m_Order { 0U };
 	};
 
 	struct AcknowledgePacketHeader
@@ -33,6 +60,18 @@ namespace ReliableUDP
 		std::uint32_t m_Rev : 12;
 	};
 
+	// Followed by a bitmap where bit i is section m_Index + i.
+	// Uses the Acknowledge type, told apart by its size
+	struct AcknowledgeRangePacketHeader
+	{
+	public:
+		std::uint16_t m_MagicNumber { s_MagicNumber | 0b01 << 14 };
+		std::uint16_t m_ID;
+		std::uint32_t m_Index : 20;
+		std::uint32_t m_Rev : 12;
+		std::uint32_t m_Count;
+	};
+
 	struct RejectPacketHeader
 	{
 	public:
@@ -48,6 +87,8 @@ namespace ReliableUDP
 		std::uint16_t m_MagicNumber { s_MagicNumber | 0b11 << 14 };
 		std::uint16_t m_ID;
 		std::uint32_t m_Size;
+		std::uint16_t m_DatagramSize { 0U };
+		EMaxSizeProbe m_Probe { EMaxSizeProbe::None };
 	};
 
 	bool              IsMagicNumberValid(std::uint16_t magicNumber);
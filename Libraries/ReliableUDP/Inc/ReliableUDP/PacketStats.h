@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Utils/Metrics.h"
+
+namespace ReliableUDP
+{
+	// Transport counters of a PacketHandler, written by the thread running updatePackets
+	struct PacketStats
+	{
+	public:
+		Utils::Counter m_DatagramsSent;
+		Utils::Counter m_DatagramsReceived;
+		Utils::Counter m_BytesSent;
+		Utils::Counter m_BytesReceived;
+		// Refused by the socket or left over when its send buffer filled up
+		Utils::Counter m_DatagramsDropped;
+
+		Utils::Counter m_SectionsSent;
+		Utils::Counter m_SectionsRetransmitted;
+		Utils::Counter m_SectionsReceived;
+		Utils::Counter m_DuplicateSections;
+		// Dropped for arriving too far ahead of a stream's window
+		Utils::Counter m_SectionsPastWindow;
+		Utils::Counter m_ParitySent;
+		Utils::Counter m_SectionsRecovered;
+		Utils::Counter m_AcknowledgesSent;
+		Utils::Counter m_AcknowledgesReceived;
+
+		Utils::Counter m_PacketsAcknowledged;
+		Utils::Counter m_PacketsDelivered;
+		Utils::Counter m_RejectsSent;
+		Utils::Counter m_RejectsReceived;
+		Utils::Counter m_ReadTimeouts;
+		Utils::Counter m_WriteTimeouts;
+		Utils::Counter m_StalePackets;
+		// Over the peer's max packet size or 2^20 sections, never sent
+		Utils::Counter m_OversizedPackets;
+		// Datagrams from new peers dropped while every peer was used by a slot
+		Utils::Counter m_PeersExhausted;
+		Utils::Counter m_LossEvents;
+
+		// Refreshed at the end of every updatePackets
+		Utils::Counter m_ReadPacketsUsed;
+		Utils::Counter m_WritePacketsUsed;
+		Utils::Counter m_ReadBufferUsed;
+		Utils::Counter m_WriteBufferUsed;
+		Utils::Counter m_SendQueueDepth;
+		Utils::Counter m_ReceiveRingUsed;
+		Utils::Counter m_SendRingUsed;
+
+		Utils::Histogram m_RoundTrip;
+		Utils::Histogram m_DeliveryLatency;
+	};
+
+	// Starts over when the peer's entry gets reused
+	struct PeerStats
+	{
+	public:
+		Utils::Counter m_SectionsSent;
+		Utils::Counter m_SectionsRetransmitted;
+		Utils::Counter m_PacketsAcknowledged;
+		Utils::Counter m_LossEvents;
+
+		Utils::Histogram m_RoundTrip;
+		Utils::Histogram m_DeliveryLatency;
+	};
+} // namespace ReliableUDP
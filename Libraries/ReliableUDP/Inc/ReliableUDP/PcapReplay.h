@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Networking/Pcap.h"
+#include "PacketHandler.h"
+
+namespace ReliableUDP
+{
+	// Feeds the datagrams a capture holds for one endpoint back into a PacketHandler.
+	// Recorded gaps are divided by the speed, 0 feeds them as fast as possible.
+	// The handler's timeouts only line up with the capture at a speed of 1
+	struct PcapReplay
+	{
+	public:
+		PcapReplay(PacketHandler& handler, float speed = 1.0f);
+		PcapReplay(const PcapReplay&) = delete;
+		~PcapReplay();
+
+		PcapReplay& operator=(const PcapReplay&) = delete;
+
+		// The handler must be unbound and not threaded
+		bool open(std::string_view path, Networking::Endpoint endpoint, std::uint32_t queueSize = 1U << 20);
+		void close();
+
+		// Returns false once the capture is used up
+		bool step();
+		void run();
+
+		// Clock::time_point::max() once the capture is used up
+		Clock::time_point getNextTime() const;
+
+		auto getSpeed() const { return m_Speed; }
+		auto getInjected() const { return m_Injected; }
+
+	private:
+		void readNext();
+
+	private:
+		PacketHandler& m_Handler;
+		float          m_Speed;
+
+		Networking::PcapReader m_Reader;
+		Networking::Endpoint   m_Endpoint;
+		bool                   m_AnyAddress { false };
+
+		Networking::PcapRecord m_Next;
+		bool                   m_HasNext { false };
+
+		std::uint64_t     m_FirstTime { 0U };
+		Clock::time_point m_Start;
+		bool              m_Started { false };
+
+		std::uint64_t m_Injected { 0U };
+	};
+} // namespace ReliableUDP
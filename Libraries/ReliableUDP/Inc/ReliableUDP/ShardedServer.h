@@ -0,0 +1,81 @@
+#pragma once
+
+#include "PacketHandler.h"
+
+#include <mutex>
+
+namespace ReliableUDP
+{
+	// Runs one threaded PacketHandler per core on SO_REUSEPORT sockets.
+	// The kernel keeps a peer on one socket, so its state stays on one shard
+	struct ShardedServer
+	{
+	public:
+		// Called on the shard's network thread
+		using HandleCallback = void (*)(ReliableUDP::ShardedServer* server, std::uint32_t shard, ReliableUDP::Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size);
+
+	public:
+		// The limits apply to every shard, inboxSize is the size of each shard's send ring
+		ShardedServer(std::uint32_t shardCount, std::uint32_t readBufferSize, std::uint32_t writeBufferSize, std::uint32_t maxReadPackets, std::uint32_t maxWritePackets, std::uint32_t sendCount, HandleCallback handleCallback, void* userData, std::uint32_t batchSize = 16U, std::uint32_t maxDatagramSize = 4096U, std::uint32_t inboxSize = 1U << 20);
+		ShardedServer(const ShardedServer&) = delete;
+		~ShardedServer();
+
+		ShardedServer& operator=(const ShardedServer&) = delete;
+
+		// Binds every shard's socket and starts their threads.
+		// Fails for more than one shard without SO_REUSEPORT
+		bool start(Networking::Endpoint endpoint, bool pinThreads = true);
+		void stop();
+		bool isRunning() const { return m_Running.load(); }
+
+		// Can be called from any thread.
+		// Returns false if the inbox or write buffer is full, the peer is unknown or the server is stopped
+		bool post(Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery = EDelivery::Reliable, std::uint16_t channel = 0U);
+		bool post(std::uint32_t shard, Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery = EDelivery::Reliable, std::uint16_t channel = 0U);
+
+		// ~0U if no shard heard from the endpoint, never blocks
+		std::uint32_t findShard(Networking::Endpoint endpoint) const;
+
+		// Only safe on the shard's own thread while running
+		PacketHandler& getShard(std::uint32_t shard) { return *m_Shards[shard].m_Handler; }
+
+		auto getShardCount() const { return m_ShardCount; }
+		auto getHandleCallback() const { return m_HandleCallback; }
+		auto getUserData() const { return m_UserData; }
+
+	private:
+		using PeerIndex = Utils::SlotIndex<Networking::Endpoint, Networking::EndpointHash>;
+
+		struct Shard
+		{
+		public:
+			ShardedServer* m_Server { nullptr };
+			std::uint32_t  m_Index { 0U };
+			PacketHandler* m_Handler { nullptr };
+
+			// Other threads share the handler's single producer send ring
+			std::mutex m_SendMutex;
+
+			// Left-right copies: the shard's thread only writes the one without readers, then publishes it
+			PeerIndex*                 m_Peers[2] { nullptr, nullptr };
+			std::atomic<std::uint32_t> m_PublishedPeers { 0U };
+			std::atomic<std::uint32_t> m_PeerReaders[2] {};
+		};
+
+		static void HandlePacket(PacketHandler* handler, Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size);
+
+		void recordPeer(Shard& shard, Networking::Endpoint endpoint);
+		void insertPeer(Shard& shard, PeerIndex& peers, Networking::Endpoint endpoint);
+
+	private:
+		std::uint32_t m_ShardCount;
+		Shard*        m_Shards;
+		std::uint32_t m_PeerCount;
+		std::uint32_t m_InboxSize;
+
+		std::atomic<bool> m_Running { false };
+
+		HandleCallback m_HandleCallback;
+		void*          m_UserData;
+	};
+} // namespace ReliableUDP
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	// Allocates blocks from a fixed piece of memory.
+	// Free ranges are kept per power of two size class and merged when freed
+	struct BlockAllocator
+	{
+	public:
+		static constexpr std::uint32_t s_Invalid    = ~0U;
+		static constexpr std::uint32_t s_Alignment  = 8U;
+		static constexpr std::uint32_t s_HeaderSize = 8U;
+
+	public:
+		BlockAllocator(std::uint8_t* memory, std::uint32_t size);
+
+		// Returns s_Invalid if no free range is large enough
+		[[nodiscard]] std::uint32_t allocate(std::uint32_t size);
+		void                        free(std::uint32_t offset);
+
+		std::uint32_t largestAllocation() const;
+
+		auto getMemory() const { return m_Memory; }
+		auto getSize() const { return m_Size; }
+		auto getUsed() const { return m_Used; }
+
+	private:
+		static constexpr std::uint32_t s_Classes  = 32U;
+		static constexpr std::uint32_t s_MinBlock = s_HeaderSize + 8U;
+
+		// The low bit of m_Size marks the block as free
+		struct BlockHeader
+		{
+		public:
+			std::uint32_t m_Size;
+			std::uint32_t m_PrevSize;
+		};
+
+		// Stored in the payload of free blocks
+		struct FreeLinks
+		{
+		public:
+			std::uint32_t m_Next;
+			std::uint32_t m_Prev;
+		};
+
+		BlockHeader* header(std::uint32_t block) const { return reinterpret_cast<BlockHeader*>(m_Memory + block); }
+		FreeLinks*   links(std::uint32_t block) const { return reinterpret_cast<FreeLinks*>(m_Memory + block + s_HeaderSize); }
+
+		void link(std::uint32_t block, std::uint32_t size);
+		void unlink(std::uint32_t block, std::uint32_t size);
+
+	private:
+		std::uint8_t* m_Memory;
+		std::uint32_t m_Size;
+		std::uint32_t m_Used;
+		std::uint32_t m_ClassMask;
+		std::uint32_t m_FreeLists[s_Classes];
+	};
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <chrono>
+
+namespace ReliableUDP::Utils
+{
+	// steady_clock, unless the calling thread set a source
+	struct Clock
+	{
+	public:
+		using rep        = std::chrono::steady_clock::rep;
+		using period     = std::chrono::steady_clock::period;
+		using duration   = std::chrono::steady_clock::duration;
+		using time_point = std::chrono::time_point<Clock>;
+		using Source     = time_point (*)(void* userData);
+
+		static constexpr bool is_steady = true;
+
+	public:
+		static time_point now();
+		// nullptr goes back to steady_clock
+		static void SetSource(Source source, void* userData);
+	};
+} // namespace ReliableUDP::Utils
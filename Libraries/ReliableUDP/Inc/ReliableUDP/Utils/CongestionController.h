@@ -0,0 +1,61 @@
+#pragma once
+
+#include "RoundTripEstimator.h"
+
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	enum class ECongestionControl : std::uint8_t
+	{
+		Fixed, // Up to sendCount sections every sendout timer, ignores loss and delay
+		AIMD,  // Slow start, then additive increase and multiplicative decrease on loss
+		Delay  // Like AIMD, but backs off as soon as the RTT grows past the lowest RTT seen
+	};
+
+	// Congestion window in sections for one peer, paced at window / SRTT.
+	// All times are in seconds.
+	struct CongestionController
+	{
+	public:
+		static constexpr float s_InitialWindow = 10.0f;
+		static constexpr float s_MinWindow     = 2.0f;
+		static constexpr float s_MaxWindow     = 65536.0f;
+		static constexpr float s_PacingGain    = 1.25f;
+		// Delay: TCP Vegas style
+		static constexpr float s_DelayAlpha = 2.0f;
+		static constexpr float s_DelayBeta  = 4.0f;
+
+	public:
+		void reset(ECongestionControl control, std::uint32_t fixedCount, float fixedInterval);
+
+		// rtt is 0 without a usable sample.
+		// Does not touch the in flight count
+		void acknowledged(std::uint32_t sections, float rtt, const RoundTripEstimator& roundTrip);
+		// Report at most one loss per RTT
+		void lost();
+
+		void refill(float elapsed, const RoundTripEstimator& roundTrip);
+		bool canSend() const { return m_InFlight < m_Window && m_Tokens >= 1.0f; }
+		void sent();
+		void removeInFlight(std::uint32_t sections) { m_InFlight = sections < m_InFlight ? m_InFlight - sections : 0U; }
+
+		auto  getControl() const { return m_Control; }
+		auto  getWindow() const { return m_Window; }
+		auto  getSlowStartThreshold() const { return m_SlowStartThreshold; }
+		auto  getMinRTT() const { return m_MinRTT; }
+		auto  getInFlight() const { return m_InFlight; }
+		auto  getTokens() const { return m_Tokens; }
+		float getPacingRate(const RoundTripEstimator& roundTrip) const;
+
+	private:
+		ECongestionControl m_Control { ECongestionControl::AIMD };
+		float              m_Window { s_InitialWindow };
+		float              m_SlowStartThreshold { s_MaxWindow };
+		float              m_MinRTT { 0.0f };
+		float              m_Tokens { s_InitialWindow };
+		std::uint32_t      m_InFlight { 0U };
+		std::uint32_t      m_FixedCount { 0U };
+		float              m_FixedInterval { 0.0f };
+	};
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	// Written by a single thread and read from any, so no locked read-modify-writes.
+	struct Counter
+	{
+	public:
+		Counter() = default;
+		Counter(const Counter& other) : m_Value(other.get()) {}
+
+		Counter& operator=(const Counter& other)
+		{
+			set(other.get());
+			return *this;
+		}
+
+		void          add(std::uint64_t value = 1U) { m_Value.store(m_Value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+		void          set(std::uint64_t value) { m_Value.store(value, std::memory_order_relaxed); }
+		std::uint64_t get() const { return m_Value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<std::uint64_t> m_Value { 0U };
+	};
+
+	// Bucket 0 counts samples below 1 us and bucket i samples in [2^(i-1), 2^i) us.
+	struct Histogram
+	{
+	public:
+		static constexpr std::uint32_t s_Buckets = 32U;
+
+	public:
+		// Upper bound of the bucket in seconds
+		static float BucketLimit(std::uint32_t bucket);
+
+		void add(float seconds);
+		void reset();
+
+		std::uint64_t getCount() const;
+		std::uint64_t getBucket(std::uint32_t bucket) const { return m_Buckets[bucket].get(); }
+		// 0 without samples
+		float getPercentile(float fraction) const;
+
+	private:
+		Counter m_Buckets[s_Buckets];
+	};
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	// Datagram packetization layer path MTU discovery (RFC 8899).
+	// Binary search, a size is too large after s_MaxProbes unanswered probes
+	struct PathMTUSearch
+	{
+	public:
+		static constexpr std::uint32_t s_BaseSize  = 1200U;
+		static constexpr std::uint32_t s_MaxProbes = 3U;
+		// Stop once the remaining range is smaller than this many bytes
+		static constexpr std::uint32_t s_MinStep = 32U;
+
+	public:
+		void reset(std::uint32_t maxSize);
+
+		// 0 once the search is done
+		std::uint32_t nextProbe() const;
+		void          probeAcknowledged(std::uint32_t size);
+		void          probeLost(std::uint32_t size);
+
+		bool isDone() const { return nextProbe() == 0U; }
+		auto getSize() const { return m_Low; }
+		auto getMaxSize() const { return m_High; }
+		auto getProbeCount() const { return m_ProbeCount; }
+
+	private:
+		std::uint32_t m_Low { s_BaseSize };
+		std::uint32_t m_High { s_BaseSize };
+		std::uint32_t m_ProbeCount { 0U };
+		bool          m_TriedMax { false };
+	};
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	// RFC 6298, all times are in seconds.
+	struct RoundTripEstimator
+	{
+	public:
+		static constexpr float s_InitialTimeout = 0.1f;
+		static constexpr float s_MinTimeout     = 0.005f;
+		static constexpr float s_MaxTimeout     = 1.0f;
+		static constexpr float s_Granularity    = 0.001f;
+
+	public:
+		void addSample(float rtt);
+		void reset();
+
+		// Doubled per retransmission, clamped to s_MaxTimeout
+		float getBackoffTimeout(std::uint32_t retransmissions) const;
+
+		auto getSmoothedRTT() const { return m_SmoothedRTT; }
+		auto getRTTVariance() const { return m_RTTVariance; }
+		auto getRetransmitTimeout() const { return m_RetransmitTimeout; }
+		auto getSampleCount() const { return m_SampleCount; }
+
+	private:
+		float         m_SmoothedRTT { 0.0f };
+		float         m_RTTVariance { 0.0f };
+		float         m_RetransmitTimeout { s_InitialTimeout };
+		std::uint32_t m_SampleCount { 0U };
+	};
+} // namespace ReliableUDP::Utils
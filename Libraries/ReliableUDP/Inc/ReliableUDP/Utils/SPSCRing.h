@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	// Lock-free FIFO of variable sized records for one producer and one consumer.
+	// Records are contiguous, one that does not fit before the end starts over
+	struct SPSCRing
+	{
+	public:
+		static constexpr std::uint32_t s_Alignment  = 8U;
+		static constexpr std::uint32_t s_HeaderSize = 8U;
+
+	public:
+		// Rounded up to a power of two
+		SPSCRing(std::uint32_t size);
+		SPSCRing(const SPSCRing&) = delete;
+		~SPSCRing();
+
+		SPSCRing& operator=(const SPSCRing&) = delete;
+
+		// Producer only, returns nullptr if there is no room
+		bool                        canReserve(std::uint32_t size) const;
+		[[nodiscard]] std::uint8_t* reserve(std::uint32_t size);
+		void                        commit();
+
+		// Consumer only, the record stays valid until pop
+		std::uint8_t* front(std::uint32_t& size);
+		void          pop();
+
+		auto getSize() const { return m_Size; }
+		// Safe to call from either side
+		std::uint32_t getUsed() const { return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire); }
+
+	private:
+		std::uint32_t requiredSpace(std::uint32_t head, std::uint32_t size) const;
+
+	private:
+		std::uint8_t* m_Memory;
+		std::uint32_t m_Size;
+
+		// Positions wrap around at 2^32
+		alignas(64) std::atomic<std::uint32_t> m_Head { 0U };
+		std::uint32_t m_ReservedHead { 0U };
+		alignas(64) std::atomic<std::uint32_t> m_Tail { 0U };
+		std::uint32_t m_FrontSize { 0U };
+	};
+} // namespace ReliableUDP::Utils
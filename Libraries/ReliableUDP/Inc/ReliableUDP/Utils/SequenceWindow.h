@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	enum class ESequenceState : std::uint8_t
+	{
+		New,     // Ahead of the window or not marked yet
+		Handled, // Marked within the window
+		Stale    // Too far behind the newest sequence number to tell
+	};
+
+	// Anti-replay window over wrapping 16 bit sequence numbers (RFC 4303).
+	// One bit for each of the s_Size sequence numbers up to the newest.
+	struct SequenceWindow
+	{
+	public:
+		static constexpr std::uint32_t s_Size = 1024U;
+
+	public:
+		void reset();
+
+		ESequenceState getState(std::uint16_t sequence) const;
+		// Returns true if the window moved ahead
+		bool mark(std::uint16_t sequence);
+
+		bool isEmpty() const { return m_Empty; }
+		auto getNewest() const { return m_Newest; }
+
+	private:
+		// Bit sequence % s_Size
+		std::uint64_t m_Bits[s_Size / 64U] {};
+		std::uint16_t m_Newest { 0U };
+		bool          m_Empty { true };
+	};
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <bit>
+
+namespace ReliableUDP::Utils
+{
+	// Integer keys are used as their own hash
+	template <class K>
+	struct SlotIndexHash
+	{
+	public:
+		static std::uint64_t Hash(K key) { return static_cast<std::uint64_t>(key); }
+	};
+
+	// Linear probing map from a key to a slot index.
+	// Sized to at least twice the max number of entries.
+	template <class K, class H = SlotIndexHash<K>>
+	struct SlotIndex
+	{
+	public:
+		using key_type  = K;
+		using size_type = std::uint32_t;
+
+		static constexpr size_type s_Invalid = ~0U;
+
+	public:
+		SlotIndex() : m_Capacity(0U), m_Mask(0U), m_Shift(0U), m_Size(0U), m_Keys(nullptr), m_Slots(nullptr) {}
+		SlotIndex(size_type maxEntries)
+		    : m_Capacity(std::bit_ceil<size_type>(maxEntries < 4U ? 8U : maxEntries * 2U)),
+		      m_Mask(m_Capacity - 1U),
+		      m_Shift(64U - static_cast<size_type>(std::countr_zero(m_Capacity))),
+		      m_Size(0U),
+		      m_Keys(new K[m_Capacity]),
+		      m_Slots(new size_type[m_Capacity])
+		{
+			clear();
+		}
+		SlotIndex(const SlotIndex&) = delete;
+		~SlotIndex()
+		{
+			if (m_Keys)
+				delete[] m_Keys;
+			if (m_Slots)
+				delete[] m_Slots;
+			m_Keys  = nullptr;
+			m_Slots = nullptr;
+		}
+
+		SlotIndex& operator=(const SlotIndex&) = delete;
+
+		size_type find(K key) const
+		{
+			if (!m_Capacity)
+				return s_Invalid;
+
+			for (size_type i = bucket(key);; i = (i + 1U) & m_Mask)
+			{
+				if (m_Slots[i] == s_Invalid)
+					return s_Invalid;
+				if (m_Keys[i] == key)
+					return m_Slots[i];
+			}
+		}
+
+		bool contains(K key) const { return find(key) != s_Invalid; }
+
+		// Returns false if the key is already present or the index is full
+		bool insert(K key, size_type slot)
+		{
+			if (m_Size + 1U >= m_Capacity)
+				return false;
+
+			size_type i = bucket(key);
+			for (; m_Slots[i] != s_Invalid; i = (i + 1U) & m_Mask)
+				if (m_Keys[i] == key)
+					return false;
+
+			m_Keys[i]  = key;
+			m_Slots[i] = slot;
+			++m_Size;
+			return true;
+		}
+
+		// Backward shift deletion, no tombstones
+		bool erase(K key)
+		{
+			if (!m_Capacity)
+				return false;
+
+			size_type i = bucket(key);
+			for (;; i = (i + 1U) & m_Mask)
+			{
+				if (m_Slots[i] == s_Invalid)
+					return false;
+				if (m_Keys[i] == key)
+					break;
+			}
+
+			size_type j = i;
+			while (true)
+			{
+				j = (j + 1U) & m_Mask;
+				if (m_Slots[j] == s_Invalid)
+					break;
+
+				size_type home = bucket(m_Keys[j]);
+				if (((j - home) & m_Mask) >= ((j - i) & m_Mask))
+				{
+					m_Keys[i]  = m_Keys[j];
+					m_Slots[i] = m_Slots[j];
+					i          = j;
+				}
+			}
+
+			m_Slots[i] = s_Invalid;
+			--m_Size;
+			return true;
+		}
+
+		void clear()
+		{
+			for (size_type i = 0; i < m_Capacity; ++i)
+			{
+				m_Keys[i]  = K {};
+				m_Slots[i] = s_Invalid;
+			}
+			m_Size = 0U;
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return m_Size == 0U; }
+		size_type          size() const noexcept { return m_Size; }
+		size_type          capacity() const noexcept { return m_Capacity; }
+
+	private:
+		size_type bucket(K key) const
+		{
+			// Fibonacci hashing
+			std::uint64_t value = H::Hash(key) * 0x9E3779B97F4A7C15ULL;
+			return static_cast<size_type>(value >> m_Shift) & m_Mask;
+		}
+
+	private:
+		size_type  m_Capacity;
+		size_type  m_Mask;
+		size_type  m_Shift;
+		size_type  m_Size;
+		K*         m_Keys;
+		size_type* m_Slots;
+	};
+} // namespace ReliableUDP::Utils
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ReliableUDP::Utils
+{
+	// Hierarchical timer wheel over a fixed set of timers identified by index.
+	// Four levels of 64 buckets cover 2^24 ticks ahead
+	struct TimerWheel
+	{
+	public:
+		static constexpr std::uint32_t s_Invalid = ~0U;
+		static constexpr std::uint32_t s_Levels  = 4U;
+		static constexpr std::uint32_t s_Bits    = 6U;
+		static constexpr std::uint32_t s_Buckets = 1U << s_Bits;
+
+	public:
+		TimerWheel(std::uint32_t maxTimers);
+		TimerWheel(const TimerWheel&) = delete;
+		~TimerWheel();
+
+		TimerWheel& operator=(const TimerWheel&) = delete;
+
+		// Replaces the previous deadline
+		void schedule(std::uint32_t timer, std::uint64_t tick);
+		void cancel(std::uint32_t timer);
+		bool isScheduled(std::uint32_t timer) const { return m_Scheduled[timer]; }
+
+		// s_Invalid once no timer is due
+		std::uint32_t popExpired(std::uint64_t tick);
+		// Never later than the earliest deadline, ~0ULL if nothing is scheduled
+		std::uint64_t nextTick() const;
+
+		auto getMaxTimers() const { return m_MaxTimers; }
+		auto getCount() const { return m_Count; }
+		auto getCurrentTick() const { return m_Current; }
+
+	private:
+		// Bucket list heads and the firing list follow the timers
+		std::uint32_t bucketHead(std::uint32_t level, std::uint32_t bucket) const { return m_MaxTimers + level * s_Buckets + bucket; }
+		std::uint32_t firingHead() const { return m_MaxTimers + s_Levels * s_Buckets; }
+
+		void insert(std::uint32_t timer);
+		void unlink(std::uint32_t timer);
+		void link(std::uint32_t head, std::uint32_t timer);
+		void step();
+
+	private:
+		std::uint32_t  m_MaxTimers;
+		std::uint32_t* m_Next;
+		std::uint32_t* m_Prev;
+		std::uint64_t* m_Ticks;
+		// level * s_Buckets + bucket
+		std::uint32_t* m_Buckets;
+		bool*          m_Scheduled;
+		std::uint64_t  m_Occupied[s_Levels] {};
+		std::uint64_t  m_Current { 0U };
+		std::uint32_t  m_Count { 0U };
+	};
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,273 @@
+#include "ReliableUDP/NetworkSimulator.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ReliableUDP
+{
+	static constexpr Clock::duration s_MinStep = std::chrono::microseconds(10);
+
+	static Clock::duration Seconds(double time)
+	{
+		return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(time));
+	}
+
+	NetworkSimulator::NetworkSimulator(std::uint64_t seed)
+	    : m_Random(seed),
+	      m_Now(Clock::now()),
+	      m_Links(new LinkState[s_MaxSockets * s_MaxSockets]) {}
+
+	NetworkSimulator::~NetworkSimulator()
+	{
+		useRealTime();
+		for (std::uint32_t i { 0 }; i < m_SocketCount; ++i)
+		{
+			SocketEntry& entry { m_Sockets[i] };
+			if (entry.m_Socket->getCaptureCallback() == &Route)
+				entry.m_Socket->setCaptureCallback(entry.m_CaptureCallback, entry.m_CaptureData);
+		}
+		if (m_InFlight)
+		{
+			for (std::uint32_t i { 0 }; i < m_InFlightCount; ++i)
+				delete[] m_InFlight[i].m_Data;
+			delete[] m_InFlight;
+		}
+		if (m_Links)
+			delete[] m_Links;
+		m_InFlight      = nullptr;
+		m_InFlightCount = 0U;
+		m_Links         = nullptr;
+	}
+
+	bool NetworkSimulator::attach(Networking::Socket& socket, Networking::Endpoint endpoint, std::uint32_t queueSize)
+	{
+		if (m_SocketCount >= s_MaxSockets || findSocket(endpoint) != ~0U || !socket.bindMemory(endpoint, queueSize))
+			return false;
+
+		SocketEntry& entry { m_Sockets[m_SocketCount++] };
+		entry.m_Socket          = &socket;
+		entry.m_Endpoint        = endpoint;
+		entry.m_CaptureCallback = socket.getCaptureCallback();
+		entry.m_CaptureData     = socket.getCaptureData();
+		socket.setCaptureCallback(&Route, this);
+		return true;
+	}
+
+	void NetworkSimulator::setConditions(const LinkConditions& conditions)
+	{
+		m_Conditions = conditions;
+		for (std::uint32_t i { 0 }; i < s_MaxSockets * s_MaxSockets; ++i)
+		{
+			if (!m_Links[i].m_Custom)
+				m_Links[i].m_Conditions = conditions;
+		}
+	}
+
+	void NetworkSimulator::setConditions(Networking::Endpoint source, Networking::Endpoint destination, const LinkConditions& conditions)
+	{
+		std::uint32_t from { findSocket(source) };
+		std::uint32_t to { findSocket(destination) };
+		if (from == ~0U || to == ~0U)
+			return;
+
+		LinkState& link { m_Links[from * s_MaxSockets + to] };
+		link.m_Conditions = conditions;
+		link.m_Custom     = true;
+	}
+
+	void NetworkSimulator::useSimulatedTime()
+	{
+		// Must not be behind the timers of handlers created before
+		if (!m_Current)
+			m_Now = std::max(m_Now, Clock::now());
+		Clock::SetSource(&Now, this);
+		m_Current = true;
+	}
+
+	void NetworkSimulator::useRealTime()
+	{
+		if (!m_Current)
+			return;
+
+		Clock::SetSource(nullptr, nullptr);
+		m_Current = false;
+	}
+
+	void NetworkSimulator::advance(Clock::duration duration)
+	{
+		Clock::time_point end { m_Now + duration };
+		while (m_InFlightCount && m_InFlight[0].m_Time <= end)
+		{
+			m_Now = std::max(m_Now, m_InFlight[0].m_Time);
+			deliverNext();
+		}
+		m_Now = end;
+	}
+
+	void NetworkSimulator::run(PacketHandler* const* handlers, std::size_t count, Clock::duration duration)
+	{
+		Clock::time_point end { m_Now + duration };
+		while (true)
+		{
+			for (std::size_t i { 0 }; i < count; ++i)
+				handlers[i]->updatePackets();
+			if (m_Now >= end)
+				break;
+
+			Clock::time_point next { std::min(getNextDelivery(), end) };
+			for (std::size_t i { 0 }; i < count; ++i)
+				next = std::min(next, handlers[i]->getNextDeadline(m_Now));
+			next = std::min(std::max(next, m_Now + s_MinStep), end);
+			advance(next - m_Now);
+		}
+	}
+
+	Clock::time_point NetworkSimulator::getNextDelivery() const
+	{
+		return m_InFlightCount ? m_InFlight[0].m_Time : Clock::time_point::max();
+	}
+
+	Clock::time_point NetworkSimulator::Now(void* userData)
+	{
+		return static_cast<NetworkSimulator*>(userData)->m_Now;
+	}
+
+	void NetworkSimulator::Route(Networking::Socket* socket, void* captureData, bool sent, Networking::Endpoint endpoint, const Networking::Buffer* buffers, std::size_t count)
+	{
+		NetworkSimulator& simulator { *static_cast<NetworkSimulator*>(captureData) };
+		std::uint32_t     source { simulator.findSocket(socket->getLocalEndpoint()) };
+		if (source == ~0U)
+			return;
+
+		SocketEntry& entry { simulator.m_Sockets[source] };
+		if (entry.m_CaptureCallback)
+			entry.m_CaptureCallback(socket, entry.m_CaptureData, sent, endpoint, buffers, count);
+		if (!sent)
+			return;
+
+		++simulator.m_Stats.m_Sent;
+		std::uint32_t destination { simulator.findSocket(endpoint) };
+		if (destination == ~0U)
+		{
+			++simulator.m_Stats.m_Unroutable;
+			return;
+		}
+		simulator.send(source, destination, buffers, count);
+	}
+
+	std::uint32_t NetworkSimulator::findSocket(Networking::Endpoint endpoint) const
+	{
+		for (std::uint32_t i { 0 }; i < m_SocketCount; ++i)
+		{
+			if (m_Sockets[i].m_Endpoint == endpoint)
+				return i;
+		}
+		return ~0U;
+	}
+
+	void NetworkSimulator::send(std::uint32_t source, std::uint32_t destination, const Networking::Buffer* buffers, std::size_t count)
+	{
+		LinkState&            link { m_Links[source * s_MaxSockets + destination] };
+		const LinkConditions& conditions { link.m_Conditions };
+
+		std::uint32_t size { 0U };
+		for (std::size_t i { 0 }; i < count; ++i)
+			size += static_cast<std::uint32_t>(buffers[i].m_Size);
+		if (conditions.m_MaxDatagramSize && size > conditions.m_MaxDatagramSize)
+		{
+			++m_Stats.m_Oversized;
+			return;
+		}
+
+		if (link.m_Bad ? random() < conditions.m_BurstEnd : random() < conditions.m_BurstStart)
+			link.m_Bad = !link.m_Bad;
+		if (link.m_Bad && random() < conditions.m_BurstLoss)
+		{
+			++m_Stats.m_BurstLost;
+			return;
+		}
+		if (random() < conditions.m_Loss)
+		{
+			++m_Stats.m_Lost;
+			return;
+		}
+
+		Clock::time_point departure { m_Now };
+		if (conditions.m_Bandwidth)
+		{
+			Clock::time_point start { std::max(m_Now, link.m_BusyUntil) };
+			double            queued { std::chrono::duration<double>(start - m_Now).count() * static_cast<double>(conditions.m_Bandwidth) };
+			if (queued + size > conditions.m_QueueSize)
+			{
+				++m_Stats.m_QueueDropped;
+				return;
+			}
+			departure        = start + Seconds(static_cast<double>(size) / static_cast<double>(conditions.m_Bandwidth));
+			link.m_BusyUntil = departure;
+		}
+
+		Networking::Endpoint from { m_Sockets[source].m_Endpoint };
+		double               delay { conditions.m_Delay + conditions.m_Jitter * random() };
+		if (random() < conditions.m_Reorder)
+		{
+			delay += conditions.m_ReorderDelay;
+			++m_Stats.m_Reordered;
+		}
+		schedule(departure + Seconds(delay), destination, from, buffers, count, size);
+
+		if (random() < conditions.m_Duplicate)
+		{
+			schedule(departure + Seconds(conditions.m_Delay + conditions.m_Jitter * random()), destination, from, buffers, count, size);
+			++m_Stats.m_Duplicated;
+		}
+	}
+
+	void NetworkSimulator::schedule(Clock::time_point time, std::uint32_t destination, Networking::Endpoint source, const Networking::Buffer* buffers, std::size_t count, std::uint32_t size)
+	{
+		if (m_InFlightCount == m_InFlightCapacity)
+		{
+			std::uint32_t capacity { std::max(m_InFlightCapacity * 2U, 64U) };
+			InFlight*     inFlight { new InFlight[capacity] };
+			for (std::uint32_t i { 0 }; i < m_InFlightCount; ++i)
+				inFlight[i] = m_InFlight[i];
+			if (m_InFlight)
+				delete[] m_InFlight;
+			m_InFlight         = inFlight;
+			m_InFlightCapacity = capacity;
+		}
+
+		InFlight& datagram { m_InFlight[m_InFlightCount++] };
+		datagram.m_Time        = time;
+		datagram.m_Order       = m_NextOrder++;
+		datagram.m_Destination = destination;
+		datagram.m_Source      = source;
+		datagram.m_Data        = new std::uint8_t[std::max(size, 1U)];
+		datagram.m_Size        = size;
+		std::uint32_t offset { 0U };
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			if (buffers[i].m_Size)
+				std::memcpy(datagram.m_Data + offset, buffers[i].m_Data, buffers[i].m_Size);
+			offset += static_cast<std::uint32_t>(buffers[i].m_Size);
+		}
+		std::push_heap(m_InFlight, m_InFlight + m_InFlightCount, [](const InFlight& lhs, const InFlight& rhs) { return Earlier(rhs, lhs); });
+	}
+
+	void NetworkSimulator::deliverNext()
+	{
+		std::pop_heap(m_InFlight, m_InFlight + m_InFlightCount, [](const InFlight& lhs, const InFlight& rhs) { return Earlier(rhs, lhs); });
+		InFlight& datagram { m_InFlight[--m_InFlightCount] };
+		if (m_Sockets[datagram.m_Destination].m_Socket->inject(datagram.m_Data, datagram.m_Size, datagram.m_Source))
+			++m_Stats.m_Delivered;
+		else
+			++m_Stats.m_Overflowed;
+		delete[] datagram.m_Data;
+		datagram.m_Data = nullptr;
+	}
+
+	float NetworkSimulator::random()
+	{
+		// The standard distributions differ between implementations
+		return static_cast<float>(m_Random() >> 40) * 0x1.0p-24f;
+	}
+} // namespace ReliableUDP
@@ -1,5 +1,6 @@
 #include "ReliableUDP/Networking/Endpoint.h"
 
+#include <cstring>
 #include <sstream>
 
 namespace ReliableUDP::Networking
@@ -30,6 +31,19 @@ namespace ReliableUDP::Networking
 		return ToHost(*this);
 	}
 
+	std::uint64_t Endpoint::hash() const
+	{
+		std::uint64_t low, high;
+		std::memcpy(&low, m_Address.m_IPv6.m_Bytes, 8);
+		std::memcpy(&high, m_Address.m_IPv6.m_Bytes + 8, 8);
+
+		// splitmix64 finalizer
+		std::uint64_t value { low ^ (high * 0x9E3779B97F4A7C15ULL) ^ (static_cast<std::uint64_t>(m_Port) << 32) };
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+		return value ^ (value >> 31);
+	}
+
 	bool Endpoint::operator==(Endpoint other) const
 	{
 		return m_Address == other.m_Address && m_Port == other.m_Port;
@@ -0,0 +1,389 @@
+#include "ReliableUDP/Networking/Pcap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace ReliableUDP::Networking
+{
+	static constexpr std::uint32_t s_MagicMicroseconds = 0xA1B2C3D4U;
+	static constexpr std::uint32_t s_MagicNanoseconds  = 0xA1B23C4DU;
+	static constexpr std::uint32_t s_SnapLength        = 262144U;
+
+	static constexpr std::uint32_t s_LinkNull     = 0U;
+	static constexpr std::uint32_t s_LinkEthernet = 1U;
+	static constexpr std::uint32_t s_LinkRaw      = 101U;
+	static constexpr std::uint32_t s_LinkCooked   = 113U;
+	static constexpr std::uint32_t s_LinkIPv4     = 228U;
+	static constexpr std::uint32_t s_LinkIPv6     = 229U;
+
+	static constexpr std::uint32_t s_FileHeaderSize   = 24U;
+	static constexpr std::uint32_t s_RecordHeaderSize = 16U;
+	static constexpr std::uint32_t s_IPv4HeaderSize   = 20U;
+	static constexpr std::uint32_t s_IPv6HeaderSize   = 40U;
+	static constexpr std::uint32_t s_UDPHeaderSize    = 8U;
+
+	// Native byte order, like libpcap writes it
+	struct RecordHeader
+	{
+	public:
+		std::uint32_t m_Seconds;
+		std::uint32_t m_Fraction;
+		std::uint32_t m_CapturedSize;
+		std::uint32_t m_OriginalSize;
+	};
+
+	static constexpr std::uint32_t ByteSwap(std::uint32_t value)
+	{
+		return (value >> 24) | ((value >> 8) & 0xFF00U) | ((value << 8) & 0xFF0000U) | (value << 24);
+	}
+
+	static void Put16(std::uint8_t* data, std::uint16_t value)
+	{
+		data[0] = static_cast<std::uint8_t>(value >> 8);
+		data[1] = static_cast<std::uint8_t>(value);
+	}
+
+	static std::uint16_t Get16(const std::uint8_t* data)
+	{
+		return static_cast<std::uint16_t>((data[0] << 8) | data[1]);
+	}
+
+	static void PutAddress(std::uint8_t* data, Address address, bool ipv4)
+	{
+		if (ipv4)
+		{
+			for (std::size_t i = 0; i < 4; ++i)
+				data[i] = address.m_IPv4.m_Bytes[3 - i];
+		}
+		else
+		{
+			for (std::size_t i = 0; i < 16; ++i)
+				data[i] = address.m_IPv6.m_Bytes[15 - i];
+		}
+	}
+
+	static Address GetAddress(const std::uint8_t* data, bool ipv4)
+	{
+		if (ipv4)
+			return IPv4Address { static_cast<std::uint32_t>((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]) };
+
+		IPv6Address address;
+		for (std::size_t i = 0; i < 16; ++i)
+			address.m_Bytes[15 - i] = data[i];
+		return address;
+	}
+
+	void PcapWriter::Capture(Socket* socket, void* captureData, bool sent, Endpoint endpoint, const Buffer* buffers, std::size_t count)
+	{
+		static_cast<PcapWriter*>(captureData)->record(sent, socket->getLocalEndpoint(), endpoint, buffers, count);
+	}
+
+	PcapWriter::PcapWriter(std::uint32_t bufferSize)
+	    : m_Buffer(new Utils::SPSCRing(bufferSize)) {}
+
+	PcapWriter::~PcapWriter()
+	{
+		close();
+		if (m_Buffer)
+			delete m_Buffer;
+		m_Buffer = nullptr;
+	}
+
+	bool PcapWriter::open(std::string_view path)
+	{
+		if (m_File)
+			return false;
+
+		std::string pathStr { path };
+		m_File = std::fopen(pathStr.c_str(), "wb");
+		if (!m_File)
+			return false;
+
+		// Version 2.4
+		std::uint32_t header[6] { s_MagicNanoseconds, 0x00040002U, 0U, 0U, s_SnapLength, s_LinkRaw };
+		if (std::fwrite(header, sizeof(header), 1, m_File) != 1)
+		{
+			std::fclose(m_File);
+			m_File = nullptr;
+			return false;
+		}
+
+		m_Running.store(true);
+		m_Thread = std::thread { &PcapWriter::threadFunc, this };
+		return true;
+	}
+
+	void PcapWriter::close()
+	{
+		if (!m_File)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock { m_WakeMutex };
+			m_Running.store(false);
+		}
+		m_Wake.notify_one();
+		m_Thread.join();
+		std::fclose(m_File);
+		m_File = nullptr;
+	}
+
+	void PcapWriter::record(bool sent, Endpoint local, Endpoint remote, const Buffer* buffers, std::size_t count)
+	{
+		if (!m_Running.load(std::memory_order_relaxed))
+			return;
+
+		std::uint64_t time { static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()) };
+
+		std::size_t payloadSize { 0U };
+		for (std::size_t i { 0 }; i < count; ++i)
+			payloadSize += buffers[i].m_Size;
+
+		// Mixed families are written as IPv6
+		Endpoint      source { sent ? local : remote };
+		Endpoint      destination { sent ? remote : local };
+		bool          ipv4 { source.isIPv4() && destination.isIPv4() };
+		std::uint32_t ipSize { ipv4 ? s_IPv4HeaderSize : s_IPv6HeaderSize };
+		std::uint32_t udpSize { static_cast<std::uint32_t>(s_UDPHeaderSize + payloadSize) };
+		std::uint32_t packetSize { ipSize + udpSize };
+		if (udpSize > 0xFFFFU || packetSize > s_SnapLength)
+			return;
+
+		std::lock_guard<std::mutex> lock { m_BufferMutex };
+		std::uint8_t*               entry { m_Buffer->reserve(s_RecordHeaderSize + packetSize) };
+		if (!entry)
+		{
+			m_Dropped.add();
+			return;
+		}
+
+		RecordHeader header { static_cast<std::uint32_t>(time / 1'000'000'000U), static_cast<std::uint32_t>(time % 1'000'000'000U), packetSize, packetSize };
+		std::memcpy(entry, &header, sizeof(header));
+
+		std::uint8_t* ip { entry + s_RecordHeaderSize };
+		std::memset(ip, 0, ipSize + s_UDPHeaderSize);
+		if (ipv4)
+		{
+			ip[0] = 0x45U;
+			Put16(ip + 2, static_cast<std::uint16_t>(packetSize));
+			ip[6] = 0x40U; // Don't fragment
+			ip[8] = 64U;
+			ip[9] = 17U;
+			PutAddress(ip + 12, source.m_Address, true);
+			PutAddress(ip + 16, destination.m_Address, true);
+
+			std::uint32_t sum { 0U };
+			for (std::uint32_t i { 0 }; i < s_IPv4HeaderSize; i += 2)
+				sum += Get16(ip + i);
+			while (sum >> 16)
+				sum = (sum & 0xFFFFU) + (sum >> 16);
+			Put16(ip + 10, static_cast<std::uint16_t>(~sum));
+		}
+		else
+		{
+			ip[0] = 0x60U;
+			Put16(ip + 4, static_cast<std::uint16_t>(udpSize));
+			ip[6] = 17U;
+			ip[7] = 64U;
+			PutAddress(ip + 8, source.m_Address, false);
+			PutAddress(ip + 24, destination.m_Address, false);
+		}
+
+		// The UDP checksum is left at zero
+		std::uint8_t* udp { ip + ipSize };
+		Put16(udp, source.m_Port);
+		Put16(udp + 2, destination.m_Port);
+		Put16(udp + 4, static_cast<std::uint16_t>(udpSize));
+
+		std::uint8_t* payload { udp + s_UDPHeaderSize };
+		for (std::size_t i { 0 }; i < count; ++i)
+		{
+			if (buffers[i].m_Size)
+				std::memcpy(payload, buffers[i].m_Data, buffers[i].m_Size);
+			payload += buffers[i].m_Size;
+		}
+		m_Buffer->commit();
+		m_Recorded.add();
+	}
+
+	void PcapWriter::threadFunc()
+	{
+		while (m_Running.load())
+		{
+			if (drain())
+				continue;
+
+			std::fflush(m_File);
+			std::unique_lock<std::mutex> lock { m_WakeMutex };
+			m_Wake.wait_for(lock, std::chrono::milliseconds(10), [this]() { return !m_Running.load(); });
+		}
+		drain();
+		std::fflush(m_File);
+	}
+
+	bool PcapWriter::drain()
+	{
+		bool          drained { false };
+		std::uint32_t size { 0U };
+		while (std::uint8_t* entry { m_Buffer->front(size) })
+		{
+			std::fwrite(entry, 1, size, m_File);
+			m_Buffer->pop();
+			drained = true;
+		}
+		return drained;
+	}
+
+	PcapReader::~PcapReader()
+	{
+		close();
+	}
+
+	bool PcapReader::open(std::string_view path)
+	{
+		if (m_File)
+			return false;
+
+		std::string pathStr { path };
+		m_File = std::fopen(pathStr.c_str(), "rb");
+		if (!m_File)
+			return false;
+
+		std::uint8_t header[s_FileHeaderSize];
+		if (std::fread(header, sizeof(header), 1, m_File) != 1)
+		{
+			close();
+			return false;
+		}
+
+		std::uint32_t magic;
+		std::memcpy(&magic, header, sizeof(magic));
+		m_Swapped     = false;
+		m_Nanoseconds = false;
+		switch (magic)
+		{
+		case s_MagicMicroseconds: break;
+		case s_MagicNanoseconds: m_Nanoseconds = true; break;
+		case ByteSwap(s_MagicMicroseconds): m_Swapped = true; break;
+		case ByteSwap(s_MagicNanoseconds):
+			m_Swapped     = true;
+			m_Nanoseconds = true;
+			break;
+		default:
+			close();
+			return false;
+		}
+		m_LinkType = read32(header + 20) & 0x0FFFFFFFU;
+		return true;
+	}
+
+	void PcapReader::close()
+	{
+		if (m_File)
+			std::fclose(m_File);
+		m_File = nullptr;
+		if (m_Packet)
+			delete[] m_Packet;
+		m_Packet     = nullptr;
+		m_PacketSize = 0U;
+	}
+
+	bool PcapReader::next(PcapRecord& record)
+	{
+		if (!m_File)
+			return false;
+
+		std::uint8_t header[s_RecordHeaderSize];
+		while (std::fread(header, sizeof(header), 1, m_File) == 1)
+		{
+			std::uint32_t size { read32(header + 8) };
+			if (size > m_PacketSize)
+			{
+				if (size > s_SnapLength * 4U)
+					return false;
+				if (m_Packet)
+					delete[] m_Packet;
+				m_Packet     = new std::uint8_t[size];
+				m_PacketSize = size;
+			}
+			if (size && std::fread(m_Packet, size, 1, m_File) != 1)
+				return false;
+
+			const std::uint8_t* ip { m_Packet };
+			std::uint32_t       ipSize { size };
+			std::uint32_t       linkSize { 0U };
+			switch (m_LinkType)
+			{
+			case s_LinkNull: linkSize = 4U; break;
+			case s_LinkRaw:
+			case s_LinkIPv4:
+			case s_LinkIPv6: break;
+			case s_LinkEthernet:
+				linkSize = 14U;
+				if (size >= 18U && Get16(m_Packet + 12) == 0x8100U)
+					linkSize = 18U;
+				if (size < linkSize || (Get16(m_Packet + linkSize - 2) != 0x0800U && Get16(m_Packet + linkSize - 2) != 0x86DDU))
+					continue;
+				break;
+			case s_LinkCooked:
+				linkSize = 16U;
+				if (size < linkSize || (Get16(m_Packet + 14) != 0x0800U && Get16(m_Packet + 14) != 0x86DDU))
+					continue;
+				break;
+			default: return false;
+			}
+			if (size < linkSize + 1U)
+				continue;
+			ip += linkSize;
+			ipSize -= linkSize;
+
+			const std::uint8_t* udp { nullptr };
+			bool                ipv4 { (ip[0] >> 4) == 4U };
+			if (ipv4)
+			{
+				std::uint32_t headerSize { (ip[0] & 0x0FU) * 4U };
+				// Fragments are skipped
+				if (ipSize < s_IPv4HeaderSize || headerSize < s_IPv4HeaderSize || ipSize < headerSize + s_UDPHeaderSize || ip[9] != 17U || (Get16(ip + 6) & 0x3FFFU))
+					continue;
+				udp                  = ip + headerSize;
+				record.m_Source      = { GetAddress(ip + 12, true), 0U };
+				record.m_Destination = { GetAddress(ip + 16, true), 0U };
+			}
+			else if ((ip[0] >> 4) == 6U)
+			{
+				if (ipSize < s_IPv6HeaderSize + s_UDPHeaderSize || ip[6] != 17U)
+					continue;
+				udp                  = ip + s_IPv6HeaderSize;
+				record.m_Source      = { GetAddress(ip + 8, false), 0U };
+				record.m_Destination = { GetAddress(ip + 24, false), 0U };
+			}
+			else
+			{
+				continue;
+			}
+
+			std::uint32_t available { static_cast<std::uint32_t>(ip + ipSize - udp) - s_UDPHeaderSize };
+			std::uint32_t udpSize { Get16(udp + 4) };
+			if (udpSize < s_UDPHeaderSize)
+				continue;
+
+			std::uint64_t fraction { read32(header + 4) };
+			record.m_Time               = read32(header) * 1'000'000'000ULL + (m_Nanoseconds ? fraction : fraction * 1'000U);
+			record.m_Source.m_Port      = Get16(udp);
+			record.m_Destination.m_Port = Get16(udp + 2);
+			record.m_Data               = udp + s_UDPHeaderSize;
+			record.m_Size               = std::min(udpSize - s_UDPHeaderSize, available);
+			return true;
+		}
+		return false;
+	}
+
+	std::uint32_t PcapReader::read32(const std::uint8_t* data) const
+	{
+		std::uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return m_Swapped ? ByteSwap(value) : value;
+	}
+} // namespace ReliableUDP::Networking
@@ -1,5 +1,9 @@
 #include "ReliableUDP/Networking/Socket.h"
 #include "ReliableUDP/Utils/Core.h"
+#include "ReliableUDP/Utils/SPSCRing.h"
+
+#include <cstring>
+#include <limits>
 
 #if BUILD_IS_SYSTEM_WINDOWS
 #include <WS2tcpip.h>
@@ -11,6 +15,7 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -177,6 +182,21 @@ namespace ReliableUDP::Networking
 #endif
 	}
 
+	static int GetSockOpt(std::uintptr_t socket, int level, int optname, void* optval, std::size_t* optlen)
+	{
+#if BUILD_IS_SYSTEM_WINDOWS
+		int  optlenS = static_cast<int>(*optlen);
+		auto r       = ::getsockopt(static_cast<SOCKET>(socket), level, optname, reinterpret_cast<char*>(optval), &optlenS);
+		*optlen      = static_cast<std::size_t>(optlenS);
+		return r;
+#else
+		socklen_t optlenS = static_cast<socklen_t>(*optlen);
+		auto      r       = ::getsockopt(static_cast<int>(socket), level, optname, optval, &optlenS);
+		*optlen           = static_cast<std::size_t>(optlenS);
+		return r;
+#endif
+	}
+
 	static int SetNonBlocking(std::uintptr_t socket)
 	{
 #if BUILD_IS_SYSTEM_WINDOWS
@@ -230,6 +250,71 @@ namespace ReliableUDP::Networking
 #endif
 	}
 
+	static constexpr std::size_t s_MaxBuffers = 16;
+
+	static std::make_signed_t<std::size_t> SendToV(std::uintptr_t socket, const Buffer* buffers, std::size_t count, int flags, sockaddr_storage* addr, std::size_t addrSize)
+	{
+#if BUILD_IS_SYSTEM_WINDOWS
+		WSABUF wsaBuffers[s_MaxBuffers];
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			wsaBuffers[i].buf = const_cast<char*>(reinterpret_cast<const char*>(buffers[i].m_Data));
+			wsaBuffers[i].len = static_cast<ULONG>(buffers[i].m_Size);
+		}
+
+		DWORD sent = 0;
+		if (::WSASendTo(static_cast<SOCKET>(socket), wsaBuffers, static_cast<DWORD>(count), &sent, static_cast<DWORD>(flags), reinterpret_cast<sockaddr*>(addr), static_cast<int>(addrSize), nullptr, nullptr) == SOCKET_ERROR)
+			return -1;
+		return static_cast<std::make_signed_t<std::size_t>>(sent);
+#else
+		iovec iovecs[s_MaxBuffers];
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			iovecs[i].iov_base = const_cast<void*>(buffers[i].m_Data);
+			iovecs[i].iov_len  = buffers[i].m_Size;
+		}
+
+		msghdr message {};
+		message.msg_name    = addr;
+		message.msg_namelen = static_cast<socklen_t>(addrSize);
+		message.msg_iov     = iovecs;
+		message.msg_iovlen  = count;
+		return ::sendmsg(static_cast<int>(socket), &message, flags);
+#endif
+	}
+
+	static constexpr std::size_t s_MaxPollCount = 8;
+
+	static int PollReadable(const std::uintptr_t* sockets, std::size_t count, std::uint32_t timeout)
+	{
+		count = std::min(count, s_MaxPollCount);
+#if BUILD_IS_SYSTEM_WINDOWS
+		WSAPOLLFD fds[s_MaxPollCount] {};
+		for (std::size_t i = 0; i < count; ++i)
+			fds[i] = { static_cast<SOCKET>(sockets[i]), POLLRDNORM, 0 };
+		return ::WSAPoll(fds, static_cast<ULONG>(count), static_cast<INT>(timeout));
+#else
+		pollfd fds[s_MaxPollCount] {};
+		for (std::size_t i = 0; i < count; ++i)
+			fds[i] = { static_cast<int>(sockets[i]), POLLIN, 0 };
+		return ::poll(fds, static_cast<nfds_t>(count), static_cast<int>(timeout));
+#endif
+	}
+
+#if BUILD_IS_SYSTEM_LINUX
+	static constexpr std::size_t s_MaxBatchSize = 64;
+
+	static int ReceiveMany(std::uintptr_t socket, mmsghdr* messages, std::size_t count, int flags)
+	{
+		return ::recvmmsg(static_cast<int>(socket), messages, static_cast<unsigned int>(count), flags, nullptr);
+	}
+
+	static int SendMany(std::uintptr_t socket, mmsghdr* messages, std::size_t count, int flags)
+	{
+		return ::sendmmsg(static_cast<int>(socket), messages, static_cast<unsigned int>(count), flags);
+	}
+#endif
+
 	static int GetAddrInfo(const char* node, const char* service, const addrinfo* hints, addrinfo** results)
 	{
 		return ::getaddrinfo(node, service, hints, results);
@@ -317,6 +402,7 @@ namespace ReliableUDP::Networking
 		case WSAEISCONN: return ESocketError::AlreadyConnected;
 		case WSAENETDOWN: return ESocketError::NetworkDown;
 		case WSAEHOSTDOWN: return ESocketError::HostDown;
+		case WSAEMSGSIZE: return ESocketError::MessageTooLarge;
 #else
 		case EIO: [[fallthrough]];
 		case EFAULT: [[fallthrough]];
@@ -343,6 +429,7 @@ namespace ReliableUDP::Networking
 		case EISCONN: return ESocketError::AlreadyConnected;
 		case ENETDOWN: return ESocketError::NetworkDown;
 		case EHOSTDOWN: return ESocketError::HostDown;
+		case EMSGSIZE: return ESocketError::MessageTooLarge;
 #endif
 		default: return ESocketError::Unknown;
 		}
@@ -437,14 +524,37 @@ namespace ReliableUDP::Networking
 		case ESocketError::AlreadyConnected: return "Socket is already connected";
 		case ESocketError::NetworkDown: return "Network is down";
 		case ESocketError::HostDown: return "Host is down";
+		case ESocketError::MessageTooLarge: return "Message is too large";
 		}
 		return "Unknown error";
 	}
 
+	struct MemoryRecord
+	{
+	public:
+		Endpoint      m_Endpoint;
+		std::uint32_t m_Size { 0U };
+	};
+
+	SocketAddress SocketAddress::FromEndpoint(Endpoint endpoint)
+	{
+		static_assert(sizeof(sockaddr_in6) <= sizeof(SocketAddress::m_Data));
+
+		sockaddr_storage addr {};
+		std::size_t      addrSize = sizeof(addr);
+		ToSockAddr(endpoint, &addr, &addrSize);
+
+		SocketAddress address;
+		std::memcpy(address.m_Data, &addr, addrSize);
+		address.m_Size = static_cast<std::uint32_t>(addrSize);
+		return address;
+	}
+
 	Socket::Socket(Socket&& move) noexcept
-	    : m_Type(move.m_Type), m_LocalEndpoint(move.m_LocalEndpoint), m_RemoteEndpoint(move.m_RemoteEndpoint), m_WriteTimeout(move.m_WriteTimeout), m_ReadTimeout(move.m_ReadTimeout), m_Socket(move.m_Socket), m_ErrorCallback(move.m_ErrorCallback), m_UserData(move.m_UserData)
+	    : m_Type(move.m_Type), m_LocalEndpoint(move.m_LocalEndpoint), m_RemoteEndpoint(move.m_RemoteEndpoint), m_WriteTimeout(move.m_WriteTimeout), m_ReadTimeout(move.m_ReadTimeout), m_Socket(move.m_Socket), m_ReusePort(move.m_ReusePort), m_DontFragment(move.m_DontFragment), m_ReceiveBufferSize(move.m_ReceiveBufferSize), m_SendBufferSize(move.m_SendBufferSize), m_Memory(move.m_Memory), m_ErrorCallback(move.m_ErrorCallback), m_UserData(move.m_UserData), m_CaptureCallback(move.m_CaptureCallback), m_CaptureData(move.m_CaptureData)
 	{
 		move.m_Socket = ~0ULL;
+		move.m_Memory = nullptr;
 	}
 
 	Socket::~Socket()
@@ -455,7 +565,7 @@ namespace ReliableUDP::Networking
 
 	std::size_t Socket::read(void* buf, std::size_t len)
 	{
-		if (!isBound())
+		if (!isNative())
 			return 0U;
 
 		std::uint8_t* data   = reinterpret_cast<std::uint8_t*>(buf);
@@ -493,6 +603,17 @@ namespace ReliableUDP::Networking
 		if (!isBound())
 			return 0U;
 
+		if (m_Memory)
+		{
+			Datagram datagram;
+			datagram.m_Buffer = buf;
+			datagram.m_Size   = len;
+			if (!readFromMemory(&datagram, 1U))
+				return 0U;
+			endpoint = datagram.m_Endpoint;
+			return datagram.m_Size;
+		}
+
 		sockaddr_storage addr {};
 		std::size_t      addrSize = sizeof(addr);
 
@@ -524,13 +645,14 @@ namespace ReliableUDP::Networking
 		else
 		{
 			ToEndpoint(endpoint, &addr);
+			capture(false, endpoint, buf, static_cast<std::size_t>(r));
 			return r;
 		}
 	}
 
 	std::size_t Socket::write(const void* buf, std::size_t len)
 	{
-		if (!isBound())
+		if (!isNative())
 			return 0U;
 
 		const uint8_t* data   = reinterpret_cast<const std::uint8_t*>(buf);
@@ -568,11 +690,20 @@ namespace ReliableUDP::Networking
 		if (!isBound())
 			return 0U;
 
+		if (m_Memory)
+		{
+			capture(true, endpoint, buf, len);
+			return len;
+		}
+
 		if (isConnected())
 		{
 			if (endpoint == m_RemoteEndpoint)
 			{
-				return write(buf, len);
+				std::size_t sent = write(buf, len);
+				if (sent)
+					capture(true, endpoint, buf, sent);
+				return sent;
 			}
 			else
 			{
@@ -612,9 +743,315 @@ namespace ReliableUDP::Networking
 			data += r;
 		}
 
+		if (offset)
+			capture(true, endpoint, buf, offset);
 		return offset;
 	}
 
+	std::size_t Socket::writeToV(const Buffer* buffers, std::size_t count, Endpoint endpoint)
+	{
+		if (!isBound() || !count)
+			return 0U;
+
+		count = std::min(count, s_MaxBuffers);
+		if (m_Memory)
+		{
+			std::size_t size = 0;
+			for (std::size_t i = 0; i < count; ++i)
+				size += buffers[i].m_Size;
+			capture(true, endpoint, buffers, count);
+			return size;
+		}
+
+		sockaddr_storage addr {};
+		std::size_t      addrSize = 0;
+		if (isConnected())
+		{
+			if (!(endpoint == m_RemoteEndpoint))
+			{
+				reportError(ESocketError::AlreadyConnected);
+				return 0U;
+			}
+		}
+		else
+		{
+			addrSize = sizeof(addr);
+			ToSockAddr(endpoint, &addr, &addrSize);
+		}
+
+		auto r = SendToV(m_Socket, buffers, count, 0, addrSize ? &addr : nullptr, addrSize);
+		if (r < 0)
+		{
+			auto errorCode = LastError();
+			if (IsErrorCodeCloseBased(errorCode))
+				close();
+			else if (IsErrorCodeAnError(errorCode))
+				reportError(errorCode);
+			return 0U;
+		}
+		capture(true, endpoint, buffers, count);
+		return static_cast<std::size_t>(r);
+	}
+
+	std::size_t Socket::readFromMany(Datagram* datagrams, std::size_t count)
+	{
+		if (!isBound() || !count)
+			return 0U;
+
+		if (m_Memory)
+			return readFromMemory(datagrams, count);
+
+#if BUILD_IS_SYSTEM_LINUX
+		count = std::min<std::size_t>(count, s_MaxBatchSize);
+
+		mmsghdr          messages[s_MaxBatchSize];
+		iovec            buffers[s_MaxBatchSize];
+		sockaddr_storage addrs[s_MaxBatchSize];
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			buffers[i].iov_base             = datagrams[i].m_Buffer;
+			buffers[i].iov_len              = datagrams[i].m_Size;
+			messages[i]                     = {};
+			messages[i].msg_hdr.msg_name    = &addrs[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+			messages[i].msg_hdr.msg_iov     = &buffers[i];
+			messages[i].msg_hdr.msg_iovlen  = 1;
+		}
+
+		// MSG_WAITFORONE: Blocking sockets only wait for the first datagram
+		int r = ReceiveMany(m_Socket, messages, count, MSG_WAITFORONE);
+		if (r < 0)
+		{
+			auto errorCode = LastError();
+			if (IsErrorCodeCloseBased(errorCode))
+				close();
+			else if (IsErrorCodeAnError(errorCode))
+				reportError(errorCode);
+			return 0U;
+		}
+
+		for (int i = 0; i < r; ++i)
+		{
+			datagrams[i].m_Size = messages[i].msg_len;
+			if (isConnected())
+				datagrams[i].m_Endpoint = m_RemoteEndpoint;
+			else
+				ToEndpoint(datagrams[i].m_Endpoint, &addrs[i]);
+			capture(false, datagrams[i].m_Endpoint, datagrams[i].m_Buffer, datagrams[i].m_Size);
+		}
+		return static_cast<std::size_t>(r);
+#else
+		// A blocking socket would wait on every read
+		if (!isNonBlocking())
+			count = 1;
+
+		std::size_t received = 0;
+		for (; received < count; ++received)
+		{
+			Datagram&   datagram = datagrams[received];
+			std::size_t size     = readFrom(datagram.m_Buffer, datagram.m_Size, datagram.m_Endpoint);
+			if (!size)
+				break;
+			datagram.m_Size = size;
+		}
+		return received;
+#endif
+	}
+
+	std::size_t Socket::writeToMany(Datagram* datagrams, std::size_t count)
+	{
+		if (!isBound() || !count)
+			return 0U;
+
+		if (m_Memory)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				Datagram& datagram = datagrams[i];
+				Buffer    buffers[2] { { datagram.m_Buffer, datagram.m_Size }, { datagram.m_Payload, datagram.m_PayloadSize } };
+				datagram.m_Rejected = false;
+				capture(true, datagram.m_Endpoint, buffers, datagram.m_PayloadSize ? 2 : 1);
+			}
+			return count;
+		}
+
+#if BUILD_IS_SYSTEM_LINUX
+		std::size_t handled = 0;
+		while (handled < count)
+		{
+			mmsghdr          messages[s_MaxBatchSize];
+			iovec            buffers[s_MaxBatchSize][2];
+			sockaddr_storage addrs[s_MaxBatchSize];
+			std::size_t      indices[s_MaxBatchSize];
+
+			std::size_t batch = 0;
+			std::size_t used  = handled;
+			for (; used < count && batch < s_MaxBatchSize; ++used)
+			{
+				Datagram& datagram  = datagrams[used];
+				mmsghdr&  message   = messages[batch];
+				message             = {};
+				datagram.m_Rejected = false;
+				if (isConnected())
+				{
+					if (!(datagram.m_Endpoint == m_RemoteEndpoint))
+					{
+						datagram.m_Rejected = true;
+						reportError(ESocketError::AlreadyConnected);
+						continue;
+					}
+				}
+				else if (datagram.m_Address)
+				{
+					message.msg_hdr.msg_name    = const_cast<std::uint8_t*>(datagram.m_Address->m_Data);
+					message.msg_hdr.msg_namelen = static_cast<socklen_t>(datagram.m_Address->m_Size);
+				}
+				else
+				{
+					std::size_t addrSize = sizeof(addrs[batch]);
+					ToSockAddr(datagram.m_Endpoint, &addrs[batch], &addrSize);
+					message.msg_hdr.msg_name    = &addrs[batch];
+					message.msg_hdr.msg_namelen = static_cast<socklen_t>(addrSize);
+				}
+				buffers[batch][0].iov_base = datagram.m_Buffer;
+				buffers[batch][0].iov_len  = datagram.m_Size;
+				buffers[batch][1].iov_base = const_cast<void*>(datagram.m_Payload);
+				buffers[batch][1].iov_len  = datagram.m_PayloadSize;
+				message.msg_hdr.msg_iov    = buffers[batch];
+				message.msg_hdr.msg_iovlen = datagram.m_PayloadSize ? 2 : 1;
+				indices[batch]             = used;
+				++batch;
+			}
+			if (!batch)
+			{
+				handled = used;
+				continue;
+			}
+
+			int r = SendMany(m_Socket, messages, batch, 0);
+			if (r < 0)
+			{
+				// The first datagram failed, anything but a full send buffer only refuses that one
+				auto errorCode = LastError();
+				if (IsErrorCodeCloseBased(errorCode))
+				{
+					close();
+					return indices[0];
+				}
+				if (!IsErrorCodeAnError(errorCode))
+					return indices[0];
+				reportError(errorCode);
+				datagrams[indices[0]].m_Rejected = true;
+				handled                          = indices[0] + 1;
+				continue;
+			}
+
+			if (m_CaptureCallback)
+			{
+				for (int i = 0; i < r; ++i)
+				{
+					const Datagram& datagram = datagrams[indices[i]];
+					Buffer          captured[2] { { datagram.m_Buffer, datagram.m_Size }, { datagram.m_Payload, datagram.m_PayloadSize } };
+					capture(true, datagram.m_Endpoint, captured, datagram.m_PayloadSize ? 2 : 1);
+				}
+			}
+			// A short count leaves the failing datagram for the next call to report
+			handled = static_cast<std::size_t>(r) < batch ? indices[r] : used;
+		}
+		return handled;
+#else
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Datagram& datagram  = datagrams[i];
+			datagram.m_Rejected = false;
+
+			sockaddr_storage addr {};
+			std::size_t      addrSize = 0;
+			if (isConnected())
+			{
+				if (!(datagram.m_Endpoint == m_RemoteEndpoint))
+				{
+					datagram.m_Rejected = true;
+					reportError(ESocketError::AlreadyConnected);
+					continue;
+				}
+			}
+			else
+			{
+				addrSize = sizeof(addr);
+				ToSockAddr(datagram.m_Endpoint, &addr, &addrSize);
+			}
+
+			Buffer buffers[2] { { datagram.m_Buffer, datagram.m_Size }, { datagram.m_Payload, datagram.m_PayloadSize } };
+			if (SendToV(m_Socket, buffers, datagram.m_PayloadSize ? 2 : 1, 0, addrSize ? &addr : nullptr, addrSize) < 0)
+			{
+				auto errorCode = LastError();
+				if (IsErrorCodeCloseBased(errorCode))
+				{
+					close();
+					return i;
+				}
+				if (!IsErrorCodeAnError(errorCode))
+					return i;
+				reportError(errorCode);
+				datagram.m_Rejected = true;
+				continue;
+			}
+			capture(true, datagram.m_Endpoint, buffers, datagram.m_PayloadSize ? 2 : 1);
+		}
+		return count;
+#endif
+	}
+
+	bool Socket::waitReadable(std::uint32_t timeout)
+	{
+		if (!isBound())
+			return false;
+
+		if (m_Memory)
+			return m_Memory->getUsed() != 0;
+
+		int r = PollReadable(&m_Socket, 1, timeout);
+		if (r < 0)
+		{
+			auto errorCode = LastError();
+			if (IsErrorCodeAnError(errorCode))
+				reportError(errorCode);
+			return false;
+		}
+		return r > 0;
+	}
+
+	bool Socket::WaitReadable(Socket* const* sockets, std::size_t count, std::uint32_t timeout)
+	{
+		std::uintptr_t natives[s_MaxPollCount] {};
+		std::size_t    nativeCount = 0;
+		for (std::size_t i = 0; i < count && nativeCount < s_MaxPollCount; ++i)
+		{
+			if (sockets[i]->m_Memory)
+			{
+				if (sockets[i]->m_Memory->getUsed())
+					return true;
+			}
+			else if (sockets[i]->isBound())
+			{
+				natives[nativeCount++] = sockets[i]->m_Socket;
+			}
+		}
+		if (nativeCount == 0)
+			return false;
+
+		int r = PollReadable(natives, nativeCount, timeout);
+		if (r < 0)
+		{
+			auto errorCode = LastError();
+			if (IsErrorCodeAnError(errorCode))
+				sockets[0]->reportError(errorCode);
+			return false;
+		}
+		return r > 0;
+	}
+
 	bool Socket::bind(Endpoint endpoint)
 	{
 		if (isBound())
@@ -634,6 +1071,20 @@ namespace ReliableUDP::Networking
 			return false;
 		}
 
+		if (m_ReusePort)
+		{
+#if defined(SO_REUSEPORT)
+			int enable = 1;
+			if (SetSockOpt(m_Socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0)
+				reportError(LastError());
+#else
+			reportError(ESocketError::InvalidArgument);
+#endif
+		}
+		applyBufferSizes();
+		if (m_DontFragment)
+			applyDontFragment(isIPv4);
+
 		sockaddr_storage addr {};
 		std::size_t      addrSize = sizeof(addr);
 		ToSockAddr(endpoint, &addr, &addrSize);
@@ -647,6 +1098,10 @@ namespace ReliableUDP::Networking
 		m_LocalEndpoint  = endpoint;
 		m_RemoteEndpoint = {};
 
+		addrSize = sizeof(addr);
+		if (GetSockName(m_Socket, &addr, &addrSize) == 0)
+			ToEndpoint(m_LocalEndpoint, &addr);
+
 		if (isNonBlocking())
 		{
 			if (SetNonBlocking(m_Socket) < 0)
@@ -663,6 +1118,56 @@ namespace ReliableUDP::Networking
 		return true;
 	}
 
+	bool Socket::bindMemory(Endpoint endpoint, std::uint32_t queueSize)
+	{
+		if (isBound())
+			return false;
+
+		m_Memory         = new Utils::SPSCRing(queueSize);
+		m_LocalEndpoint  = endpoint;
+		m_RemoteEndpoint = {};
+		return true;
+	}
+
+	bool Socket::inject(const void* data, std::size_t size, Endpoint endpoint)
+	{
+		if (!m_Memory)
+			return false;
+
+		std::uint8_t* entry = m_Memory->reserve(static_cast<std::uint32_t>(sizeof(MemoryRecord) + size));
+		if (!entry)
+			return false;
+
+		MemoryRecord& record = *reinterpret_cast<MemoryRecord*>(entry);
+		record.m_Endpoint    = endpoint;
+		record.m_Size        = static_cast<std::uint32_t>(size);
+		std::memcpy(entry + sizeof(MemoryRecord), data, size);
+		m_Memory->commit();
+		return true;
+	}
+
+	std::size_t Socket::readFromMemory(Datagram* datagrams, std::size_t count)
+	{
+		std::size_t   received = 0;
+		std::uint32_t size     = 0;
+		for (; received < count; ++received)
+		{
+			std::uint8_t* entry = m_Memory->front(size);
+			if (!entry)
+				break;
+
+			// Truncated like a native socket
+			const MemoryRecord& record   = *reinterpret_cast<const MemoryRecord*>(entry);
+			Datagram&           datagram = datagrams[received];
+			datagram.m_Size              = std::min<std::size_t>(datagram.m_Size, record.m_Size);
+			datagram.m_Endpoint          = record.m_Endpoint;
+			std::memcpy(datagram.m_Buffer, entry + sizeof(MemoryRecord), datagram.m_Size);
+			m_Memory->pop();
+			capture(false, datagram.m_Endpoint, datagram.m_Buffer, datagram.m_Size);
+		}
+		return received;
+	}
+
 	bool Socket::connect(Endpoint endpoint)
 	{
 		if (isBound())
@@ -681,6 +1186,9 @@ namespace ReliableUDP::Networking
 			reportError(LastError());
 			return false;
 		}
+		applyBufferSizes();
+		if (m_DontFragment)
+			applyDontFragment(isIPv4);
 
 		sockaddr_storage addr {};
 		std::size_t      addrSize = sizeof(addr);
@@ -718,6 +1226,15 @@ namespace ReliableUDP::Networking
 
 	void Socket::close()
 	{
+		if (m_Memory)
+		{
+			delete m_Memory;
+			m_Memory         = nullptr;
+			m_LocalEndpoint  = {};
+			m_RemoteEndpoint = {};
+			return;
+		}
+
 		if (!isBound())
 			return;
 
@@ -730,7 +1247,7 @@ namespace ReliableUDP::Networking
 
 	void Socket::closeW()
 	{
-		if (!isBound())
+		if (!isNative())
 			return;
 
 		if (Shutdown(m_Socket, EShutdownMethod::Send) < 0)
@@ -739,7 +1256,7 @@ namespace ReliableUDP::Networking
 
 	void Socket::closeR()
 	{
-		if (!isBound())
+		if (!isNative())
 			return;
 
 		if (Shutdown(m_Socket, EShutdownMethod::Receive) < 0)
@@ -748,7 +1265,7 @@ namespace ReliableUDP::Networking
 
 	void Socket::closeRW()
 	{
-		if (!isBound())
+		if (!isNative())
 			return;
 
 		if (Shutdown(m_Socket, EShutdownMethod::Both) < 0)
@@ -757,7 +1274,7 @@ namespace ReliableUDP::Networking
 
 	bool Socket::listen(std::uint32_t backlog)
 	{
-		if (!isBound() && m_Type != ESocketType::TCP)
+		if (!isNative() && m_Type != ESocketType::TCP)
 			return false;
 
 		if (Listen(m_Socket, backlog) < 0)
@@ -772,7 +1289,7 @@ namespace ReliableUDP::Networking
 	{
 		Socket socket { m_Type };
 
-		if (!isBound() && m_Type != ESocketType::TCP)
+		if (!isNative() && m_Type != ESocketType::TCP)
 			return socket;
 
 		sockaddr_storage addr {};
@@ -819,7 +1336,7 @@ namespace ReliableUDP::Networking
 
 	void Socket::setWriteTimeout(std::uint32_t timeout)
 	{
-		if (isBound())
+		if (isNative())
 		{
 			if ((timeout == 0 && SetNonBlocking(m_Socket) < 0) || SetSockOpt(m_Socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0)
 				reportError(LastError());
@@ -834,7 +1351,7 @@ namespace ReliableUDP::Networking
 
 	void Socket::setReadTimeout(std::uint32_t timeout)
 	{
-		if (isBound())
+		if (isNative())
 		{
 			if ((timeout == 0 && SetNonBlocking(m_Socket)) || SetSockOpt(m_Socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0)
 				reportError(LastError());
@@ -847,9 +1364,33 @@ namespace ReliableUDP::Networking
 		}
 	}
 
+	void Socket::setReusePort(bool reusePort)
+	{
+		if (!isBound())
+			m_ReusePort = reusePort;
+	}
+
+	void Socket::setBufferSizes(std::uint32_t receiveSize, std::uint32_t sendSize)
+	{
+		m_ReceiveBufferSize = receiveSize;
+		m_SendBufferSize    = sendSize;
+		if (isNative())
+			applyBufferSizes();
+	}
+
+	void Socket::setDontFragment(bool dontFragment)
+	{
+		if (m_DontFragment == dontFragment)
+			return;
+
+		m_DontFragment = dontFragment;
+		if (isNative())
+			applyDontFragment((isConnected() ? m_RemoteEndpoint : m_LocalEndpoint).isIPv4());
+	}
+
 	void Socket::setNonBlocking()
 	{
-		if (isBound())
+		if (isNative())
 		{
 			if (SetNonBlocking(m_Socket) < 0)
 			{
@@ -868,12 +1409,77 @@ namespace ReliableUDP::Networking
 		}
 	}
 
+	void Socket::applyBufferSizes()
+	{
+		int           options[2] { SO_RCVBUF, SO_SNDBUF };
+		std::uint32_t sizes[2] { m_ReceiveBufferSize, m_SendBufferSize };
+		for (std::size_t i = 0; i < 2; ++i)
+		{
+			int         size    = static_cast<int>(std::min<std::uint32_t>(sizes[i], std::numeric_limits<int>::max()));
+			int         current = 0;
+			std::size_t optlen  = sizeof(current);
+			if (GetSockOpt(m_Socket, SOL_SOCKET, options[i], &current, &optlen) < 0 || size <= current)
+				continue;
+			if (SetSockOpt(m_Socket, SOL_SOCKET, options[i], &size, sizeof(size)) < 0)
+				reportError(LastError());
+		}
+	}
+
+	void Socket::applyDontFragment(bool isIPv4)
+	{
+#if BUILD_IS_SYSTEM_LINUX
+		int ipValue   = m_DontFragment ? IP_PMTUDISC_PROBE : IP_PMTUDISC_WANT;
+		int ipv6Value = m_DontFragment ? IPV6_PMTUDISC_PROBE : IPV6_PMTUDISC_WANT;
+		if (isIPv4)
+		{
+			if (SetSockOpt(m_Socket, IPPROTO_IP, IP_MTU_DISCOVER, &ipValue, sizeof(ipValue)) < 0)
+				reportError(LastError());
+			return;
+		}
+		if (SetSockOpt(m_Socket, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &ipv6Value, sizeof(ipv6Value)) < 0)
+			reportError(LastError());
+		// IPv4 mapped destinations on a dual stack socket
+		SetSockOpt(m_Socket, IPPROTO_IP, IP_MTU_DISCOVER, &ipValue, sizeof(ipValue));
+#else
+#if BUILD_IS_SYSTEM_WINDOWS
+		DWORD enable = m_DontFragment ? 1 : 0;
+#else
+		int enable = m_DontFragment ? 1 : 0;
+#endif
+		if (isIPv4)
+		{
+#if BUILD_IS_SYSTEM_WINDOWS
+			if (SetSockOpt(m_Socket, IPPROTO_IP, IP_DONTFRAGMENT, &enable, sizeof(enable)) < 0)
+				reportError(LastError());
+#elif defined(IP_DONTFRAG)
+			if (SetSockOpt(m_Socket, IPPROTO_IP, IP_DONTFRAG, &enable, sizeof(enable)) < 0)
+				reportError(LastError());
+#else
+			reportError(ESocketError::InvalidArgument);
+#endif
+			return;
+		}
+#if defined(IPV6_DONTFRAG)
+		if (SetSockOpt(m_Socket, IPPROTO_IPV6, IPV6_DONTFRAG, &enable, sizeof(enable)) < 0)
+			reportError(LastError());
+#else
+		reportError(ESocketError::InvalidArgument);
+#endif
+#endif
+	}
+
 	void Socket::setErrorCallback(ErrorReportCallback callback, void* userData)
 	{
 		m_ErrorCallback = callback;
 		m_UserData      = userData;
 	}
 
+	void Socket::setCaptureCallback(CaptureCallback callback, void* captureData)
+	{
+		m_CaptureCallback = callback;
+		m_CaptureData     = captureData;
+	}
+
 	void Socket::reportError(std::uint32_t errorCode)
 	{
 		reportError(GetSocketError(errorCode));
@@ -1,32 +1,194 @@
 #include "ReliableUDP/PacketHandler.h"
 
+#include <algorithm>
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 
 namespace ReliableUDP
 {
-	PacketHandler::PacketHandler(std::uint32_t readBufferSize, std::uint32_t writeBufferSize, std::uint32_t maxReadPackets, std::uint32_t maxWritePackets, std::uint32_t sendCount, HandleCallback handleCallback, void* userData)
+	// Room for the block header and alignment
+	static std::uint32_t AllocatorSize(std::uint32_t size)
+	{
+		return size + Utils::BlockAllocator::s_HeaderSize + Utils::BlockAllocator::s_Alignment;
+	}
+
+	static Clock::duration Seconds(float seconds)
+	{
+		return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(seconds));
+	}
+
+	static std::uint32_t RequiredSections(std::uint32_t size, std::uint32_t sectionSize)
+	{
+		return sectionSize ? (size + sectionSize - 1U) / sectionSize : 0U;
+	}
+
+	template <class Info>
+	static bool IsSequencedSlot(const Info& info, Networking::Endpoint endpoint, std::uint16_t channel)
+	{
+		return info.m_ID && info.m_Delivery == EDelivery::Sequenced && info.m_Endpoint == endpoint && info.m_Channel == channel;
+	}
+
+	// 12 bit sequence numbers, up to half the range ahead counts as newer
+	static bool IsSequenceAhead(std::uint32_t sequence, std::uint32_t latest)
+	{
+		std::uint32_t distance { (sequence - latest) & 0xFFFU };
+		return distance && distance < 0x800U;
+	}
+
+	// Prefixes every packet in the receive and send rings
+	struct RingRecord
+	{
+	public:
+		Networking::Endpoint m_Endpoint;
+		std::uint32_t        m_Size { 0U };
+		EDelivery            m_Delivery { EDelivery::Reliable };
+		std::uint16_t        m_Channel { 0U };
+		bool                 m_Coalesced { false };
+		bool                 m_Stream { false };
+		std::uint16_t        m_ID { 0U };
+		std::uint32_t        m_Offset { 0U };
+		std::uint32_t        m_TotalSize { 0U };
+	};
+
+	static constexpr std::uint32_t s_CoalescePrefix = sizeof(std::uint16_t);
+
+	static bool IsOrderAhead(std::uint16_t order, std::uint16_t expected)
+	{
+		return static_cast<std::int16_t>(order - expected) > 0;
+	}
+
+	static void FillSectionHeader(PacketHeader& header, const WritePacketInfo& info, std::uint32_t index)
+	{
+		header         = {};
+		header.m_ID    = info.m_Sequence;
+		header.m_Index = index;
+		header.m_Rev   = info.m_Rev;
+		header.m_Size  = info.m_Size;
+
+		header.m_SectionSize = static_cast<std::uint16_t>(info.m_SectionSize);
+		header.m_Flags       = (info.m_Delivery == EDelivery::Sequenced ? PacketFlag::Unreliable : 0U) | (info.m_Ordered ? PacketFlag::Ordered : 0U) | (info.m_Coalesced ? PacketFlag::Coalesced : 0U);
+		header.m_Channel     = static_cast<std::uint8_t>(info.m_Channel);
+		header.m_ParityGroup = info.m_ParityGroup;
+		header.m_Order       = info.m_Order;
+	}
+
+	// Read callback streams wait for the oldest section of their window
+	static bool IsStreamWindowFull(const WritePacketInfo& info)
+	{
+		return info.m_Stream && info.m_StreamWindow && std::max(info.m_SendIndex, info.m_StreamBase) - info.m_StreamBase >= info.m_StreamWindow;
+	}
+
+	// More than 32 sections keep their bits in a separate allocation
+	template <class Info>
+	static bool HasDynamicBits(const Info& info)
+	{
+		return RequiredSections(info.m_Size, info.m_SectionSize) > 32;
+	}
+
+	template <class Info>
+	static bool TestSectionBit(const Info& info, std::uint32_t index)
+	{
+		if (HasDynamicBits(info))
+			return (info.m_BitsDynamic[index / 8] >> (index % 8)) & 1U;
+		return (info.m_Bits >> index) & 1U;
+	}
+
+	template <class Info>
+	static void SetSectionBit(Info& info, std::uint32_t index)
+	{
+		if (HasDynamicBits(info))
+			info.m_BitsDynamic[index / 8] |= 1U << (index % 8);
+		else
+			info.m_Bits |= 1U << index;
+	}
+
+	template <class Info>
+	static bool AllSectionBitsSet(const Info& info, std::uint32_t totalSections)
+	{
+		if (!HasDynamicBits(info))
+			return info.m_Bits == ~0U;
+
+		for (std::uint32_t byte = 0; byte < (totalSections + 7) / 8; ++byte)
+			if (info.m_BitsDynamic[byte] != static_cast<std::uint8_t>(~0U))
+				return false;
+		return true;
+	}
+
+	template <class Info>
+	static void ResetSectionBits(Info& info, std::uint32_t totalSections)
+	{
+		if (HasDynamicBits(info))
+		{
+			// Bits past the last section count as set
+			std::uint32_t numBytes = (totalSections + 7) / 8;
+			std::memset(info.m_BitsDynamic, 0, numBytes);
+			for (std::uint32_t j = totalSections; j < numBytes * 8; ++j)
+				info.m_BitsDynamic[j / 8] |= 1U << (j % 8);
+		}
+		else
+		{
+			info.m_Bits = 0U;
+			for (std::uint32_t j = totalSections; j < 32; ++j)
+				info.m_Bits |= 1U << j;
+		}
+	}
+
+	PacketHandler::PacketHandler(std::uint32_t readBufferSize, std::uint32_t writeBufferSize, std::uint32_t maxReadPackets, std::uint32_t maxWritePackets, std::uint32_t sendCount, HandleCallback handleCallback, void* userData, std::uint32_t batchSize, std::uint32_t maxDatagramSize)
 	    : m_Socket(Networking::ESocketType::UDP),
-	      m_ReadBufferSize(readBufferSize + 4096U),
-	      m_WriteBufferSize(writeBufferSize + 4096U),
-	      m_UsedReadBufferSize(4096U),
-	      m_UsedWriteBufferSize(4096U),
+	      m_ReadBufferSize(AllocatorSize(readBufferSize) + 4096U),
+	      m_WriteBufferSize(AllocatorSize(writeBufferSize) + 4096U),
 	      m_ReadBuffer(new std::uint8_t[m_ReadBufferSize]),
 	      m_WriteBuffer(new std::uint8_t[m_WriteBufferSize]),
+	      m_ReadAllocator(m_ReadBuffer + 4096U, m_ReadBufferSize - 4096U),
+	      m_WriteAllocator(m_WriteBuffer + 4096U, m_WriteBufferSize - 4096U),
 	      m_MaxReadPackets(maxReadPackets),
 	      m_MaxWritePackets(maxWritePackets),
 	      m_ReadPacketInfos(new ReadPacketInfo[m_MaxReadPackets]),
 	      m_WritePacketInfos(new WritePacketInfo[m_MaxWritePackets]),
-	      m_ToSend(sendCount),
+	      m_FreeReadSlots(new std::uint32_t[m_MaxReadPackets]),
+	      m_FreeWriteSlots(new std::uint32_t[m_MaxWritePackets]),
+	      m_FreeReadSlotCount(m_MaxReadPackets),
+	      m_FreeWriteSlotCount(m_MaxWritePackets),
+	      m_PendingAcks(new std::uint32_t[m_MaxReadPackets]),
 	      m_SendCount(sendCount),
+	      m_SendQueue(new std::uint32_t[m_MaxWritePackets]),
+	      m_SendList(new std::uint32_t[m_MaxWritePackets]),
+	      m_BatchSize(batchSize ? batchSize : 1U),
+	      m_MaxDatagramSize(std::clamp(maxDatagramSize, 256U, 65507U)),
+	      m_ReceiveBatch(new std::uint8_t[m_BatchSize * m_MaxDatagramSize]),
+	      m_SendBatch(new std::uint8_t[m_BatchSize * m_MaxDatagramSize]),
+	      m_ReceiveDatagrams(new Networking::Datagram[m_BatchSize]),
+	      m_SendDatagrams(new Networking::Datagram[m_BatchSize]),
+	      m_SendAddresses(new Networking::SocketAddress[m_BatchSize]),
+	      m_MaxPeers(m_MaxReadPackets + m_MaxWritePackets),
+	      m_PeerInfos(new PeerInfo[m_MaxPeers]),
+	      m_PeerIndex(m_MaxPeers),
+	      m_ReadPacketIndex(m_MaxReadPackets),
+	      m_WritePacketIndex(m_MaxWritePackets),
+	      m_SentPacketIndex(m_MaxWritePackets),
+	      m_HeldPacketIndex(m_MaxReadPackets),
+	      m_Timers(m_MaxReadPackets + 2U * m_MaxWritePackets + m_MaxPeers),
 	      m_HandleCallback(handleCallback),
-	      m_UserData(userData),
-	      m_LastSendout(Clock::now())
+	      m_UserData(userData)
 	{
+		// Popped from the back, lowest slots first
+		for (std::uint32_t i { 0 }; i < m_MaxReadPackets; ++i)
+			m_FreeReadSlots[i] = m_MaxReadPackets - 1 - i;
+		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
+			m_FreeWriteSlots[i] = m_MaxWritePackets - 1 - i;
+		for (std::uint16_t i { 0 }; i < s_MaxChannels; ++i)
+			m_ChannelOrder[i] = i;
+		for (std::uint32_t i { 0 }; i < m_MaxPeers; ++i)
+			linkPeer(i);
+		// The default kernel buffers overflow long before the packet buffers on bursts of large packets
+		m_Socket.setBufferSizes(readBufferSize, writeBufferSize);
 	}
 
 	PacketHandler::~PacketHandler()
 	{
+		stopThread();
 		if (m_ReadBuffer)
 			delete[] m_ReadBuffer;
 		if (m_WriteBuffer)
@@ -35,6 +197,28 @@ namespace ReliableUDP
 			delete[] m_ReadPacketInfos;
 		if (m_WritePacketInfos)
 			delete[] m_WritePacketInfos;
+		if (m_FreeReadSlots)
+			delete[] m_FreeReadSlots;
+		if (m_FreeWriteSlots)
+			delete[] m_FreeWriteSlots;
+		if (m_PendingAcks)
+			delete[] m_PendingAcks;
+		if (m_SendQueue)
+			delete[] m_SendQueue;
+		if (m_SendList)
+			delete[] m_SendList;
+		if (m_ReceiveBatch)
+			delete[] m_ReceiveBatch;
+		if (m_SendBatch)
+			delete[] m_SendBatch;
+		if (m_ReceiveDatagrams)
+			delete[] m_ReceiveDatagrams;
+		if (m_SendDatagrams)
+			delete[] m_SendDatagrams;
+		if (m_SendAddresses)
+			delete[] m_SendAddresses;
+		if (m_PeerInfos)
+			delete[] m_PeerInfos;
 		m_ReadBufferSize   = 0U;
 		m_WriteBufferSize  = 0U;
 		m_MaxReadPackets   = 0U;
@@ -43,6 +227,18 @@ namespace ReliableUDP
 		m_WriteBuffer      = nullptr;
 		m_ReadPacketInfos  = nullptr;
 		m_WritePacketInfos = nullptr;
+		m_FreeReadSlots    = nullptr;
+		m_FreeWriteSlots   = nullptr;
+		m_PendingAcks      = nullptr;
+		m_SendQueue        = nullptr;
+		m_SendList         = nullptr;
+		m_ReceiveBatch     = nullptr;
+		m_SendBatch        = nullptr;
+		m_ReceiveDatagrams = nullptr;
+		m_SendDatagrams    = nullptr;
+		m_SendAddresses    = nullptr;
+		m_PeerInfos        = nullptr;
+		m_MaxPeers         = 0U;
 	}
 
 	void PacketHandler::updatePackets()
@@ -51,772 +247,2414 @@ namespace ReliableUDP
 			return;
 
 		Clock::time_point now = Clock::now();
-		for (std::uint32_t i { 0 }; i < m_MaxReadPackets; ++i)
+		if (m_RetryHeld)
 		{
-			ReadPacketInfo& info { m_ReadPacketInfos[i] };
-			if (!info.m_ID)
-				continue;
-
-			if (info.m_Time.time_since_epoch().count() && std::chrono::duration_cast<std::chrono::duration<float>>(now - info.m_Time).count() >= m_ReadTimeout)
+			// The receive ring had no room for these yet
+			m_RetryHeld = false;
+			for (std::uint32_t i { 0 }; i < m_MaxReadPackets; ++i)
 			{
-				freeReadPacket(info.m_ID);
+				ReadPacketInfo& info { m_ReadPacketInfos[i] };
+				if (info.m_ID && info.m_Stream)
+					deliverStreamSections(i);
+				else if (info.m_ID && info.m_Held && (!info.m_Ordered || info.m_Order == m_PeerInfos[info.m_Peer].m_Channels[info.m_Channel].m_ReceiveOrder))
+					deliverReadSlot(i);
 			}
 		}
 
-		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
+		// A timeout pushed back since it was scheduled gets scheduled again
+		std::uint64_t nowTick { static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - m_TimerStart).count()) };
+		for (std::uint32_t timer { m_Timers.popExpired(nowTick) }; timer != Utils::TimerWheel::s_Invalid; timer = m_Timers.popExpired(nowTick))
 		{
-			WritePacketInfo& info { m_WritePacketInfos[i] };
-			if (!info.m_ID || !info.m_Ready)
+			if (timer >= m_MaxReadPackets + 2U * m_MaxWritePackets)
+			{
+				updatePeer(m_PeerInfos[timer - m_MaxReadPackets - 2U * m_MaxWritePackets], now);
 				continue;
-
-			if (info.m_Time.time_since_epoch().count() && std::chrono::duration_cast<std::chrono::duration<float>>(now - info.m_Time).count() >= m_WriteTimeout)
+			}
+			if (timer >= m_MaxReadPackets + m_MaxWritePackets)
 			{
-				freeWritePacket(info.m_ID);
+				std::uint32_t slot { timer - m_MaxReadPackets - m_MaxWritePackets };
+				if (m_WritePacketInfos[slot].m_Ready)
+					listWriteSlot(slot);
+				continue;
 			}
-		}
+			if (timer >= m_MaxReadPackets)
+			{
+				std::uint32_t    slot { timer - m_MaxReadPackets };
+				WritePacketInfo& info { m_WritePacketInfos[slot] };
+				if (info.m_ID && info.m_Coalescing)
+				{
+					flushCoalescedSlot(slot);
+					continue;
+				}
+				if (!info.m_ID || !info.m_Ready || !info.m_Time.time_since_epoch().count())
+					continue;
 
-		Networking::Endpoint endpoint {};
-		std::size_t          size { 0U };
-		while ((size = m_Socket.readFrom(m_ReadBuffer, 4096U, endpoint)))
-		{
-			if (size < 8)
+				if (std::chrono::duration_cast<std::chrono::duration<float>>(now - info.m_Time).count() < m_WriteTimeout)
+				{
+					setWriteTime(slot, info.m_Time);
+					continue;
+				}
+				m_Stats.m_WriteTimeouts.add();
+				freeWriteSlot(slot);
 				continue;
+			}
 
-			auto header { reinterpret_cast<PacketHeader*>(m_ReadBuffer) };
-			if (!IsMagicNumberValid(header->m_MagicNumber))
+			std::uint32_t   i { timer };
+			ReadPacketInfo& info { m_ReadPacketInfos[i] };
+			if (!info.m_ID || !info.m_Time.time_since_epoch().count())
 				continue;
 
-			if (hasHandledPacketID(header->m_ID))
+			if (std::chrono::duration_cast<std::chrono::duration<float>>(now - info.m_Time).count() < m_ReadTimeout)
+			{
+				setReadTime(i, info.m_Time);
 				continue;
+			}
 
-			auto type { GetPacketHeaderType(header->m_MagicNumber) };
-			switch (type)
+			// Streams wait for room in the receive ring to hand off the rest or the timeout
+			if (info.m_Stream && (readPacketDone(info.m_Endpoint, info.m_ID) || !handOffStream(info.m_Endpoint, info.m_ID, info.m_StreamBase * info.m_SectionSize, nullptr, 0U, info.m_Size)))
 			{
-			case EPacketHeaderType::Normal:
+				setReadTime(i, now);
+				continue;
+			}
+			if (!info.m_Held)
 			{
-				std::size_t i { 0U };
-				for (; i < m_MaxReadPackets; ++i)
-					if (m_ReadPacketInfos[i].m_ID == header->m_ID)
-						break;
+				m_Stats.m_ReadTimeouts.add();
+				freeReadSlot(i);
+				continue;
+			}
+			// Acknowledged unordered packets only wait for room in the receive ring
+			if (!info.m_Ordered)
+			{
+				setReadTime(i, now);
+				continue;
+			}
 
-				if (i == m_MaxReadPackets)
+			// Skips the channel ahead to the earliest held packet, looking up the orders in between unless there are more than slots
+			PeerInfo&        peer { m_PeerInfos[info.m_Peer] };
+			std::uint16_t    channel { info.m_Channel };
+			PeerChannelInfo& state { peer.m_Channels[channel] };
+			std::uint16_t    earliest { info.m_Order };
+			std::uint16_t    gap { static_cast<std::uint16_t>(earliest - state.m_ReceiveOrder) };
+			if (gap <= m_MaxReadPackets)
+			{
+				for (std::uint16_t order { state.m_ReceiveOrder }; order != earliest; ++order)
 				{
-					if (!allocateReadPacket(header->m_Size, header->m_ID, header->m_Rev, endpoint))
+					if (m_HeldPacketIndex.contains({ peer.m_Endpoint, channel, order }))
 					{
-						rejectPacket(endpoint, header->m_ID, header->m_Rev);
-						continue;
+						earliest = order;
+						break;
 					}
 				}
-				else if (hasHandledSection(header->m_ID, header->m_Index, header->m_Rev))
-				{
-					continue;
-				}
-
-				if (!receivedSection(header->m_ID, header->m_Index, header->m_Rev))
-				{
-					rejectPacket(endpoint, header->m_ID, header->m_Rev);
-					continue;
-				}
-				acknowledgePacket(endpoint, header->m_ID, header->m_Index, header->m_Rev);
-				if (readPacketDone(header->m_ID))
+			}
+			else
+			{
+				for (std::uint32_t j { 0 }; j < m_MaxReadPackets; ++j)
 				{
-					m_HandledPacketIDs.insert(header->m_ID);
-					if (m_HandleCallback)
+					const ReadPacketInfo& other { m_ReadPacketInfos[j] };
+					if (other.m_Held && other.m_Ordered && other.m_Channel == channel && other.m_Endpoint == peer.m_Endpoint && static_cast<std::uint16_t>(other.m_Order - state.m_ReceiveOrder) < gap)
 					{
-						std::uint32_t packetSize { 0U };
-						std::uint8_t* ptr { getReadPacket(header->m_ID, packetSize) };
-						m_HandleCallback(this, endpoint, ptr, packetSize);
+						earliest = other.m_Order;
+						gap      = static_cast<std::uint16_t>(earliest - state.m_ReceiveOrder);
 					}
-					freeReadPacket(header->m_ID);
 				}
-				break;
 			}
-			case EPacketHeaderType::Acknowledge:
-			{
-				auto acknowledgeHeader { reinterpret_cast<AcknowledgePacketHeader*>(m_ReadBuffer) };
-
-				std::uint32_t i { 0U };
-				for (; i < m_MaxWritePackets; ++i)
-					if (m_WritePacketInfos[i].m_ID == acknowledgeHeader->m_ID)
-						break;
-
-				if (i == m_MaxWritePackets)
-					continue;
-
-				WritePacketInfo& info = m_WritePacketInfos[i];
-				if (info.m_Rev != acknowledgeHeader->m_Rev)
-					continue;
+			state.m_ReceiveOrder = earliest;
+			deliverHeldPackets(peer, channel);
+		}
 
-				if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
-				{
-					if (acknowledgeHeader->m_Index >= getRequiredSections(info.m_Size))
-						continue;
+		std::size_t received { 0U };
+		do
+		{
+			for (std::uint32_t i { 0 }; i < m_BatchSize; ++i)
+				m_ReceiveDatagrams[i] = { m_ReceiveBatch + i * m_MaxDatagramSize, m_MaxDatagramSize, {} };
 
-					std::uint32_t bit  = acknowledgeHeader->m_Index % 8;
-					std::uint32_t byte = acknowledgeHeader->m_Index / 8;
+			received = m_Socket.readFromMany(m_ReceiveDatagrams, m_BatchSize);
+			m_Stats.m_DatagramsReceived.add(received);
+			for (std::size_t i { 0 }; i < received; ++i)
+			{
+				Networking::Datagram& datagram { m_ReceiveDatagrams[i] };
+				m_Stats.m_BytesReceived.add(datagram.m_Size);
+				handleDatagram(reinterpret_cast<std::uint8_t*>(datagram.m_Buffer), datagram.m_Size, datagram.m_Endpoint);
+			}
+		} while (received == m_BatchSize);
+
+		flushAcknowledges();
+
+		// Copied since preparing can take packets off the list.
+		// Control replies go out right away
+		std::uint32_t channelStarts[s_MaxChannels + 1U] {};
+		std::uint32_t queued { 0U };
+		std::uint32_t listed { m_SendListCount };
+		std::copy(m_SendList, m_SendList + listed, m_SendQueue);
+		m_SendPending = false;
+		for (std::uint32_t n { 0 }; n < listed; ++n)
+		{
+			std::uint32_t    slot { m_SendQueue[n] };
+			WritePacketInfo& info { m_WritePacketInfos[slot] };
+			if (!info.m_Ready)
+				continue;
 
-					info.m_BitsDynamic[byte] |= 1 << bit;
-				}
-				else
+			switch (info.m_Type)
+			{
+			case EPacketHeaderType::Normal:
+			{
+				if (prepareWritePacket(slot, now))
 				{
-					info.m_Bits |= 1 << acknowledgeHeader->m_Index;
+					m_SendQueue[queued++] = slot;
+					++channelStarts[info.m_Channel + 1U];
 				}
-
-				info.m_Time = Clock::now();
-
+				break;
+			}
+			case EPacketHeaderType::Acknowledge:
+			{
+				releaseWriteSlot(slot);
 				break;
 			}
 			case EPacketHeaderType::Reject:
 			{
-				auto rejectHeader { reinterpret_cast<RejectPacketHeader*>(m_ReadBuffer) };
-
-				std::uint32_t i { 0U };
-				for (; i < m_MaxWritePackets; ++i)
-					if (m_WritePacketInfos[i].m_ID == rejectHeader->m_ID)
-						break;
-
-				if (i == m_MaxWritePackets)
-					continue;
-
-				WritePacketInfo& info = m_WritePacketInfos[i];
-				if (info.m_Rev == rejectHeader->m_Rev)
-				{
-					// TODO(MarcasRealAccount): Report premature packet rejection
-					freeWritePacket(rejectHeader->m_ID);
-				}
-
+				auto header { reinterpret_cast<RejectPacketHeader*>(beginDatagram()) };
+				*header         = {};
+				header->m_ID    = info.m_ID;
+				header->m_Index = 0U;
+				header->m_Rev   = info.m_Rev;
+				endDatagram(sizeof(RejectPacketHeader), info.m_Endpoint);
+				releaseWriteSlot(slot);
 				break;
 			}
 			case EPacketHeaderType::MaxSize:
 			{
-				auto maxSizeHeader { reinterpret_cast<MaxSizePacketHeader*>(m_ReadBuffer) };
-				if (!maxSizeHeader->m_Size)
-				{
-					sendMaxSizePacket(endpoint, maxSizeHeader->m_ID);
-				}
-				else
-				{
-					// TODO(MarcasRealAccount): What to do here???
-				}
+				auto header { reinterpret_cast<MaxSizePacketHeader*>(beginDatagram()) };
+				*header        = {};
+				header->m_ID   = info.m_ID;
+				header->m_Size = maxReadPacketSize();
+
+				header->m_DatagramSize = static_cast<std::uint16_t>(m_MaxDatagramSize);
+				endDatagram(sizeof(MaxSizePacketHeader), info.m_Endpoint);
+				releaseWriteSlot(slot);
 				break;
 			}
 			}
 		}
 
-		bool canSendOldPackets { std::chrono::duration_cast<std::chrono::duration<float>>(now - m_LastSendout).count() > m_SendoutTimer };
-		if (canSendOldPackets)
-		{
-			m_ToSend      = m_SendCount;
-			m_LastSendout = now;
-		}
+		for (std::uint32_t channel { 0 }; channel < s_MaxChannels; ++channel)
+			channelStarts[channel + 1U] += channelStarts[channel];
+		std::sort(m_SendQueue, m_SendQueue + queued, [this](std::uint32_t lhs, std::uint32_t rhs) { return sendsBefore(lhs, rhs); });
+		m_SendPacket = (m_SendPacket + 1) % m_MaxWritePackets;
 
-		std::uint32_t lastPacket { m_SendPacket == 0U ? m_MaxWritePackets - 1 : m_SendPacket - 1 };
-		while (m_SendPacket != lastPacket && m_ToSend)
+		// Strict priority between levels, weighted turns within one
+		for (std::uint32_t first { 0 }, last { 0 }; first < s_MaxChannels; first = last)
 		{
-			WritePacketInfo& info { m_WritePacketInfos[m_SendPacket] };
-			if (info.m_Ready && (!info.m_Time.time_since_epoch().count() || canSendOldPackets))
+			std::uint8_t priority { m_Channels[m_ChannelOrder[first]].m_Priority };
+			for (last = first + 1U; last < s_MaxChannels && m_Channels[m_ChannelOrder[last]].m_Priority == priority; ++last)
+				;
+
+			bool progress { true };
+			while (progress)
 			{
-				std::uint32_t requiredSections { getRequiredSections(info.m_Size) };
-				if (m_ToSend)
+				progress = false;
+				for (std::uint32_t i { first }; i < last; ++i)
 				{
-					switch (info.m_Type)
+					std::uint16_t channel { m_ChannelOrder[i] };
+					std::uint32_t budget { m_Channels[channel].m_Weight };
+					for (std::uint32_t q { channelStarts[channel] }; q < channelStarts[channel + 1U] && budget; ++q)
 					{
-					case EPacketHeaderType::Normal:
-					{
-						while (m_SendIndex < requiredSections && m_ToSend)
-						{
-							std::uint32_t offset { static_cast<std::uint32_t>(m_SendIndex * (4096 - sizeof(PacketHeader))) };
-							std::uint32_t size { std::min<std::uint32_t>(4096 - sizeof(PacketHeader), info.m_Size - offset) };
-							auto          header { reinterpret_cast<PacketHeader*>(m_WriteBuffer) };
-							*header         = {};
-							header->m_ID    = info.m_ID;
-							header->m_Index = m_SendIndex;
-							header->m_Rev   = info.m_Rev;
-							header->m_Size  = info.m_Size;
-							std::memcpy(m_WriteBuffer + sizeof(PacketHeader), m_WriteBuffer + info.m_Start + offset, size);
-							m_Socket.writeTo(m_WriteBuffer, size + sizeof(PacketHeader), info.m_Endpoint);
-							++m_SendIndex;
-						}
-
-						if (m_SendIndex >= requiredSections)
-						{
-							m_SendIndex  = 0U;
-							m_SendPacket = (m_SendPacket + 1) % m_MaxWritePackets;
-						}
-						break;
-					}
-					case EPacketHeaderType::Acknowledge:
-					{
-						auto header { reinterpret_cast<AcknowledgePacketHeader*>(m_WriteBuffer) };
-						*header         = {};
-						header->m_ID    = info.m_ID;
-						header->m_Index = info.m_Index;
-						header->m_Rev   = info.m_Rev;
-						m_Socket.writeTo(m_WriteBuffer, sizeof(AcknowledgePacketHeader), info.m_Endpoint);
-						m_SendPacket = (m_SendPacket + 1) % m_MaxWritePackets;
-						break;
-					}
-					case EPacketHeaderType::Reject:
-					{
-						auto header { reinterpret_cast<RejectPacketHeader*>(m_WriteBuffer) };
-						*header         = {};
-						header->m_ID    = info.m_ID;
-						header->m_Index = 0U;
-						header->m_Rev   = info.m_Rev;
-						m_Socket.writeTo(m_WriteBuffer, sizeof(RejectPacketHeader), info.m_Endpoint);
-						m_SendPacket = (m_SendPacket + 1) % m_MaxWritePackets;
-						break;
-					}
-					case EPacketHeaderType::MaxSize:
-					{
-						auto header { reinterpret_cast<MaxSizePacketHeader*>(m_WriteBuffer) };
-						*header        = {};
-						header->m_ID   = info.m_ID;
-						header->m_Size = m_ReadBufferSize - 4096U;
-						m_Socket.writeTo(m_WriteBuffer, sizeof(MaxSizePacketHeader), info.m_Endpoint);
-						m_SendPacket = (m_SendPacket + 1) % m_MaxWritePackets;
-						break;
-					}
+						std::uint32_t sent { sendSections(m_SendQueue[q], now, budget) };
+						budget -= std::min(sent, budget);
+						progress = progress || sent;
 					}
 				}
 			}
-			else
-			{
-				m_SendPacket = (m_SendPacket + 1) % m_MaxWritePackets;
-			}
 		}
-	}
 
-	std::uint32_t PacketHandler::availableReadPackets() const
-	{
-		std::uint32_t usedPacketInfos { 0U };
-		for (std::uint32_t i { 0 }; i < m_MaxReadPackets; ++i)
+		flushDatagrams();
+
+		// Sent sequenced packets and aborted streams.
+		// Backwards, since freeing moves the last listed slot
+		for (std::uint32_t n { m_SendListCount }; n-- > 0U;)
 		{
-			ReadPacketInfo& info = m_ReadPacketInfos[i];
-			if (info.m_ID)
-				++usedPacketInfos;
+			if (n >= m_SendListCount)
+				continue;
+
+			std::uint32_t    slot { m_SendList[n] };
+			WritePacketInfo& info { m_WritePacketInfos[slot] };
+			if (info.m_SectionSize && !info.m_Ready)
+				freeWriteSlot(slot);
 		}
-		return m_MaxReadPackets - usedPacketInfos;
-	}
 
-	std::uint32_t PacketHandler::availableWritePackets() const
-	{
-		std::uint32_t usedPacketInfos { 0U };
-		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
+		// Still listed slots ran out of tokens or window
+		for (std::uint32_t n { 0 }; n < m_SendListCount; ++n)
 		{
-			WritePacketInfo& info = m_WritePacketInfos[i];
-			if (info.m_ID)
-				++usedPacketInfos;
+			std::uint32_t    slot { m_SendList[n] };
+			WritePacketInfo& info { m_WritePacketInfos[slot] };
+			if (!info.m_SectionSize)
+				continue;
+
+			const PeerInfo&   peer { packetPeer(info) };
+			Clock::time_point wake { now + Seconds(peer.m_RoundTrip.getRetransmitTimeout()) };
+			if (IsStreamWindowFull(info))
+				wake = info.m_SendTime + Seconds(peer.m_RoundTrip.getBackoffTimeout(info.m_Retransmissions));
+			else if (peer.m_Congestion.getInFlight() < peer.m_Congestion.getWindow())
+				wake = now + Seconds(std::max(1.0f - peer.m_Congestion.getTokens(), 0.0f) / peer.m_Congestion.getPacingRate(peer.m_RoundTrip));
+			m_Timers.schedule(m_MaxReadPackets + m_MaxWritePackets + slot, deadlineTick(wake));
 		}
-		return m_MaxWritePackets - usedPacketInfos;
-	}
 
-	std::uint32_t PacketHandler::availableReadPacketSize() const
-	{
-		return m_ReadBufferSize - m_UsedReadBufferSize;
+		m_Stats.m_ReadPacketsUsed.set(m_MaxReadPackets - m_FreeReadSlotCount);
+		m_Stats.m_WritePacketsUsed.set(m_MaxWritePackets - m_FreeWriteSlotCount);
+		m_Stats.m_ReadBufferUsed.set(m_ReadAllocator.getUsed());
+		m_Stats.m_WriteBufferUsed.set(m_WriteAllocator.getUsed());
+		m_Stats.m_SendQueueDepth.set(m_ReadyPackets);
+		m_Stats.m_ReceiveRingUsed.set(m_ReceiveRing ? m_ReceiveRing->getUsed() : 0U);
+		m_Stats.m_SendRingUsed.set(m_SendRing ? m_SendRing->getUsed() : 0U);
 	}
 
-	std::uint32_t PacketHandler::availableWritePacketSize() const
+	void PacketHandler::waitAndUpdate(float timeout)
 	{
-		return m_WriteBufferSize - m_UsedWriteBufferSize;
+		if (!m_Socket.isBound())
+			return;
+
+		Clock::time_point now { Clock::now() };
+		Clock::time_point deadline { std::min(getNextDeadline(now), now + Seconds(timeout)) };
+		if (deadline > now)
+			m_Socket.waitReadable(static_cast<std::uint32_t>(std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count()));
+		updatePackets();
 	}
 
-	std::uint8_t* PacketHandler::getReadPacket(std::uint16_t id, std::uint32_t& size)
+	Clock::time_point PacketHandler::getNextDeadline(Clock::time_point now) const
 	{
-		if (!id)
-			return nullptr;
-
-		for (std::uint32_t i { 0 }; i < m_MaxReadPackets; ++i)
-		{
-			ReadPacketInfo& info = m_ReadPacketInfos[i];
-			if (info.m_ID != id || !info.m_Size)
-				continue;
+		if (m_RetryHeld || m_SendPending)
+			return now;
 
-			size = info.m_Size;
-			return m_ReadBuffer + info.m_Start;
-		}
-		return nullptr;
+		std::uint64_t tick { m_Timers.nextTick() };
+		return tick != ~0ULL ? m_TimerStart + std::chrono::milliseconds(tick) : Clock::time_point::max();
 	}
 
-	std::uint8_t* PacketHandler::getWritePacket(std::uint16_t id, std::uint32_t& size)
+	bool PacketHandler::startThread(std::uint32_t receiveRingSize, std::uint32_t sendRingSize)
 	{
-		if (!id)
-			return nullptr;
+		if (!m_Socket.isBound() || isThreaded())
+			return false;
 
-		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
-		{
-			WritePacketInfo& info = m_WritePacketInfos[i];
-			if (info.m_ID != id || !info.m_Size)
-				continue;
+		m_WakeSocket.setErrorCallback(m_Socket.getErrorCallback(), m_Socket.getUserData());
+		// 127.0.0.1 in host byte order
+		if (!m_WakeSocket.bind({ Networking::IPv4Address { 0x7F000001U }, 0U }))
+			return false;
 
-			size = info.m_Size;
-			return m_WriteBuffer + info.m_Start;
-		}
-		return nullptr;
+		// Any packet that fits a buffer also fits its ring
+		m_ReceiveRing = receiveRingSize ? new Utils::SPSCRing(std::max(receiveRingSize, m_ReadBufferSize)) : nullptr;
+		m_SendRing    = new Utils::SPSCRing(std::max(sendRingSize, m_WriteBufferSize));
+		m_WakePending.store(false);
+		m_Running.store(true);
+		m_Thread = std::thread { &PacketHandler::threadFunc, this };
+		return true;
 	}
 
-	void PacketHandler::markWritePacketReady(std::uint16_t id)
+	void PacketHandler::stopThread()
 	{
-		if (!id)
+		if (!isThreaded())
 			return;
 
-		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
-		{
-			WritePacketInfo& info = m_WritePacketInfos[i];
-			if (info.m_ID == id)
-			{
-				info.m_Ready = true;
-				return;
-			}
-		}
+		m_Running.store(false);
+		wakeThread();
+		m_Thread.join();
+		m_WakeSocket.close();
+
+		// Queued packets still get sent, unhandled received ones are gone
+		drainSendRing();
+		delete m_ReceiveRing;
+		delete m_SendRing;
+		m_ReceiveRing = nullptr;
+		m_SendRing    = nullptr;
 	}
 
-	void PacketHandler::setPacketEndpoint(std::uint16_t id, Networking::Endpoint endpoint)
+	std::uint32_t PacketHandler::handleReceivedPackets()
 	{
-		if (!id)
-			return;
+		if (!m_ReceiveRing)
+			return 0U;
 
-		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
+		std::uint32_t handled { 0U };
+		std::uint32_t size { 0U };
+		while (std::uint8_t* entry { m_ReceiveRing->front(size) })
 		{
-			WritePacketInfo& info = m_WritePacketInfos[i];
-			if (info.m_ID == id)
-			{
-				info.m_Endpoint = endpoint;
-				return;
-			}
+			const RingRecord& record { *reinterpret_cast<const RingRecord*>(entry) };
+			if (!record.m_Stream)
+				dispatchPacket(record.m_Endpoint, entry + sizeof(RingRecord), record.m_Size, record.m_Coalesced);
+			else if (m_StreamCallback)
+				m_StreamCallback(this, record.m_Endpoint, record.m_ID, record.m_Offset, record.m_Size ? entry + sizeof(RingRecord) : nullptr, record.m_Size, record.m_TotalSize);
+			m_ReceiveRing->pop();
+			++handled;
 		}
+		return handled;
 	}
 
-	void PacketHandler::freeReadPacket(std::uint16_t id)
+	bool PacketHandler::sendPacket(Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery, std::uint16_t channel)
 	{
-		if (!id)
-			return;
+		if (channel >= s_MaxChannels)
+			return false;
 
-		std::uint32_t i { 0U };
-		for (; i < m_MaxReadPackets; ++i)
-			if (m_ReadPacketInfos[i].m_ID == id)
-				break;
+		if (!m_SendRing || isNetworkThread())
+			return queuePacket(endpoint, data, size, delivery, channel);
 
-		if (i == m_MaxReadPackets)
-			return;
+		std::uint8_t* entry { m_SendRing->reserve(static_cast<std::uint32_t>(sizeof(RingRecord)) + size) };
+		if (!entry)
+			return false;
 
-		ReadPacketInfo& info = m_ReadPacketInfos[i];
+		RingRecord& record { *reinterpret_cast<RingRecord*>(entry) };
+		record.m_Endpoint = endpoint;
+		record.m_Size     = size;
+		record.m_Delivery = delivery;
+		record.m_Channel  = channel;
+		std::memcpy(entry + sizeof(RingRecord), data, size);
+		m_SendRing->commit();
+		wakeThread();
+		return true;
+	}
+
+	std::uint16_t PacketHandler::sendStream(Networking::Endpoint endpoint, std::uint32_t size, const StreamSource& source, std::uint16_t channel, std::uint32_t windowSize)
+	{
+		if (m_SendRing || !size || (!source.m_Data && !source.m_Read) || channel >= s_MaxChannels || !availableWritePackets())
+			return 0U;
+		if (!fitsPeer(findPeer(endpoint), size))
+		{
+			m_Stats.m_OversizedPackets.add();
+			return 0U;
+		}
 
-		std::uint32_t start = info.m_Start;
-		std::uint32_t size  = info.m_Size;
-		std::memmove(m_ReadBuffer + start, m_ReadBuffer + start + size, m_ReadBufferSize - start - size);
-		for (std::uint32_t j = 0; j < m_MaxReadPackets; ++j)
+		// The window has to fit a section of the largest size
+		std::uint32_t start { ~0U };
+		if (!source.m_Data)
 		{
-			ReadPacketInfo& info = m_ReadPacketInfos[j];
-			if (info.m_Start > start)
-				info.m_Start -= size;
+			windowSize = std::max<std::uint32_t>(windowSize, m_MaxDatagramSize - sizeof(PacketHeader));
+			std::uint32_t offset { m_WriteAllocator.allocate(windowSize) };
+			if (offset == Utils::BlockAllocator::s_Invalid)
+				return 0U;
+			start = 4096U + offset;
 		}
 
-		if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
-			delete[] info.m_BitsDynamic;
-		info.m_ID       = 0U;
+		std::uint16_t id { newPacketID() };
+		std::uint32_t slot { acquireWriteSlot() };
+		if (!m_WritePacketIndex.insert(id, slot))
+		{
+			m_FreeWriteSlots[m_FreeWriteSlotCount++] = slot;
+			if (!source.m_Data)
+				m_WriteAllocator.free(start - 4096U);
+			return 0U;
+		}
+
+		WritePacketInfo& info { m_WritePacketInfos[slot] };
+		info.m_Type     = EPacketHeaderType::Normal;
+		info.m_ID       = id;
 		info.m_Rev      = 0U;
-		info.m_Start    = ~0U;
-		info.m_Size     = 0U;
-		info.m_Endpoint = {};
+		info.m_Start    = start;
+		info.m_Size     = size;
+		info.m_Endpoint = endpoint;
+		info.m_Delivery = EDelivery::Reliable;
+		info.m_Channel  = channel;
 		info.m_Bits     = 0U;
 		info.m_Time     = {};
+
+		info.m_SectionSize  = 0U;
+		info.m_Stream       = true;
+		info.m_Source       = source;
+		info.m_StreamWindow = source.m_Data ? 0U : windowSize;
+		markWritePacketReady(id);
+		return id;
 	}
 
-	void PacketHandler::freeWritePacket(std::uint16_t id)
+	bool PacketHandler::handOff(Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size, bool coalesced)
 	{
-		if (!id)
-			return;
-
-		std::uint32_t i { 0U };
-		for (; i < m_MaxWritePackets; ++i)
-			if (m_WritePacketInfos[i].m_ID == id)
-				break;
+		// Coalesced packets get split on the application thread
+		if (!m_ReceiveRing)
+		{
+			m_Stats.m_PacketsDelivered.add();
+			dispatchPacket(endpoint, packet, size, coalesced);
+			return true;
+		}
 
-		if (i == m_MaxWritePackets)
-			return;
+		std::uint8_t* entry { m_ReceiveRing->reserve(static_cast<std::uint32_t>(sizeof(RingRecord)) + size) };
+		if (!entry)
+			return false;
 
-		WritePacketInfo& info = m_WritePacketInfos[i];
+		// The ring memory still holds an old record
+		RingRecord& record { *new (entry) RingRecord {} };
+		record.m_Endpoint  = endpoint;
+		record.m_Size      = size;
+		record.m_Coalesced = coalesced;
+		std::memcpy(entry + sizeof(RingRecord), packet, size);
+		m_ReceiveRing->commit();
+		m_Stats.m_PacketsDelivered.add();
+		return true;
+	}
 
-		std::uint32_t start = info.m_Start;
-		std::uint32_t size  = info.m_Size;
-		std::memmove(m_WriteBuffer + start, m_WriteBuffer + start + size, m_WriteBufferSize - start - size);
-		for (std::uint32_t j = 0; j < m_MaxWritePackets; ++j)
+	bool PacketHandler::handOffStream(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t offset, std::uint8_t* packet, std::uint32_t size, std::uint32_t totalSize)
+	{
+		std::uint8_t* entry { nullptr };
+		if (m_ReceiveRing)
 		{
-			WritePacketInfo& info = m_WritePacketInfos[j];
-			if (info.m_Start > start)
-				info.m_Start -= size;
+			entry = m_ReceiveRing->reserve(static_cast<std::uint32_t>(sizeof(RingRecord)) + size);
+			if (!entry)
+				return false;
+		}
+		if (packet && offset + size == totalSize)
+			m_Stats.m_PacketsDelivered.add();
+		if (!entry)
+		{
+			if (m_StreamCallback)
+				m_StreamCallback(this, endpoint, id, offset, packet, size, totalSize);
+			return true;
 		}
 
-		if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
-			delete[] info.m_BitsDynamic;
-		info.m_Type     = EPacketHeaderType::Normal;
-		info.m_ID       = 0U;
-		info.m_Index    = 0U;
-		info.m_Rev      = 0U;
-		info.m_Start    = ~0U;
-		info.m_Size     = 0U;
-		info.m_Endpoint = {};
-		info.m_Ready    = false;
-		info.m_Bits     = 0U;
-		info.m_Time     = {};
+		RingRecord& record { *new (entry) RingRecord {} };
+		record.m_Endpoint  = endpoint;
+		record.m_Size      = size;
+		record.m_Stream    = true;
+		record.m_ID        = id;
+		record.m_Offset    = offset;
+		record.m_TotalSize = totalSize;
+		if (size)
+			std::memcpy(entry + sizeof(RingRecord), packet, size);
+		m_ReceiveRing->commit();
+		return true;
 	}
 
-	std::uint8_t* PacketHandler::allocateReadPacket(std::uint32_t size, std::uint16_t id, std::uint16_t rev, Networking::Endpoint endpoint)
+	void PacketHandler::dispatchPacket(Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size, bool coalesced)
 	{
-		if (!availableReadPackets())
+		if (!m_HandleCallback)
+			return;
+		if (!coalesced)
 		{
-			id = 0U;
-			return nullptr;
+			m_HandleCallback(this, endpoint, packet, size);
+			return;
 		}
 
-		std::uint32_t availableSize = availableReadPacketSize();
-		if (size > availableSize)
+		// Malformed, the rest is dropped
+		for (std::uint32_t offset { 0U }; size - offset >= s_CoalescePrefix;)
 		{
-			id = 0U;
-			return nullptr;
+			std::uint16_t messageSize { 0U };
+			std::memcpy(&messageSize, packet + offset, s_CoalescePrefix);
+			offset += s_CoalescePrefix;
+			if (messageSize > size - offset)
+				return;
+			m_HandleCallback(this, endpoint, packet + offset, messageSize);
+			offset += messageSize;
 		}
+	}
 
-		std::uint32_t start = m_ReadBufferSize - availableSize;
-		std::uint8_t* ptr   = m_ReadBuffer + start;
-		m_UsedReadBufferSize += size;
-
-		std::uint32_t i = 0;
-		for (; i < m_MaxReadPackets; ++i)
-			if (!m_ReadPacketInfos[i].m_ID)
-				break;
-
-		ReadPacketInfo& info { m_ReadPacketInfos[i] };
-		info.m_ID       = id;
-		info.m_Rev      = rev;
-		info.m_Start    = start;
-		info.m_Size     = size;
-		info.m_Endpoint = endpoint;
-		if (size > 32 * (4096 - sizeof(PacketHeader)))
+	bool PacketHandler::queuePacket(Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery, std::uint16_t channel)
+	{
+		PeerInfo* peer { findPeer(endpoint) };
+		if (!fitsPeer(peer, size))
 		{
-			std::uint32_t totalSections = getRequiredSections(size);
-			std::uint32_t numBytes      = (totalSections + 7) / 8;
-			info.m_BitsDynamic          = new std::uint8_t[numBytes] { 0U };
-			for (std::uint32_t i = 0; i < (numBytes * 8) - totalSections; ++i)
-				info.m_BitsDynamic[numBytes - 1] |= 1 << i;
+			m_Stats.m_OversizedPackets.add();
+			return false;
 		}
-		else
+
+		std::uint32_t slot { peer && m_CoalesceSize ? peer->m_CoalesceSlots[channel] : ~0U };
+		if (slot < m_MaxWritePackets && !(m_WritePacketInfos[slot].m_Coalescing && m_WritePacketInfos[slot].m_Endpoint == endpoint && m_WritePacketInfos[slot].m_Channel == channel))
+			slot = ~0U;
+
+		// Slots are allocated at m_CoalesceSize, but fill up only to what the peer accepts
+		std::uint32_t coalesceSize { peer && peer->m_MaxPacketSize ? std::min(m_CoalesceSize, peer->m_MaxPacketSize) : m_CoalesceSize };
+		bool          coalesce { coalesceSize && delivery == EDelivery::Reliable && s_CoalescePrefix + size <= coalesceSize };
+		if (slot != ~0U && (!coalesce || m_WritePacketInfos[slot].m_Size + s_CoalescePrefix + size > coalesceSize))
 		{
-			info.m_Bits                 = 0U;
-			std::uint32_t totalSections = getRequiredSections(size);
-			for (std::uint32_t i = totalSections; i < 32; ++i)
-				info.m_Bits |= 1 << i;
+			// Later packets must not overtake it on an ordered channel
+			flushCoalescedSlot(slot);
+			slot = ~0U;
 		}
-		info.m_Time = {};
-		return ptr;
-	}
 
-	std::uint8_t* PacketHandler::allocateWritePacket(std::uint32_t size, std::uint16_t& id)
-	{
-		if (!availableWritePackets())
+		if (!coalesce)
 		{
-			id = 0U;
-			return nullptr;
+			std::uint16_t id { 0U };
+			std::uint8_t* packet { allocateWritePacket(size, id, delivery, channel) };
+			if (!packet)
+				return false;
+			std::memcpy(packet, data, size);
+			setPacketEndpoint(id, endpoint);
+			return markWritePacketReady(id);
 		}
 
-		std::uint32_t availableSize = availableWritePacketSize();
-		if (size > availableSize)
+		if (slot == ~0U)
 		{
-			id = 0U;
-			return nullptr;
+			// m_Size grows with every message
+			std::uint16_t id { 0U };
+			if (!allocateWritePacket(m_CoalesceSize, id, EDelivery::Reliable, channel))
+				return false;
+
+			slot = findWriteSlot(id);
+			WritePacketInfo& info { m_WritePacketInfos[slot] };
+			info.m_Endpoint   = endpoint;
+			info.m_Size       = 0U;
+			info.m_Coalesced  = true;
+			info.m_Coalescing = true;
+			m_Timers.schedule(m_MaxReadPackets + slot, deadlineTick(Clock::now() + Seconds(m_CoalesceDelay)));
+			packetPeer(info).m_CoalesceSlots[channel] = slot;
 		}
 
-		id                  = newPacketID();
-		std::uint32_t start = m_WriteBufferSize - availableSize;
-		std::uint8_t* ptr   = m_WriteBuffer + start;
-		m_UsedWriteBufferSize += size;
+		WritePacketInfo& info { m_WritePacketInfos[slot] };
+		std::uint16_t    messageSize { static_cast<std::uint16_t>(size) };
+		std::uint8_t*    message { m_WriteBuffer + info.m_Start + info.m_Size };
+		std::memcpy(message, &messageSize, s_CoalescePrefix);
+		std::memcpy(message + s_CoalescePrefix, data, size);
+		info.m_Size += s_CoalescePrefix + size;
+		return true;
+	}
 
-		std::uint32_t i = 0;
-		for (; i < m_MaxWritePackets; ++i)
-			if (!m_WritePacketInfos[i].m_ID)
-				break;
+	void PacketHandler::flushCoalescedSlot(std::uint32_t slot)
+	{
+		WritePacketInfo& info { m_WritePacketInfos[slot] };
+		info.m_Coalescing = false;
+		m_Timers.cancel(m_MaxReadPackets + slot);
+		markWritePacketReady(info.m_ID);
+	}
 
-		WritePacketInfo& info { m_WritePacketInfos[i] };
-		info.m_Type     = EPacketHeaderType::Normal;
-		info.m_ID       = id;
-		info.m_Rev      = 0U;
-		info.m_Start    = start;
-		info.m_Size     = size;
-		info.m_Endpoint = {};
-		info.m_Ready    = false;
-		info.m_Time     = {};
-		return ptr;
+	void PacketHandler::setCoalescing(std::uint32_t maxSize, float delay)
+	{
+		flushCoalescedPackets();
+		m_CoalesceSize  = maxSize > s_CoalescePrefix ? std::min<std::uint32_t>(maxSize, 0xFFFFU) : 0U;
+		m_CoalesceDelay = delay;
 	}
 
-	void PacketHandler::acknowledgePacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint16_t index, std::uint16_t rev)
+	void PacketHandler::flushCoalescedPackets()
 	{
-		if (availableWritePackets())
+		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
 		{
-			std::uint32_t i = 0;
-			for (; i < m_MaxWritePackets; ++i)
-				if (!m_WritePacketInfos[i].m_ID)
-					break;
-
-			WritePacketInfo& info { m_WritePacketInfos[i] };
-			info.m_Type     = EPacketHeaderType::Acknowledge;
-			info.m_ID       = id;
-			info.m_Index    = index;
-			info.m_Rev      = rev;
-			info.m_Endpoint = endpoint;
-			info.m_Ready    = true;
-			info.m_Bits     = 0U;
-			info.m_Time     = {};
+			if (m_WritePacketInfos[i].m_Coalescing)
+				flushCoalescedSlot(i);
 		}
-		else
+	}
+
+	void PacketHandler::threadFunc()
+	{
+		Networking::Socket* sockets[2] { &m_Socket, &m_WakeSocket };
+		std::uint8_t        wake[16];
+		while (m_Running.load())
 		{
-			auto header     = reinterpret_cast<AcknowledgePacketHeader*>(m_WriteBuffer);
-			*header         = {};
-			header->m_ID    = id;
-			header->m_Index = index;
-			header->m_Rev   = rev;
-			m_Socket.writeTo(m_WriteBuffer, sizeof(AcknowledgePacketHeader), endpoint);
+			// Cleared before draining so new packets send another wake byte
+			m_WakePending.store(false);
+			Networking::Endpoint endpoint;
+			while (m_WakeSocket.readFrom(wake, sizeof(wake), endpoint))
+				;
+
+			drainSendRing();
+			updatePackets();
+
+			Clock::time_point now { Clock::now() };
+			Clock::time_point deadline { std::min(getNextDeadline(now), now + std::chrono::seconds(1)) };
+			if (deadline > now && m_Running.load())
+				Networking::Socket::WaitReadable(sockets, 2U, static_cast<std::uint32_t>(std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count()));
 		}
 	}
 
-	void PacketHandler::rejectPacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint16_t rev)
+	void PacketHandler::wakeThread()
 	{
-		if (availableWritePackets())
-		{
-			std::uint32_t i = 0;
-			for (; i < m_MaxWritePackets; ++i)
-				if (!m_WritePacketInfos[i].m_ID)
-					break;
+		if (m_WakePending.exchange(true))
+			return;
 
-			WritePacketInfo& info { m_WritePacketInfos[i] };
-			info.m_Type     = EPacketHeaderType::Reject;
-			info.m_ID       = id;
-			info.m_Index    = 0U;
-			info.m_Rev      = rev;
-			info.m_Endpoint = endpoint;
-			info.m_Ready    = true;
-			info.m_Bits     = 0U;
-			info.m_Time     = {};
-		}
-		else
-		{
-			auto header     = reinterpret_cast<RejectPacketHeader*>(m_WriteBuffer);
-			*header         = {};
-			header->m_ID    = id;
-			header->m_Index = 0U;
-			header->m_Rev   = rev;
-			m_Socket.writeTo(m_WriteBuffer, sizeof(RejectPacketHeader), endpoint);
-		}
+		std::uint8_t wake { 0U };
+		m_WakeSocket.writeTo(&wake, 1U, m_WakeSocket.getLocalEndpoint());
 	}
 
-	void PacketHandler::sendMaxSizePacket(Networking::Endpoint endpoint, std::uint16_t id)
+	void PacketHandler::drainSendRing()
 	{
-		if (availableWritePackets())
+		std::uint32_t size { 0U };
+		while (std::uint8_t* entry { m_SendRing->front(size) })
 		{
-			std::uint32_t i = 0;
-			for (; i < m_MaxWritePackets; ++i)
-				if (!m_WritePacketInfos[i].m_ID)
-					break;
+			const RingRecord& record { *reinterpret_cast<const RingRecord*>(entry) };
 
-			WritePacketInfo& info { m_WritePacketInfos[i] };
-			info.m_Type     = EPacketHeaderType::MaxSize;
-			info.m_ID       = id;
-			info.m_Index    = 0U;
-			info.m_Rev      = 0U;
-			info.m_Endpoint = endpoint;
-			info.m_Ready    = true;
-			info.m_Bits     = 0U;
-			info.m_Time     = {};
-		}
-		else
-		{
-			auto header    = reinterpret_cast<MaxSizePacketHeader*>(m_WriteBuffer);
-			*header        = {};
-			header->m_ID   = id;
-			header->m_Size = m_ReadBufferSize - 4096U;
-			m_Socket.writeTo(m_WriteBuffer, sizeof(MaxSizePacketHeader), endpoint);
+			if (!queuePacket(record.m_Endpoint, entry + sizeof(RingRecord), record.m_Size, record.m_Delivery, record.m_Channel))
+			{
+				// Waits for room unless nothing is in flight or the peer never takes it
+				if (availableWritePackets() != m_MaxWritePackets && fitsPeer(findPeer(record.m_Endpoint), record.m_Size))
+					return;
+				m_SendRing->pop();
+				continue;
+			}
+			m_SendRing->pop();
 		}
 	}
 
-	bool PacketHandler::hasHandledSection(std::uint16_t id, std::uint32_t index, std::uint16_t rev)
+	bool PacketHandler::sendsBefore(std::uint32_t lhs, std::uint32_t rhs) const
 	{
-		if (!id)
-			return true;
+		const WritePacketInfo& lhsInfo { m_WritePacketInfos[lhs] };
+		const WritePacketInfo& rhsInfo { m_WritePacketInfos[rhs] };
+		if (lhsInfo.m_Channel != rhsInfo.m_Channel)
+			return lhsInfo.m_Channel < rhsInfo.m_Channel;
+		if (lhsInfo.m_Ordered && rhsInfo.m_Ordered && lhsInfo.m_Order != rhsInfo.m_Order)
+			return IsOrderAhead(rhsInfo.m_Order, lhsInfo.m_Order);
+		return (lhs + m_MaxWritePackets - m_SendPacket) % m_MaxWritePackets < (rhs + m_MaxWritePackets - m_SendPacket) % m_MaxWritePackets;
+	}
 
-		std::uint32_t i { 0U };
-		for (; i < m_MaxReadPackets; ++i)
-			if (m_ReadPacketInfos[i].m_ID == id)
-				break;
+	bool PacketHandler::prepareWritePacket(std::uint32_t slot, Clock::time_point now)
+	{
+		WritePacketInfo& info { m_WritePacketInfos[slot] };
+		PeerInfo&        peer { packetPeer(info) };
+		// Only refilled when the peer has something to send
+		peer.m_Congestion.refill(std::chrono::duration_cast<std::chrono::duration<float>>(now - peer.m_LastRefill).count(), peer.m_RoundTrip);
+		peer.m_LastRefill = now;
+		if (!info.m_SectionSize)
+		{
+			// The peer's limits may have arrived after the packet was marked ready
+			if (!fitsPeer(&peer, info.m_Size))
+			{
+				m_Stats.m_OversizedPackets.add();
+				freeWriteSlot(slot);
+				return false;
+			}
 
-		if (i == m_MaxReadPackets)
-			return true;
+			info.m_SectionSize = peerDatagramSize(peer) - static_cast<std::uint32_t>(sizeof(PacketHeader));
+			if (HasDynamicBits(info))
+				info.m_BitsDynamic = new std::uint8_t[(RequiredSections(info.m_Size, info.m_SectionSize) + 7) / 8];
+			ResetSectionBits(info, RequiredSections(info.m_Size, info.m_SectionSize));
+			info.m_ParityGroup = RequiredSections(info.m_Size, info.m_SectionSize) > 1U ? m_Channels[info.m_Channel].m_ParityGroup : 0U;
+			if (info.m_StreamWindow)
+			{
+				// A parity group must fit the window
+				info.m_StreamWindow = info.m_StreamWindow / info.m_SectionSize;
+				if (info.m_ParityGroup > info.m_StreamWindow)
+					info.m_ParityGroup = 0U;
+			}
+			if (info.m_Delivery == EDelivery::Sequenced)
+			{
+				PeerChannelInfo& channel { peer.m_Channels[info.m_Channel] };
+				info.m_Rev             = channel.m_SendSequence;
+				channel.m_SendSequence = (channel.m_SendSequence + 1U) & 0xFFFU;
+			}
 
-		ReadPacketInfo& info = m_ReadPacketInfos[i];
-		if (rev < info.m_Rev)
-			return true;
+			// IDs count up per peer in the order packets first go out, skipping ones still in flight after wrapping
+			do
+			{
+				info.m_Sequence     = peer.m_SendPacketID;
+				peer.m_SendPacketID = static_cast<std::uint16_t>(peer.m_SendPacketID + 1U) ? static_cast<std::uint16_t>(peer.m_SendPacketID + 1U) : 1U;
+			} while (info.m_Delivery == EDelivery::Reliable && !m_SentPacketIndex.insert({ info.m_Endpoint, info.m_Sequence }, slot));
+		}
 
-		if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
+		bool resuming { info.m_SendIndex > 0U };
+		// A pass stopped by the window restarts once its overdue sections were lost
+		if (resuming && info.m_InFlight && (!peer.m_Congestion.canSend() || IsStreamWindowFull(info)) && now - info.m_SendTime >= Seconds(peer.m_RoundTrip.getBackoffTimeout(info.m_Retransmissions)))
 		{
-			if (index >= getRequiredSections(info.m_Size))
-				return true;
-
-			std::uint32_t bit  = index % 8;
-			std::uint32_t byte = index / 8;
-
-			return (info.m_BitsDynamic[byte] >> bit) & 1;
+			info.m_SendIndex      = 0U;
+			info.m_RetransmitTime = now;
+			resuming              = false;
+			if (!info.m_Time.time_since_epoch().count())
+				setWriteTime(slot, now);
 		}
-		else
+		if (!resuming && info.m_RetransmitTime.time_since_epoch().count())
 		{
-			return (info.m_Bits >> index) & 1;
+			if (now < info.m_RetransmitTime)
+			{
+				waitForRetransmit(slot);
+				return false;
+			}
+
+			peer.m_Congestion.removeInFlight(info.m_InFlight);
+			info.m_InFlight       = 0U;
+			info.m_RetransmitTime = {};
+			info.m_StreamResent   = info.m_StreamLoaded;
+			++info.m_Retransmissions;
+			peerLost(peer, now);
 		}
+		return true;
 	}
 
-	bool PacketHandler::receivedSection(std::uint16_t id, std::uint32_t index, std::uint16_t rev)
+	std::uint32_t PacketHandler::sendSections(std::uint32_t slot, Clock::time_point now, std::uint32_t maxSections)
 	{
-		if (!id)
-			return false;
-
-		std::uint32_t i { 0U };
-		for (; i < m_MaxReadPackets; ++i)
-			if (m_ReadPacketInfos[i].m_ID == id)
-				break;
-
-		if (i == m_MaxReadPackets)
-			return false;
-
-		ReadPacketInfo& info = m_ReadPacketInfos[i];
-		if (rev < info.m_Rev)
-			return true;
-
-		if (rev > info.m_Rev)
+		WritePacketInfo& info { m_WritePacketInfos[slot] };
+		if (!info.m_Ready || (!info.m_SendIndex && info.m_RetransmitTime.time_since_epoch().count()))
+			return 0U;
+
+		PeerInfo&     peer { packetPeer(info) };
+		std::uint32_t requiredSections { RequiredSections(info.m_Size, info.m_SectionSize) };
+		std::uint32_t sent { 0U };
+		// Stream retransmits start at the first unacknowledged section
+		if (info.m_Stream)
+			info.m_SendIndex = std::max(info.m_SendIndex, info.m_StreamBase);
+		while (info.m_SendIndex < requiredSections && sent < maxSections)
 		{
-			std::uint32_t start = info.m_Start;
-			std::uint32_t size  = info.m_Size;
-			std::memmove(m_ReadBuffer + start, m_ReadBuffer + start + size, m_ReadBufferSize - start - size);
-			for (std::uint32_t j = 0; j < m_MaxReadPackets; ++j)
+			if (IsStreamWindowFull(info))
+				break;
+			if (TestSectionBit(info, info.m_SendIndex))
 			{
-				ReadPacketInfo& info = m_ReadPacketInfos[j];
-				if (info.m_Start > start)
-					info.m_Start -= size;
+				++info.m_SendIndex;
+				sent += sendParitySection(info, peer);
+				continue;
 			}
+			if (!peer.m_Congestion.canSend())
+				break;
 
-			std::uint32_t availableSize = availableReadPacketSize();
-			if (size > availableSize)
+			std::uint32_t offset { info.m_SendIndex * info.m_SectionSize };
+			std::uint32_t size { std::min<std::uint32_t>(info.m_SectionSize, info.m_Size - offset) };
+			bool          resent { info.m_Stream ? info.m_SendIndex < info.m_StreamLoaded : info.m_Retransmissions > 0U };
+			if (info.m_Stream && !resent)
 			{
-				if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
-					delete[] info.m_BitsDynamic;
-				info.m_ID       = 0U;
-				info.m_Rev      = 0U;
-				info.m_Start    = ~0U;
-				info.m_Size     = 0U;
-				info.m_Endpoint = {};
-				info.m_Bits     = 0U;
-				info.m_Time     = {};
-				return false;
+				if (!info.m_Source.m_Data && !info.m_Source.m_Read(info.m_Source.m_UserData, offset, m_WriteBuffer + info.m_Start + (info.m_SendIndex % info.m_StreamWindow) * info.m_SectionSize, size))
+				{
+					info.m_Ready = false;
+					break;
+				}
+				info.m_StreamLoaded = info.m_SendIndex + 1U;
 			}
-
-			info.m_Start = m_ReadBufferSize - availableSize;
-			m_UsedReadBufferSize += size;
-			info.m_Rev = rev;
-
-			if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
+			FillSectionHeader(*reinterpret_cast<PacketHeader*>(beginDatagram()), info, info.m_SendIndex);
+			// Packet blocks stay valid until the datagrams are flushed
+			endDatagram(sizeof(PacketHeader), peer, sectionData(info, info.m_SendIndex), size);
+			peer.m_Congestion.sent();
+			m_Stats.m_SectionsSent.add();
+			peer.m_Stats.m_SectionsSent.add();
+			if (resent)
 			{
-				for (std::uint32_t j = 0; j < getRequiredSections(info.m_Size); ++j)
-					info.m_BitsDynamic[j] = 0U;
+				m_Stats.m_SectionsRetransmitted.add();
+				peer.m_Stats.m_SectionsRetransmitted.add();
 			}
-			else
+			++info.m_SendIndex;
+			++sent;
+			sent += sendParitySection(info, peer);
+			if (info.m_Delivery == EDelivery::Sequenced)
 			{
-				info.m_Bits = 0U;
+				peer.m_Congestion.removeInFlight(1U);
+				continue;
 			}
+			++info.m_InFlight;
+			info.m_SendTime    = now;
+			info.m_SampleIndex = info.m_SendIndex - 1U;
 		}
 
-		if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
+		if (!info.m_Ready)
+			return sent;
+		if (info.m_SendIndex >= requiredSections && info.m_Delivery == EDelivery::Sequenced)
 		{
-			if (index >= getRequiredSections(info.m_Size))
-				return true;
-
-			std::uint32_t bit  = index % 8;
-			std::uint32_t byte = index / 8;
-
-			info.m_BitsDynamic[byte] |= 1 << bit;
+			peer.m_LastSeen = now;
+			info.m_Ready    = false;
 		}
-		else
+		else if (info.m_SendIndex >= requiredSections)
 		{
-			info.m_Bits |= 1 << index;
+			peer.m_LastSeen       = now;
+			info.m_RetransmitTime = now + Seconds(peer.m_RoundTrip.getBackoffTimeout(info.m_Retransmissions));
+			info.m_SendIndex      = 0U;
+			if (!info.m_Time.time_since_epoch().count())
+				setWriteTime(slot, now);
+			waitForRetransmit(slot);
 		}
-
-		info.m_Time = Clock::now();
-
-		std::uint32_t offset = index * (4096U - sizeof(PacketHeader));
-		std::uint32_t size   = std::min<std::uint32_t>(4096U - sizeof(PacketHeader), info.m_Size - offset);
-
-		std::memcpy(m_ReadBuffer + info.m_Start + offset, m_ReadBuffer + sizeof(PacketHeader), size);
-
-		return true;
+		return sent;
 	}
 
-	bool PacketHandler::readPacketDone(std::uint16_t id)
+	bool PacketHandler::sendParitySection(WritePacketInfo& info, PeerInfo& peer)
 	{
-		if (!id)
+		std::uint32_t requiredSections { RequiredSections(info.m_Size, info.m_SectionSize) };
+		if (!info.m_ParityGroup || (info.m_SendIndex % info.m_ParityGroup && info.m_SendIndex != requiredSections))
 			return false;
 
-		std::uint32_t i { 0U };
-		for (; i < m_MaxReadPackets; ++i)
-			if (m_ReadPacketInfos[i].m_ID == id)
-				break;
-
-		if (i == m_MaxReadPackets)
+		// Only groups sent for the first time
+		std::uint32_t group { (info.m_SendIndex - 1U) / info.m_ParityGroup };
+		std::uint32_t first { group * info.m_ParityGroup };
+		if (info.m_Retransmissions && !(info.m_Stream && first >= info.m_StreamResent))
 			return false;
+		std::uint8_t* datagram { beginDatagram() };
+		auto          header { reinterpret_cast<PacketHeader*>(datagram) };
+		FillSectionHeader(*header, info, group);
+		header->m_Flags |= PacketFlag::Parity;
+
+		std::uint8_t* parity { datagram + sizeof(PacketHeader) };
+		std::memset(parity, 0, info.m_SectionSize);
+		for (std::uint32_t index { first }; index < info.m_SendIndex; ++index)
+		{
+			std::uint32_t       size { std::min<std::uint32_t>(info.m_SectionSize, info.m_Size - index * info.m_SectionSize) };
+			const std::uint8_t* section { sectionData(info, index) };
+			for (std::uint32_t j { 0 }; j < size; ++j)
+				parity[j] ^= section[j];
+		}
+		endDatagram(sizeof(PacketHeader) + info.m_SectionSize, peer);
+		m_Stats.m_ParitySent.add();
 
-		ReadPacketInfo& info = m_ReadPacketInfos[i];
-		if (info.m_Size > 32 * (4096 - sizeof(PacketHeader)))
+		// Sent even without tokens so no group goes out without its parity
+		peer.m_Congestion.sent();
+		peer.m_Congestion.removeInFlight(1U);
+		return true;
+	}
+
+	std::uint32_t PacketHandler::recoverSection(std::uint32_t slot, std::uint32_t group, std::uint16_t rev, const std::uint8_t* parity, std::uint32_t paritySize)
+	{
+		ReadPacketInfo& info = m_ReadPacketInfos[slot];
+		if (!info.m_ParityGroup || rev != info.m_Rev || paritySize < info.m_SectionSize)
+			return ~0U;
+
+		std::uint32_t requiredSections { RequiredSections(info.m_Size, info.m_SectionSize) };
+		std::uint32_t first { group * info.m_ParityGroup };
+		std::uint32_t last { std::min<std::uint32_t>(first + info.m_ParityGroup, requiredSections) };
+		std::uint32_t missing { ~0U };
+		for (std::uint32_t index { first }; index < last; ++index)
 		{
-			for (std::uint32_t byte = 0; byte < (getRequiredSections(info.m_Size) + 7) / 8; ++byte)
-				if (info.m_BitsDynamic[byte] != static_cast<std::uint8_t>(~0U))
-					return false;
-			return true;
+			if (TestSectionBit(info, index))
+			{
+				if (info.m_Stream && index + info.m_StreamWindow < requiredSections && TestSectionBit(info, index + info.m_StreamWindow))
+					return ~0U;
+				continue;
+			}
+			if (missing != ~0U)
+				return ~0U;
+			missing = index;
 		}
-		else
+		if (missing == ~0U || (info.m_Stream && missing - info.m_StreamBase >= info.m_StreamWindow))
+			return ~0U;
+
+		std::uint8_t* section { sectionData(info, missing) };
+		std::uint32_t size { std::min<std::uint32_t>(info.m_SectionSize, info.m_Size - missing * info.m_SectionSize) };
+		std::memcpy(section, parity, size);
+		for (std::uint32_t index { first }; index < last; ++index)
 		{
-			return info.m_Bits == ~0U;
+			if (index == missing)
+				continue;
+
+			const std::uint8_t* other { sectionData(info, index) };
+			std::uint32_t       otherSize { std::min<std::uint32_t>(size, info.m_Size - index * info.m_SectionSize) };
+			for (std::uint32_t j { 0 }; j < otherSize; ++j)
+				section[j] ^= other[j];
 		}
-	}
 
-	std::uint16_t PacketHandler::newPacketID()
-	{
-		std::uint16_t id = 0U;
-		while (hasUsedPacketID(id = static_cast<std::uint16_t>(rand()) | 1))
-			;
-		return id;
+		SetSectionBit(info, missing);
+		setReadTime(slot, Clock::now());
+		m_Stats.m_SectionsRecovered.add();
+		return missing;
 	}
 
-	bool PacketHandler::hasUsedPacketID(std::uint16_t id) const
+	void PacketHandler::handleDatagram(std::uint8_t* data, std::size_t size, Networking::Endpoint endpoint)
 	{
-		if (!id)
-			return true;
+		if (size < 8)
+			return;
 
-		for (std::uint32_t i { 0 }; i < m_MaxWritePackets; ++i)
-			if (m_WritePacketInfos[i].m_ID == id)
-				return true;
+		auto header { reinterpret_cast<PacketHeader*>(data) };
+		if (!IsMagicNumberValid(header->m_MagicNumber))
+			return;
 
-		for (std::uint32_t i { 0 }; i < m_UsedPacketIDs.size(); ++i)
-			if (m_UsedPacketIDs[i] == id)
-				return true;
+		auto type { GetPacketHeaderType(header->m_MagicNumber) };
+		switch (type)
+		{
+		case EPacketHeaderType::Normal:
+		{
+			if (size < sizeof(PacketHeader) || !header->m_SectionSize || header->m_SectionSize > m_MaxDatagramSize - sizeof(PacketHeader) || header->m_Channel >= s_MaxChannels)
+				return;
 
-		return false;
-	}
+			bool parity { (header->m_Flags & PacketFlag::Parity) != 0U };
+			if (!parity)
+				m_Stats.m_SectionsReceived.add();
 
-	bool PacketHandler::hasHandledPacketID(std::uint16_t id) const
-	{
-		for (std::uint32_t i { 0 }; i < m_HandledPacketIDs.size(); ++i)
-			if (m_HandledPacketIDs[i] == id)
-				return true;
+			// Looked up once the header checked out, new peers only replace idle ones
+			Clock::time_point now { Clock::now() };
+			PeerInfo*         peer { acquirePeer(endpoint) };
+			if (!peer)
+				return;
+			touchPeer(*peer, now);
+			if (header->m_Flags & PacketFlag::Unreliable)
+			{
+				handleSequencedSection(*peer, *header, data + sizeof(PacketHeader), static_cast<std::uint32_t>(size - sizeof(PacketHeader)), now);
+				return;
+			}
 
-		return false;
-	}
+			std::uint32_t slot { findReadSlot(endpoint, header->m_ID) };
+			if (slot == Utils::SlotIndex<PacketKey>::s_Invalid)
+			{
+				// The final acknowledgement got lost.
+				// IDs behind the window are dropped until it expires
+				Utils::ESequenceState state { getPacketIDState(*peer, header->m_ID, now) };
+				if (state == Utils::ESequenceState::Handled && header->m_Size && !parity)
+				{
+					m_Stats.m_DuplicateSections.add();
+					sendAcknowledgeRange(endpoint, header->m_ID, header->m_Rev, 0U, RequiredSections(header->m_Size, header->m_SectionSize) - 1U, nullptr);
+				}
+				if (state == Utils::ESequenceState::Stale)
+					m_Stats.m_StalePackets.add();
+				if (state != Utils::ESequenceState::New)
+					return;
+
+				// Single section packets skip the read slot.
+				// Ordered ones only when it is their turn
+				bool ordered { (header->m_Flags & PacketFlag::Ordered) != 0U };
+				if (!parity && header->m_Size && header->m_Size <= header->m_SectionSize && !isStreamed(*header) && (!ordered || header->m_Order == peer->m_Channels[header->m_Channel].m_ReceiveOrder))
+				{
+					if (header->m_Index)
+						return;
+					if (size - sizeof(PacketHeader) < header->m_Size)
+					{
+						rejectPacket(endpoint, header->m_ID, header->m_Rev);
+						return;
+					}
+					// Left unacknowledged for the sender to retransmit
+					if (!handOff(endpoint, data + sizeof(PacketHeader), header->m_Size, (header->m_Flags & PacketFlag::Coalesced) != 0U))
+						return;
 
-	std::uint32_t PacketHandler::getRequiredSections(std::uint32_t size) const
-	{
-		static constexpr std::uint32_t SectionSize = 4096U - sizeof(PacketHeader);
-		return (size + SectionSize - 1U) / SectionSize;
+					acknowledgePacket(endpoint, header->m_ID, header->m_Index, header->m_Rev);
+					markPacketIDHandled(*peer, header->m_ID, now);
+					if (ordered)
+					{
+						++peer->m_Channels[header->m_Channel].m_ReceiveOrder;
+						deliverHeldPackets(*peer, header->m_Channel);
+					}
+					return;
+				}
+
+				bool          stream { isStreamed(*header) };
+				std::uint32_t window { std::max<std::uint32_t>(m_StreamWindowSize / header->m_SectionSize, 1U) };
+				std::uint32_t blockSize { stream ? std::min<std::uint32_t>(window * header->m_SectionSize, header->m_Size) : header->m_Size };
+				if (!allocateReadBlock(header->m_Size, blockSize, header->m_ID, header->m_Rev, endpoint, header->m_SectionSize))
+				{
+					// Left for the sender to retransmit while the application thread catches up
+					if (m_ReceiveRing && blockSize <= m_ReadAllocator.getSize() - Utils::BlockAllocator::s_HeaderSize)
+						return;
+					rejectPacket(endpoint, header->m_ID, header->m_Rev);
+					return;
+				}
+
+				slot = findReadSlot(endpoint, header->m_ID);
+				ReadPacketInfo& info { m_ReadPacketInfos[slot] };
+				info.m_Stream       = stream;
+				info.m_StreamWindow = stream ? window : 0U;
+				info.m_Channel      = header->m_Channel;
+				info.m_Order        = header->m_Order;
+				info.m_Ordered      = ordered;
+				info.m_Coalesced    = (header->m_Flags & PacketFlag::Coalesced) != 0U;
+				info.m_ParityGroup  = header->m_ParityGroup;
+			}
+			else if (m_ReadPacketInfos[slot].m_SectionSize != header->m_SectionSize || m_ReadPacketInfos[slot].m_Delivery != EDelivery::Reliable)
+			{
+				return;
+			}
+			else if (!parity && hasHandledSection(endpoint, header->m_ID, header->m_Index, header->m_Rev))
+			{
+				m_Stats.m_DuplicateSections.add();
+				acknowledgePacket(endpoint, header->m_ID, header->m_Index, header->m_Rev);
+				return;
+			}
+
+			if (!parity && m_ReadPacketInfos[slot].m_Stream && header->m_Index - m_ReadPacketInfos[slot].m_StreamBase >= m_ReadPacketInfos[slot].m_StreamWindow)
+			{
+				// Its window slot is still in use
+				m_Stats.m_SectionsPastWindow.add();
+				return;
+			}
+
+			if (parity)
+			{
+				std::uint32_t index { recoverSection(slot, header->m_Index, header->m_Rev, data + sizeof(PacketHeader), static_cast<std::uint32_t>(size - sizeof(PacketHeader))) };
+				if (index == ~0U)
+					return;
+				acknowledgePacket(endpoint, header->m_ID, index, header->m_Rev);
+			}
+			else
+			{
+				if (!receivedSection(endpoint, header->m_ID, header->m_Index, header->m_Rev, data + sizeof(PacketHeader), static_cast<std::uint32_t>(size - sizeof(PacketHeader))))
+				{
+					rejectPacket(endpoint, header->m_ID, header->m_Rev);
+					return;
+				}
+				acknowledgePacket(endpoint, header->m_ID, header->m_Index, header->m_Rev);
+			}
+			if (readPacketDone(endpoint, header->m_ID))
+			{
+				flushAcknowledge(slot);
+				markPacketIDHandled(*peer, header->m_ID, now);
+				if (!m_ReadPacketInfos[slot].m_Stream)
+					deliverReadSlot(slot);
+			}
+			if (m_ReadPacketInfos[slot].m_ID && m_ReadPacketInfos[slot].m_Stream)
+				deliverStreamSections(slot);
+			break;
+		}
+		case EPacketHeaderType::Acknowledge:
+		{
+			auto acknowledgeHeader { reinterpret_cast<AcknowledgePacketHeader*>(data) };
+
+			std::uint32_t i { findSentSlot(endpoint, acknowledgeHeader->m_ID) };
+			if (i == Utils::SlotIndex<PacketKey>::s_Invalid)
+				return;
+
+			WritePacketInfo& info = m_WritePacketInfos[i];
+			if (info.m_Rev != acknowledgeHeader->m_Rev)
+				return;
+
+			if (!info.m_SectionSize)
+				return;
+			m_Stats.m_AcknowledgesReceived.add();
+
+			// Karn's algorithm
+			std::uint32_t totalSections { RequiredSections(info.m_Size, info.m_SectionSize) };
+			bool          canSample { (!info.m_Retransmissions || (info.m_Stream && info.m_SampleIndex >= info.m_StreamResent)) && info.m_SendTime.time_since_epoch().count() && !TestSectionBit(info, info.m_SampleIndex) };
+			std::uint32_t acknowledged { 0U };
+			if (size > sizeof(AcknowledgeRangePacketHeader))
+			{
+				auto                rangeHeader { reinterpret_cast<AcknowledgeRangePacketHeader*>(data) };
+				const std::uint8_t* bits { data + sizeof(AcknowledgeRangePacketHeader) };
+				std::uint32_t       count { std::min<std::uint32_t>(rangeHeader->m_Count, static_cast<std::uint32_t>((size - sizeof(AcknowledgeRangePacketHeader)) * 8)) };
+				for (std::uint32_t j { 0 }; j < count && rangeHeader->m_Index + j < totalSections; ++j)
+				{
+					if (((bits[j / 8] >> (j % 8)) & 1U) && !TestSectionBit(info, rangeHeader->m_Index + j))
+					{
+						SetSectionBit(info, rangeHeader->m_Index + j);
+						++acknowledged;
+					}
+				}
+			}
+			else
+			{
+				if (acknowledgeHeader->m_Index >= totalSections)
+					return;
+
+				if (!TestSectionBit(info, acknowledgeHeader->m_Index))
+				{
+					SetSectionBit(info, acknowledgeHeader->m_Index);
+					++acknowledged;
+				}
+			}
+			if (!acknowledged)
+				return;
+
+			if (info.m_Stream)
+			{
+				std::uint32_t base { info.m_StreamBase };
+				while (info.m_StreamBase < totalSections && TestSectionBit(info, info.m_StreamBase))
+					++info.m_StreamBase;
+				// Progress resets the backoff
+				if (info.m_StreamBase != base)
+					info.m_Retransmissions = std::min(info.m_Retransmissions, 1U);
+			}
+
+			Clock::time_point now { Clock::now() };
+			PeerInfo&         peer { packetPeer(info) };
+			float             rtt { 0.0f };
+			if (canSample && TestSectionBit(info, info.m_SampleIndex))
+			{
+				rtt = std::chrono::duration_cast<std::chrono::duration<float>>(now - info.m_SendTime).count();
+				peer.m_RoundTrip.addSample(rtt);
+				m_Stats.m_RoundTrip.add(rtt);
+				peer.m_Stats.m_RoundTrip.add(rtt);
+			}
+			peer.m_Congestion.acknowledged(acknowledged, rtt, peer.m_RoundTrip);
+			std::uint32_t inFlight { std::min(acknowledged, info.m_InFlight) };
+			peer.m_Congestion.removeInFlight(inFlight);
+			info.m_InFlight -= inFlight;
+			peer.m_LastSeen = now;
+
+			setWriteTime(i, now);
+			if (info.m_Stream ? info.m_StreamBase >= totalSections : AllSectionBitsSet(info, totalSections))
+			{
+				float latency { std::chrono::duration_cast<std::chrono::duration<float>>(now - info.m_ReadyTime).count() };
+				m_Stats.m_PacketsAcknowledged.add();
+				m_Stats.m_DeliveryLatency.add(latency);
+				peer.m_Stats.m_PacketsAcknowledged.add();
+				peer.m_Stats.m_DeliveryLatency.add(latency);
+				freeWriteSlot(i);
+			}
+
+			break;
+		}
+		case EPacketHeaderType::Reject:
+		{
+			auto rejectHeader { reinterpret_cast<RejectPacketHeader*>(data) };
+
+			std::uint32_t i { findSentSlot(endpoint, rejectHeader->m_ID) };
+			if (i == Utils::SlotIndex<PacketKey>::s_Invalid)
+				return;
+
+			WritePacketInfo& info = m_WritePacketInfos[i];
+			if (info.m_Rev == rejectHeader->m_Rev)
+			{
+				// TODO(MarcasRealAccount): Report premature packet rejection
+				m_Stats.m_RejectsReceived.add();
+				freeWriteSlot(i);
+			}
+
+			break;
+		}
+		case EPacketHeaderType::MaxSize:
+		{
+			auto maxSizeHeader { reinterpret_cast<MaxSizePacketHeader*>(data) };
+			if (size < sizeof(MaxSizePacketHeader))
+				return;
+
+			switch (maxSizeHeader->m_Probe)
+			{
+			case EMaxSizeProbe::None:
+			{
+				if (!maxSizeHeader->m_Size)
+				{
+					// The request carries the requester's limits as well
+					PeerInfo* peer { acquirePeer(endpoint) };
+					if (peer)
+						peerMaxSize(*peer, 0U, maxSizeHeader->m_DatagramSize);
+					sendMaxSizePacket(endpoint, maxSizeHeader->m_ID);
+				}
+				else
+				{
+					PeerInfo* peer { findPeer(endpoint) };
+					if (peer)
+						peerMaxSize(*peer, maxSizeHeader->m_Size, maxSizeHeader->m_DatagramSize);
+				}
+				break;
+			}
+			case EMaxSizeProbe::Probe:
+			{
+				if (size != maxSizeHeader->m_DatagramSize)
+					return;
+
+				auto reply { reinterpret_cast<MaxSizePacketHeader*>(beginDatagram()) };
+				*reply                = {};
+				reply->m_ID           = maxSizeHeader->m_ID;
+				reply->m_Size         = 0U;
+				reply->m_DatagramSize = maxSizeHeader->m_DatagramSize;
+				reply->m_Probe        = EMaxSizeProbe::ProbeAck;
+				endDatagram(sizeof(MaxSizePacketHeader), endpoint);
+				break;
+			}
+			case EMaxSizeProbe::ProbeAck:
+			{
+				PeerInfo* peer { findPeer(endpoint) };
+				if (!peer || !peer->m_ProbeSize || peer->m_ProbeSize != maxSizeHeader->m_DatagramSize)
+					return;
+
+				peer->m_PathMTU.probeAcknowledged(peer->m_ProbeSize);
+				peer->m_ProbeSize = 0U;
+				schedulePeer(*peer, Clock::now());
+				break;
+			}
+			}
+			break;
+		}
+		}
+	}
+
+	void PacketHandler::handleSequencedSection(PeerInfo& peer, const PacketHeader& header, std::uint8_t* section, std::uint32_t dataSize, Clock::time_point now)
+	{
+		Networking::Endpoint endpoint { peer.m_Endpoint };
+		PeerChannelInfo&     channel { peer.m_Channels[header.m_Channel] };
+		std::uint32_t        slot { findReadSlot(endpoint, header.m_ID) };
+		if (!isSequenceNewer(channel, header.m_Rev, now))
+		{
+			m_Stats.m_StalePackets.add();
+			if (slot != Utils::SlotIndex<PacketKey>::s_Invalid && m_ReadPacketInfos[slot].m_Delivery == EDelivery::Sequenced)
+				freeReadSlot(slot);
+			return;
+		}
+
+		bool          parity { (header.m_Flags & PacketFlag::Parity) != 0U };
+		std::uint8_t* packet { section };
+		if (!parity && header.m_Size && header.m_Size <= header.m_SectionSize)
+		{
+			if (header.m_Index || dataSize < header.m_Size)
+				return;
+		}
+		else
+		{
+			if (slot == Utils::SlotIndex<PacketKey>::s_Invalid)
+			{
+				// Only the newest packet of the channel gets a slot
+				std::uint32_t pending { channel.m_SequencedReadSlot };
+				if (pending < m_MaxReadPackets && IsSequencedSlot(m_ReadPacketInfos[pending], endpoint, header.m_Channel))
+				{
+					if (IsSequenceAhead(m_ReadPacketInfos[pending].m_Rev, header.m_Rev))
+						return;
+					freeReadSlot(pending);
+				}
+
+				// Never rejected, the sender does not wait for an answer
+				if (!allocateReadPacket(header.m_Size, header.m_ID, header.m_Rev, endpoint, header.m_SectionSize))
+					return;
+				slot                                  = findReadSlot(endpoint, header.m_ID);
+				m_ReadPacketInfos[slot].m_Delivery    = EDelivery::Sequenced;
+				m_ReadPacketInfos[slot].m_Channel     = header.m_Channel;
+				m_ReadPacketInfos[slot].m_ParityGroup = header.m_ParityGroup;
+				channel.m_SequencedReadSlot           = slot;
+			}
+			else
+			{
+				ReadPacketInfo& info { m_ReadPacketInfos[slot] };
+				if (info.m_Delivery != EDelivery::Sequenced || info.m_Rev != header.m_Rev || info.m_SectionSize != header.m_SectionSize || info.m_Endpoint != endpoint || info.m_Channel != header.m_Channel)
+					return;
+			}
+
+			if (parity ? recoverSection(slot, header.m_Index, header.m_Rev, section, dataSize) == ~0U : !receivedSection(endpoint, header.m_ID, header.m_Index, header.m_Rev, section, dataSize))
+				return;
+			if (!readPacketDone(endpoint, header.m_ID))
+				return;
+			packet = m_ReadBuffer + m_ReadPacketInfos[slot].m_Start;
+		}
+
+		// Dropped like a lost frame if the receive ring is full
+		bool delivered { handOff(endpoint, packet, header.m_Size, false) };
+		if (slot != Utils::SlotIndex<PacketKey>::s_Invalid)
+			freeReadSlot(slot);
+		if (!delivered)
+			return;
+
+		channel.m_ReceiveSequence = header.m_Rev;
+		channel.m_ReceiveTime     = now;
+
+		// An older incomplete packet can never be delivered anymore
+		std::uint32_t pending { channel.m_SequencedReadSlot };
+		if (pending < m_MaxReadPackets && IsSequencedSlot(m_ReadPacketInfos[pending], endpoint, header.m_Channel) && !IsSequenceAhead(m_ReadPacketInfos[pending].m_Rev, header.m_Rev))
+			freeReadSlot(pending);
+	}
+
+	bool PacketHandler::isSequenceNewer(const PeerChannelInfo& channel, std::uint16_t sequence, Clock::time_point now) const
+	{
+		// The sender may have restarted after a read timeout
+		if (!channel.m_ReceiveTime.time_since_epoch().count() || std::chrono::duration_cast<std::chrono::duration<float>>(now - channel.m_ReceiveTime).count() >= m_ReadTimeout)
+			return true;
+		return IsSequenceAhead(sequence, channel.m_ReceiveSequence);
+	}
+
+	void PacketHandler::deliverReadSlot(std::uint32_t slot)
+	{
+		ReadPacketInfo& info { m_ReadPacketInfos[slot] };
+		PeerInfo&       peer { m_PeerInfos[info.m_Peer] };
+		if (info.m_Ordered)
+		{
+			PeerChannelInfo& channel { peer.m_Channels[info.m_Channel] };
+			if (IsOrderAhead(info.m_Order, channel.m_ReceiveOrder))
+			{
+				if (!holdReadSlot(slot))
+					freeReadSlot(slot);
+				return;
+			}
+			if (info.m_Order != channel.m_ReceiveOrder)
+			{
+				freeReadSlot(slot);
+				return;
+			}
+		}
+		// Already acknowledged, so it waits for room in the receive ring
+		if (!handOff(info.m_Endpoint, m_ReadBuffer + info.m_Start, info.m_Size, info.m_Coalesced))
+		{
+			m_RetryHeld = true;
+			if (!holdReadSlot(slot))
+				freeReadSlot(slot);
+			return;
+		}
+		if (info.m_Ordered)
+			++peer.m_Channels[info.m_Channel].m_ReceiveOrder;
+
+		std::uint16_t channel { info.m_Channel };
+		bool          ordered { info.m_Ordered };
+		freeReadSlot(slot);
+		if (ordered)
+			deliverHeldPackets(peer, channel);
+	}
+
+	bool PacketHandler::holdReadSlot(std::uint32_t slot)
+	{
+		ReadPacketInfo& info { m_ReadPacketInfos[slot] };
+		if (!info.m_Held && info.m_Ordered && !m_HeldPacketIndex.insert({ info.m_Endpoint, info.m_Channel, info.m_Order }, slot))
+			return false;
+
+		info.m_Held = true;
+		setReadTime(slot, Clock::now());
+		return true;
+	}
+
+	void PacketHandler::deliverHeldPackets(PeerInfo& peer, std::uint16_t channel)
+	{
+		PeerChannelInfo& state { peer.m_Channels[channel] };
+		while (true)
+		{
+			std::uint32_t slot { m_HeldPacketIndex.find({ peer.m_Endpoint, channel, state.m_ReceiveOrder }) };
+			if (slot == Utils::SlotIndex<HeldPacketKey>::s_Invalid)
+				return;
+
+			// updatePackets retries once the receive ring has room
+			ReadPacketInfo& info { m_ReadPacketInfos[slot] };
+			if (!handOff(peer.m_Endpoint, m_ReadBuffer + info.m_Start, info.m_Size, info.m_Coalesced))
+			{
+				m_RetryHeld = true;
+				return;
+			}
+
+			++state.m_ReceiveOrder;
+			freeReadSlot(slot);
+		}
+	}
+
+	void PacketHandler::deliverStreamSections(std::uint32_t slot)
+	{
+		ReadPacketInfo& info { m_ReadPacketInfos[slot] };
+		std::uint32_t   requiredSections { RequiredSections(info.m_Size, info.m_SectionSize) };
+		while (info.m_StreamBase < requiredSections && TestSectionBit(info, info.m_StreamBase))
+		{
+			// Contiguous sections up to where the window wraps
+			std::uint32_t last { info.m_StreamBase + 1U };
+			while (last < requiredSections && last % info.m_StreamWindow && TestSectionBit(info, last))
+				++last;
+
+			std::uint32_t offset { info.m_StreamBase * info.m_SectionSize };
+			std::uint32_t size { static_cast<std::uint32_t>(std::min<std::uint64_t>(static_cast<std::uint64_t>(last) * info.m_SectionSize, info.m_Size)) - offset };
+			// updatePackets retries once the receive ring has room
+			if (!handOffStream(info.m_Endpoint, info.m_ID, offset, sectionData(info, info.m_StreamBase), size, info.m_Size))
+			{
+				m_RetryHeld = true;
+				return;
+			}
+			info.m_StreamBase = last;
+		}
+		if (info.m_StreamBase >= requiredSections)
+			freeReadSlot(slot);
+	}
+
+	bool PacketHandler::isStreamed(const PacketHeader& header) const
+	{
+		// Section indices have 20 bits
+		return m_StreamCallback && header.m_Size >= m_StreamMinSize && !(header.m_Flags & (PacketFlag::Unreliable | PacketFlag::Ordered | PacketFlag::Coalesced)) && RequiredSections(header.m_Size, header.m_SectionSize) <= 1U << 20;
+	}
+
+	std::uint32_t PacketHandler::availableReadPackets() const
+	{
+		return m_FreeReadSlotCount;
+	}
+
+	std::uint32_t PacketHandler::availableWritePackets() const
+	{
+		return m_FreeWriteSlotCount;
+	}
+
+	std::uint32_t PacketHandler::availableReadPacketSize() const
+	{
+		return m_ReadAllocator.largestAllocation();
+	}
+
+	std::uint32_t PacketHandler::availableWritePacketSize() const
+	{
+		return m_WriteAllocator.largestAllocation();
+	}
+
+	std::uint8_t* PacketHandler::getReadPacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t& size)
+	{
+		if (!id)
+			return nullptr;
+
+		std::uint32_t i { findReadSlot(endpoint, id) };
+		if (i == Utils::SlotIndex<PacketKey>::s_Invalid)
+			return nullptr;
+
+		ReadPacketInfo& info = m_ReadPacketInfos[i];
+		if (!info.m_Size || info.m_Stream)
+			return nullptr;
+
+		size = info.m_Size;
+		return m_ReadBuffer + info.m_Start;
+	}
+
+	std::uint8_t* PacketHandler::getWritePacket(std::uint16_t id, std::uint32_t& size)
+	{
+		if (!id)
+			return nullptr;
+
+		std::uint32_t i { findWriteSlot(id) };
+		if (i == Utils::SlotIndex<std::uint16_t>::s_Invalid)
+			return nullptr;
+
+		WritePacketInfo& info = m_WritePacketInfos[i];
+		if (!info.m_Size || info.m_Stream)
+			return nullptr;
+
+		size = info.m_Size;
+		return m_WriteBuffer + info.m_Start;
+	}
+
+	bool PacketHandler::markWritePacketReady(std::uint16_t id)
+	{
+		if (!id)
+			return false;
+
+		std::uint32_t i { findWriteSlot(id) };
+		if (i == Utils::SlotIndex<std::uint16_t>::s_Invalid)
+			return false;
+
+		WritePacketInfo& info { m_WritePacketInfos[i] };
+		if (info.m_Ready)
+			return true;
+		if (!fitsPeer(findPeer(info.m_Endpoint), info.m_Size))
+		{
+			m_Stats.m_OversizedPackets.add();
+			freeWriteSlot(i);
+			return false;
+		}
+
+		info.m_Ready     = true;
+		info.m_ReadyTime = Clock::now();
+		++m_ReadyPackets;
+		listWriteSlot(i);
+		if (info.m_Delivery == EDelivery::Reliable && m_Channels[info.m_Channel].m_Ordered)
+		{
+			PeerChannelInfo& channel { packetPeer(info).m_Channels[info.m_Channel] };
+			info.m_Ordered = true;
+			info.m_Order   = channel.m_SendOrder++;
+		}
+		if (info.m_Delivery != EDelivery::Sequenced)
+			return true;
+
+		// Latest value wins
+		PeerChannelInfo& channel { packetPeer(info).m_Channels[info.m_Channel] };
+		std::uint32_t    pending { channel.m_SequencedWriteSlot };
+		if (pending < m_MaxWritePackets && pending != i && m_WritePacketInfos[pending].m_Ready && IsSequencedSlot(m_WritePacketInfos[pending], info.m_Endpoint, info.m_Channel))
+			freeWriteSlot(pending);
+		channel.m_SequencedWriteSlot = i;
+		return true;
+	}
+
+	void PacketHandler::setPacketEndpoint(std::uint16_t id, Networking::Endpoint endpoint)
+	{
+		if (!id)
+			return;
+
+		std::uint32_t i { findWriteSlot(id) };
+		if (i != Utils::SlotIndex<std::uint16_t>::s_Invalid)
+			m_WritePacketInfos[i].m_Endpoint = endpoint;
+	}
+
+	void PacketHandler::freeReadPacket(Networking::Endpoint endpoint, std::uint16_t id)
+	{
+		if (!id)
+			return;
+
+		std::uint32_t i { findReadSlot(endpoint, id) };
+		if (i != Utils::SlotIndex<PacketKey>::s_Invalid)
+			freeReadSlot(i);
+	}
+
+	void PacketHandler::freeWritePacket(std::uint16_t id)
+	{
+		if (!id)
+			return;
+
+		std::uint32_t i { findWriteSlot(id) };
+		if (i != Utils::SlotIndex<std::uint16_t>::s_Invalid)
+			freeWriteSlot(i);
+	}
+
+	void PacketHandler::freeReadSlot(std::uint32_t slot)
+	{
+		ReadPacketInfo& info = m_ReadPacketInfos[slot];
+		if (info.m_Start != ~0U)
+			m_ReadAllocator.free(info.m_Start - 4096U);
+
+		if (HasDynamicBits(info))
+			delete[] info.m_BitsDynamic;
+		releaseReadSlot(slot);
+	}
+
+	void PacketHandler::freeWriteSlot(std::uint32_t slot)
+	{
+		WritePacketInfo& info = m_WritePacketInfos[slot];
+		if (info.m_Start != ~0U)
+			m_WriteAllocator.free(info.m_Start - 4096U);
+
+		// After the release so the callback can start another stream
+		StreamSource source { info.m_Stream ? info.m_Source : StreamSource {} };
+		bool         delivered { info.m_Stream && info.m_SectionSize && info.m_StreamBase >= RequiredSections(info.m_Size, info.m_SectionSize) };
+		if (HasDynamicBits(info))
+			delete[] info.m_BitsDynamic;
+		releaseWriteSlot(slot);
+		if (source.m_Done)
+			source.m_Done(source.m_UserData, delivered);
+	}
+
+	std::uint8_t* PacketHandler::allocateReadPacket(std::uint32_t size, std::uint16_t id, std::uint16_t rev, Networking::Endpoint endpoint, std::uint32_t sectionSize)
+	{
+		return allocateReadBlock(size, size, id, rev, endpoint, sectionSize);
+	}
+
+	std::uint8_t* PacketHandler::allocateReadBlock(std::uint32_t size, std::uint32_t blockSize, std::uint16_t id, std::uint16_t rev, Networking::Endpoint endpoint, std::uint32_t sectionSize)
+	{
+		PeerInfo* peer { availableReadPackets() && sectionSize ? acquirePeer(endpoint) : nullptr };
+		if (!peer)
+		{
+			id = 0U;
+			return nullptr;
+		}
+
+		std::uint32_t offset = m_ReadAllocator.allocate(blockSize);
+		if (offset == Utils::BlockAllocator::s_Invalid)
+		{
+			id = 0U;
+			return nullptr;
+		}
+
+		std::uint32_t start = 4096U + offset;
+		std::uint8_t* ptr   = m_ReadBuffer + start;
+
+		// The same packet may not be allocated twice
+		std::uint32_t i = acquireReadSlot();
+		if (!m_ReadPacketIndex.insert({ endpoint, id }, i))
+		{
+			m_FreeReadSlots[m_FreeReadSlotCount++] = i;
+			m_ReadAllocator.free(offset);
+			return nullptr;
+		}
+
+		ReadPacketInfo& info { m_ReadPacketInfos[i] };
+		info.m_ID       = id;
+		info.m_Rev      = rev;
+		info.m_Start    = start;
+		info.m_Size     = size;
+		info.m_Endpoint = endpoint;
+		info.m_Peer     = static_cast<std::uint32_t>(peer - m_PeerInfos);
+		info.m_AckStart = ~0U;
+		info.m_AckEnd   = 0U;
+		usePeer(info.m_Peer);
+
+		info.m_SectionSize = sectionSize;
+		if (HasDynamicBits(info))
+			info.m_BitsDynamic = new std::uint8_t[(RequiredSections(size, sectionSize) + 7) / 8];
+		ResetSectionBits(info, RequiredSections(size, sectionSize));
+		info.m_Time = {};
+		return ptr;
+	}
+
+	std::uint8_t* PacketHandler::allocateWritePacket(std::uint32_t size, std::uint16_t& id, EDelivery delivery, std::uint16_t channel)
+	{
+		if (!availableWritePackets() || channel >= s_MaxChannels)
+		{
+			id = 0U;
+			return nullptr;
+		}
+
+		std::uint32_t offset = m_WriteAllocator.allocate(size);
+		if (offset == Utils::BlockAllocator::s_Invalid)
+		{
+			id = 0U;
+			return nullptr;
+		}
+
+		id                  = newPacketID();
+		std::uint32_t start = 4096U + offset;
+		std::uint8_t* ptr   = m_WriteBuffer + start;
+
+		std::uint32_t i = acquireWriteSlot();
+		if (!m_WritePacketIndex.insert(id, i))
+		{
+			m_FreeWriteSlots[m_FreeWriteSlotCount++] = i;
+			m_WriteAllocator.free(offset);
+			id = 0U;
+			return nullptr;
+		}
+
+		WritePacketInfo& info { m_WritePacketInfos[i] };
+		info.m_Type     = EPacketHeaderType::Normal;
+		info.m_ID       = id;
+		info.m_Rev      = 0U;
+		info.m_Start    = start;
+		info.m_Size     = size;
+		info.m_Endpoint = {};
+		info.m_Delivery = delivery;
+		info.m_Channel  = channel;
+		info.m_Order    = 0U;
+		info.m_Ordered  = false;
+		info.m_Ready    = false;
+		info.m_Bits     = 0U;
+		info.m_Time     = {};
+
+		info.m_SectionSize = 0U;
+		return ptr;
+	}
+
+	void PacketHandler::acknowledgePacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t index, std::uint16_t rev)
+	{
+		std::uint32_t i { findReadSlot(endpoint, id) };
+		if (i == Utils::SlotIndex<PacketKey>::s_Invalid)
+		{
+			sendAcknowledgeRange(endpoint, id, rev, index, index, nullptr);
+			return;
+		}
+
+		// Merged into one range, sent by flushAcknowledges
+		ReadPacketInfo& info = m_ReadPacketInfos[i];
+		if (info.m_AckStart == ~0U)
+		{
+			if (m_PendingAckCount == m_MaxReadPackets)
+				flushAcknowledges();
+			m_PendingAcks[m_PendingAckCount++] = i;
+
+			info.m_AckStart = index;
+			info.m_AckEnd   = index;
+		}
+		else
+		{
+			info.m_AckStart = std::min<std::uint32_t>(info.m_AckStart, index);
+			info.m_AckEnd   = std::max<std::uint32_t>(info.m_AckEnd, index);
+		}
+	}
+
+	void PacketHandler::flushAcknowledges()
+	{
+		for (std::uint32_t i { 0 }; i < m_PendingAckCount; ++i)
+			flushAcknowledge(m_PendingAcks[i]);
+		m_PendingAckCount = 0U;
+	}
+
+	void PacketHandler::rejectPacket(Networking::Endpoint endpoint, std::uint16_t id, std::uint16_t rev)
+	{
+		m_Stats.m_RejectsSent.add();
+		if (availableWritePackets())
+		{
+			std::uint32_t    slot { acquireWriteSlot() };
+			WritePacketInfo& info { m_WritePacketInfos[slot] };
+			info.m_Type     = EPacketHeaderType::Reject;
+			info.m_ID       = id;
+			info.m_Index    = 0U;
+			info.m_Rev      = rev;
+			info.m_Endpoint = endpoint;
+			info.m_Ready    = true;
+			info.m_Bits     = 0U;
+			info.m_Time     = {};
+			listWriteSlot(slot);
+		}
+		else
+		{
+			auto header     = reinterpret_cast<RejectPacketHeader*>(m_WriteBuffer);
+			*header         = {};
+			header->m_ID    = id;
+			header->m_Index = 0U;
+			header->m_Rev   = rev;
+			m_Socket.writeTo(m_WriteBuffer, sizeof(RejectPacketHeader), endpoint);
+		}
+	}
+
+	void PacketHandler::sendMaxSizePacket(Networking::Endpoint endpoint, std::uint16_t id)
+	{
+		if (availableWritePackets())
+		{
+			std::uint32_t    slot { acquireWriteSlot() };
+			WritePacketInfo& info { m_WritePacketInfos[slot] };
+			info.m_Type     = EPacketHeaderType::MaxSize;
+			info.m_ID       = id;
+			info.m_Index    = 0U;
+			info.m_Rev      = 0U;
+			info.m_Endpoint = endpoint;
+			info.m_Ready    = true;
+			info.m_Bits     = 0U;
+			info.m_Time     = {};
+			listWriteSlot(slot);
+		}
+		else
+		{
+			auto header    = reinterpret_cast<MaxSizePacketHeader*>(m_WriteBuffer);
+			*header        = {};
+			header->m_ID   = id;
+			header->m_Size = maxReadPacketSize();
+
+			header->m_DatagramSize = static_cast<std::uint16_t>(m_MaxDatagramSize);
+			m_Socket.writeTo(m_WriteBuffer, sizeof(MaxSizePacketHeader), endpoint);
+		}
+	}
+
+	void PacketHandler::requestMaxSize(Networking::Endpoint endpoint)
+	{
+		auto header { reinterpret_cast<MaxSizePacketHeader*>(beginDatagram()) };
+		*header                = {};
+		header->m_ID           = 0U;
+		header->m_Size         = 0U;
+		header->m_DatagramSize = static_cast<std::uint16_t>(m_MaxDatagramSize);
+		endDatagram(sizeof(MaxSizePacketHeader), endpoint);
+	}
+
+	bool PacketHandler::hasHandledSection(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t index, std::uint16_t rev)
+	{
+		if (!id)
+			return true;
+
+		std::uint32_t i { findReadSlot(endpoint, id) };
+		if (i == Utils::SlotIndex<PacketKey>::s_Invalid)
+			return true;
+
+		ReadPacketInfo& info = m_ReadPacketInfos[i];
+		if (rev < info.m_Rev)
+			return true;
+
+		if (index >= RequiredSections(info.m_Size, info.m_SectionSize))
+			return true;
+
+		return TestSectionBit(info, index);
+	}
+
+	bool PacketHandler::receivedSection(Networking::Endpoint endpoint, std::uint16_t id, std::uint32_t index, std::uint16_t rev, const std::uint8_t* section, std::uint32_t dataSize)
+	{
+		if (!id)
+			return false;
+
+		std::uint32_t i { findReadSlot(endpoint, id) };
+		if (i == Utils::SlotIndex<PacketKey>::s_Invalid)
+			return false;
+
+		ReadPacketInfo& info = m_ReadPacketInfos[i];
+		if (rev < info.m_Rev)
+			return true;
+
+		if (rev > info.m_Rev)
+		{
+			// A new revision keeps the block and only resets the sections
+			info.m_Rev = rev;
+			ResetSectionBits(info, RequiredSections(info.m_Size, info.m_SectionSize));
+		}
+
+		if (index >= RequiredSections(info.m_Size, info.m_SectionSize))
+			return true;
+
+		std::uint32_t offset = index * info.m_SectionSize;
+		std::uint32_t size   = std::min<std::uint32_t>(info.m_SectionSize, info.m_Size - offset);
+		if (dataSize < size)
+			return false;
+
+		SetSectionBit(info, index);
+		setReadTime(i, Clock::now());
+
+		std::memcpy(sectionData(info, index), section, size);
+
+		return true;
+	}
+
+	bool PacketHandler::readPacketDone(Networking::Endpoint endpoint, std::uint16_t id)
+	{
+		if (!id)
+			return false;
+
+		std::uint32_t i { findReadSlot(endpoint, id) };
+		if (i == Utils::SlotIndex<PacketKey>::s_Invalid)
+			return false;
+
+		ReadPacketInfo& info = m_ReadPacketInfos[i];
+		if (info.m_Stream)
+		{
+			for (std::uint32_t index { info.m_StreamBase }; index < RequiredSections(info.m_Size, info.m_SectionSize); ++index)
+				if (!TestSectionBit(info, index))
+					return false;
+			return true;
+		}
+		return AllSectionBitsSet(info, RequiredSections(info.m_Size, info.m_SectionSize));
+	}
+
+	std::uint16_t PacketHandler::newPacketID()
+	{
+		std::uint16_t id { m_NextPacketID };
+		while (hasUsedPacketID(id))
+			++id;
+		m_NextPacketID = static_cast<std::uint16_t>(id + 1U);
+		return id;
+	}
+
+	bool PacketHandler::hasUsedPacketID(std::uint16_t id) const
+	{
+		return !id || m_WritePacketIndex.contains(id);
+	}
+
+	bool PacketHandler::hasHandledPacketID(Networking::Endpoint endpoint, std::uint16_t id) const
+	{
+		PeerInfo* peer { findPeer(endpoint) };
+		return peer && getPacketIDState(*peer, id, Clock::now()) == Utils::ESequenceState::Handled;
+	}
+
+	Utils::ESequenceState PacketHandler::getPacketIDState(const PeerInfo& peer, std::uint16_t id, Clock::time_point now) const
+	{
+		if (!peer.m_HandledPacketTime.time_since_epoch().count() || std::chrono::duration_cast<std::chrono::duration<float>>(now - peer.m_HandledPacketTime).count() >= m_ReadTimeout)
+			return Utils::ESequenceState::New;
+		return peer.m_HandledPacketIDs.getState(id);
+	}
+
+	void PacketHandler::markPacketIDHandled(PeerInfo& peer, std::uint16_t id, Clock::time_point now)
+	{
+		if (!peer.m_HandledPacketTime.time_since_epoch().count() || std::chrono::duration_cast<std::chrono::duration<float>>(now - peer.m_HandledPacketTime).count() >= m_ReadTimeout)
+			peer.m_HandledPacketIDs.reset();
+		if (peer.m_HandledPacketIDs.mark(id))
+			peer.m_HandledPacketTime = now;
+	}
+
+	std::uint32_t PacketHandler::getRequiredSections(std::uint32_t size, std::uint32_t sectionSize) const
+	{
+		return RequiredSections(size, sectionSize);
+	}
+
+	std::uint32_t PacketHandler::getSectionSize(Networking::Endpoint endpoint) const
+	{
+		PeerInfo* peer { findPeer(endpoint) };
+		if (!peer)
+			return std::min(Utils::PathMTUSearch::s_BaseSize, m_MaxDatagramSize) - sizeof(PacketHeader);
+		return peerDatagramSize(*peer) - sizeof(PacketHeader);
+	}
+
+	const Utils::RoundTripEstimator* PacketHandler::getRoundTrip(Networking::Endpoint endpoint) const
+	{
+		PeerInfo* peer { findPeer(endpoint) };
+		return peer ? &peer->m_RoundTrip : nullptr;
+	}
+
+	const Utils::CongestionController* PacketHandler::getCongestion(Networking::Endpoint endpoint) const
+	{
+		PeerInfo* peer { findPeer(endpoint) };
+		return peer ? &peer->m_Congestion : nullptr;
+	}
+
+	void PacketHandler::setStreamReceive(StreamCallback callback, std::uint32_t minSize, std::uint32_t windowSize)
+	{
+		m_StreamCallback   = callback;
+		m_StreamMinSize    = minSize;
+		m_StreamWindowSize = windowSize;
+	}
+
+	bool PacketHandler::getPeerStats(Networking::Endpoint endpoint, PeerStats& stats) const
+	{
+		PeerInfo* peer { findPeer(endpoint) };
+		if (!peer)
+			return false;
+		stats = peer->m_Stats;
+		return true;
+	}
+
+	void PacketHandler::setCongestionControl(Utils::ECongestionControl control)
+	{
+		m_CongestionControl = control;
+		for (std::uint32_t i { 0 }; i < m_MaxPeers; ++i)
+			m_PeerInfos[i].m_Congestion.reset(m_CongestionControl, m_SendCount, m_SendoutTimer);
+	}
+
+	void PacketHandler::setPathProbing(bool probing)
+	{
+		m_PathProbing = probing;
+		m_Socket.setDontFragment(probing);
+		if (!probing)
+			return;
+
+		Clock::time_point now { Clock::now() };
+		for (std::uint32_t i { 0 }; i < m_MaxPeers; ++i)
+		{
+			if (m_PeerInfos[i].m_Sending)
+				schedulePeer(m_PeerInfos[i], now);
+		}
+	}
+
+	void PacketHandler::setChannel(std::uint16_t channel, std::uint8_t priority, std::uint8_t weight, bool ordered)
+	{
+		if (channel >= s_MaxChannels)
+			return;
+
+		ChannelInfo& info { m_Channels[channel] };
+		info.m_Priority = priority;
+		info.m_Weight   = std::max<std::uint8_t>(weight, 1U);
+		info.m_Ordered  = ordered;
+		std::stable_sort(m_ChannelOrder, m_ChannelOrder + s_MaxChannels, [this](std::uint16_t lhs, std::uint16_t rhs) { return m_Channels[lhs].m_Priority < m_Channels[rhs].m_Priority; });
+	}
+
+	void PacketHandler::setChannelParity(std::uint16_t channel, std::uint8_t parityGroup)
+	{
+		if (channel < s_MaxChannels)
+			m_Channels[channel].m_ParityGroup = parityGroup;
+	}
+
+	std::uint64_t PacketHandler::deadlineTick(Clock::time_point time) const
+	{
+		return static_cast<std::uint64_t>(std::chrono::ceil<std::chrono::milliseconds>(time - m_TimerStart).count());
+	}
+
+	void PacketHandler::setReadTime(std::uint32_t slot, Clock::time_point time)
+	{
+		m_ReadPacketInfos[slot].m_Time = time;
+		m_Timers.schedule(slot, deadlineTick(time + Seconds(m_ReadTimeout)));
+	}
+
+	void PacketHandler::setWriteTime(std::uint32_t slot, Clock::time_point time)
+	{
+		m_WritePacketInfos[slot].m_Time = time;
+		m_Timers.schedule(m_MaxReadPackets + slot, deadlineTick(time + Seconds(m_WriteTimeout)));
+	}
+
+	void PacketHandler::listWriteSlot(std::uint32_t slot)
+	{
+		WritePacketInfo& info { m_WritePacketInfos[slot] };
+		if (info.m_SendListIndex != ~0U)
+			return;
+
+		info.m_SendListIndex          = m_SendListCount;
+		m_SendList[m_SendListCount++] = slot;
+		m_SendPending                 = true;
+	}
+
+	void PacketHandler::unlistWriteSlot(std::uint32_t slot)
+	{
+		WritePacketInfo& info { m_WritePacketInfos[slot] };
+		if (info.m_SendListIndex == ~0U)
+			return;
+
+		std::uint32_t last { m_SendList[--m_SendListCount] };
+		m_SendList[info.m_SendListIndex]         = last;
+		m_WritePacketInfos[last].m_SendListIndex = info.m_SendListIndex;
+		info.m_SendListIndex                     = ~0U;
+	}
+
+	void PacketHandler::waitForRetransmit(std::uint32_t slot)
+	{
+		unlistWriteSlot(slot);
+		m_Timers.schedule(m_MaxReadPackets + m_MaxWritePackets + slot, deadlineTick(m_WritePacketInfos[slot].m_RetransmitTime));
+	}
+
+	const std::uint8_t* PacketHandler::sectionData(const WritePacketInfo& info, std::uint32_t index) const
+	{
+		if (info.m_Stream && info.m_Source.m_Data)
+			return info.m_Source.m_Data + index * info.m_SectionSize;
+		if (info.m_Stream)
+			return m_WriteBuffer + info.m_Start + (index % info.m_StreamWindow) * info.m_SectionSize;
+		return m_WriteBuffer + info.m_Start + index * info.m_SectionSize;
+	}
+
+	std::uint8_t* PacketHandler::sectionData(const ReadPacketInfo& info, std::uint32_t index) const
+	{
+		return m_ReadBuffer + info.m_Start + (info.m_Stream ? index % info.m_StreamWindow : index) * info.m_SectionSize;
+	}
+
+	void PacketHandler::flushAcknowledge(std::uint32_t slot)
+	{
+		ReadPacketInfo& info = m_ReadPacketInfos[slot];
+		if (info.m_AckStart == ~0U)
+			return;
+
+		sendAcknowledgeRange(info.m_Endpoint, info.m_ID, info.m_Rev, info.m_AckStart, info.m_AckEnd, &info);
+		info.m_AckStart = ~0U;
+		info.m_AckEnd   = 0U;
+	}
+
+	void PacketHandler::sendAcknowledgeRange(Networking::Endpoint endpoint, std::uint16_t id, std::uint16_t rev, std::uint32_t first, std::uint32_t last, const ReadPacketInfo* info)
+	{
+		// Acknowledgements never need a probed size
+		static constexpr std::uint32_t MaxBitsPerDatagram = (Utils::PathMTUSearch::s_BaseSize - sizeof(AcknowledgeRangePacketHeader)) * 8U;
+
+		while (first <= last)
+		{
+			std::uint32_t count { std::min<std::uint32_t>(last - first + 1U, MaxBitsPerDatagram) };
+
+			std::uint8_t* datagram { beginDatagram() };
+			auto          header { reinterpret_cast<AcknowledgeRangePacketHeader*>(datagram) };
+			*header         = {};
+			header->m_ID    = id;
+			header->m_Index = first;
+			header->m_Rev   = rev;
+			header->m_Count = count;
+
+			std::uint8_t* bits { datagram + sizeof(AcknowledgeRangePacketHeader) };
+			std::uint32_t numBytes { (count + 7) / 8 };
+			std::memset(bits, info ? 0 : 0xFF, numBytes);
+			if (info)
+			{
+				for (std::uint32_t j { 0 }; j < count; ++j)
+					if (TestSectionBit(*info, first + j))
+						bits[j / 8] |= 1U << (j % 8);
+			}
+			endDatagram(sizeof(AcknowledgeRangePacketHeader) + numBytes, endpoint);
+			m_Stats.m_AcknowledgesSent.add();
+
+			if (last - first < count)
+				break;
+			first += count;
+		}
+	}
+
+	std::uint8_t* PacketHandler::beginDatagram()
+	{
+		if (m_SendDatagramCount == m_BatchSize)
+			flushDatagrams();
+		return m_SendBatch + m_SendDatagramCount * m_MaxDatagramSize;
+	}
+
+	void PacketHandler::endDatagram(std::size_t size, Networking::Endpoint endpoint, const void* payload, std::size_t payloadSize)
+	{
+		m_SendDatagrams[m_SendDatagramCount] = { m_SendBatch + m_SendDatagramCount * m_MaxDatagramSize, size, endpoint, payload, payloadSize };
+		++m_SendDatagramCount;
+	}
+
+	void PacketHandler::endDatagram(std::size_t size, const PeerInfo& peer, const void* payload, std::size_t payloadSize)
+	{
+		m_SendAddresses[m_SendDatagramCount] = peer.m_Address;
+		m_SendDatagrams[m_SendDatagramCount] = { m_SendBatch + m_SendDatagramCount * m_MaxDatagramSize, size, peer.m_Endpoint, payload, payloadSize, &m_SendAddresses[m_SendDatagramCount] };
+		++m_SendDatagramCount;
+	}
+
+	void PacketHandler::flushDatagrams()
+	{
+		if (!m_SendDatagramCount)
+			return;
+
+		std::size_t       handled { m_Socket.writeToMany(m_SendDatagrams, m_SendDatagramCount) };
+		Clock::time_point now { Clock::now() };
+		for (std::size_t i { 0 }; i < m_SendDatagramCount; ++i)
+		{
+			const Networking::Datagram& datagram { m_SendDatagrams[i] };
+			if (i < handled && !datagram.m_Rejected)
+			{
+				m_Stats.m_DatagramsSent.add();
+				m_Stats.m_BytesSent.add(datagram.m_Size + datagram.m_PayloadSize);
+				continue;
+			}
+
+			// Never reaches the peer, so it backs off as if the datagram was lost on the way
+			m_Stats.m_DatagramsDropped.add();
+			PeerInfo* peer { findPeer(datagram.m_Endpoint) };
+			if (!peer)
+				continue;
+
+			// A probe over the link MTU fails with MessageTooLarge instead of being fragmented
+			auto header { static_cast<const MaxSizePacketHeader*>(datagram.m_Buffer) };
+			if (peer->m_ProbeSize && datagram.m_Size == peer->m_ProbeSize && GetPacketHeaderType(header->m_MagicNumber) == EPacketHeaderType::MaxSize && header->m_Probe == EMaxSizeProbe::Probe)
+			{
+				peer->m_PathMTU.probeLost(peer->m_ProbeSize);
+				peer->m_ProbeSize = 0U;
+				schedulePeer(*peer, now);
+				continue;
+			}
+			peerLost(*peer, now);
+		}
+		m_SendDatagramCount = 0U;
+	}
+
+	std::uint32_t PacketHandler::findReadSlot(Networking::Endpoint endpoint, std::uint16_t id) const
+	{
+		return m_ReadPacketIndex.find({ endpoint, id });
+	}
+
+	std::uint32_t PacketHandler::findWriteSlot(std::uint16_t id) const
+	{
+		return m_WritePacketIndex.find(id);
+	}
+
+	std::uint32_t PacketHandler::findSentSlot(Networking::Endpoint endpoint, std::uint16_t id) const
+	{
+		return m_SentPacketIndex.find({ endpoint, id });
+	}
+
+	std::uint32_t PacketHandler::acquireReadSlot()
+	{
+		return m_FreeReadSlots[--m_FreeReadSlotCount];
+	}
+
+	std::uint32_t PacketHandler::acquireWriteSlot()
+	{
+		return m_FreeWriteSlots[--m_FreeWriteSlotCount];
+	}
+
+	void PacketHandler::releaseReadSlot(std::uint32_t slot)
+	{
+		ReadPacketInfo& info = m_ReadPacketInfos[slot];
+		m_ReadPacketIndex.erase({ info.m_Endpoint, info.m_ID });
+		if (info.m_Held && info.m_Ordered)
+			m_HeldPacketIndex.erase({ info.m_Endpoint, info.m_Channel, info.m_Order });
+		m_Timers.cancel(slot);
+		if (info.m_Peer < m_MaxPeers)
+			unusePeer(info.m_Peer);
+		info.m_ID       = 0U;
+		info.m_Rev      = 0U;
+		info.m_Start    = ~0U;
+		info.m_Size     = 0U;
+		info.m_Endpoint = {};
+		info.m_Peer     = ~0U;
+		info.m_Delivery = EDelivery::Reliable;
+		info.m_Channel  = 0U;
+		info.m_Order    = 0U;
+		info.m_Ordered  = false;
+		info.m_Held     = false;
+
+		info.m_Coalesced    = false;
+		info.m_Stream       = false;
+		info.m_StreamWindow = 0U;
+		info.m_StreamBase   = 0U;
+
+		info.m_ParityGroup = 0U;
+		info.m_Bits        = 0U;
+		info.m_AckStart    = ~0U;
+		info.m_AckEnd      = 0U;
+		info.m_Time        = {};
+
+		info.m_SectionSize = 0U;
+
+		m_FreeReadSlots[m_FreeReadSlotCount++] = slot;
+	}
+
+	void PacketHandler::releaseWriteSlot(std::uint32_t slot)
+	{
+		WritePacketInfo& info = m_WritePacketInfos[slot];
+		m_Timers.cancel(m_MaxReadPackets + slot);
+		m_Timers.cancel(m_MaxReadPackets + m_MaxWritePackets + slot);
+		unlistWriteSlot(slot);
+		if (info.m_Type == EPacketHeaderType::Normal && info.m_ReadyTime.time_since_epoch().count())
+			--m_ReadyPackets;
+		if (info.m_InFlight && info.m_Peer < m_MaxPeers && m_PeerInfos[info.m_Peer].m_Endpoint == info.m_Endpoint)
+			m_PeerInfos[info.m_Peer].m_Congestion.removeInFlight(info.m_InFlight);
+		if (info.m_Peer < m_MaxPeers)
+			unusePeer(info.m_Peer);
+		if (info.m_Type == EPacketHeaderType::Normal)
+			m_WritePacketIndex.erase(info.m_ID);
+		if (info.m_Type == EPacketHeaderType::Normal && info.m_Delivery == EDelivery::Reliable && info.m_SectionSize)
+			m_SentPacketIndex.erase({ info.m_Endpoint, info.m_Sequence });
+		info.m_Type     = EPacketHeaderType::Normal;
+		info.m_ID       = 0U;
+		info.m_Sequence = 0U;
+		info.m_Index    = 0U;
+		info.m_Rev      = 0U;
+		info.m_Start    = ~0U;
+		info.m_Size     = 0U;
+		info.m_Endpoint = {};
+		info.m_Delivery = EDelivery::Reliable;
+		info.m_Channel  = 0U;
+		info.m_Order    = 0U;
+		info.m_Ordered  = false;
+		info.m_Ready    = false;
+		info.m_Bits     = 0U;
+		info.m_Time     = {};
+
+		info.m_Coalesced       = false;
+		info.m_Coalescing      = false;
+		info.m_ParityGroup     = 0U;
+		info.m_SectionSize     = 0U;
+		info.m_SendIndex       = 0U;
+		info.m_InFlight        = 0U;
+		info.m_Peer            = ~0U;
+		info.m_SendTime        = {};
+		info.m_RetransmitTime  = {};
+		info.m_SampleIndex     = 0U;
+		info.m_Retransmissions = 0U;
+		info.m_ReadyTime       = {};
+		info.m_Stream          = false;
+		info.m_Source          = {};
+		info.m_StreamWindow    = 0U;
+		info.m_StreamBase      = 0U;
+		info.m_StreamLoaded    = 0U;
+		info.m_StreamResent    = 0U;
+
+		m_FreeWriteSlots[m_FreeWriteSlotCount++] = slot;
+	}
+
+	PeerInfo* PacketHandler::findPeer(Networking::Endpoint endpoint) const
+	{
+		std::uint32_t slot { m_PeerIndex.find(endpoint) };
+		return slot != Utils::SlotIndex<Networking::Endpoint>::s_Invalid ? &m_PeerInfos[slot] : nullptr;
+	}
+
+	PeerInfo* PacketHandler::acquirePeer(Networking::Endpoint endpoint)
+	{
+		PeerInfo* peer { findPeer(endpoint) };
+		if (peer)
+			return peer;
+
+		// The least recently seen peer loses its handled IDs even if it still retransmits
+		Clock::time_point now { Clock::now() };
+		std::uint32_t     index { m_OldestPeer };
+		if (index == ~0U)
+		{
+			m_Stats.m_PeersExhausted.add();
+			return nullptr;
+		}
+
+		// Erased first, so the index never holds more than m_MaxPeers entries and the insert succeeds
+		peer = &m_PeerInfos[index];
+		if (peer->m_LastSeen.time_since_epoch().count())
+			m_PeerIndex.erase(peer->m_Endpoint);
+		m_PeerIndex.insert(endpoint, index);
+		m_Timers.cancel(m_MaxReadPackets + 2U * m_MaxWritePackets + index);
+
+		peer->m_Endpoint = endpoint;
+		peer->m_Address  = Networking::SocketAddress::FromEndpoint(endpoint);
+		peer->m_RoundTrip.reset();
+		peer->m_Congestion.reset(m_CongestionControl, m_SendCount, m_SendoutTimer);
+		peer->m_LastRefill = now;
+		peer->m_LastLoss   = {};
+		touchPeer(*peer, now);
+
+		peer->m_MaxDatagramSize = 0U;
+		peer->m_MaxPacketSize   = 0U;
+		peer->m_PathMTU.reset(m_MaxDatagramSize);
+		peer->m_ProbeSize    = 0U;
+		peer->m_RequestCount = 0U;
+		peer->m_RequestTime  = {};
+		peer->m_Sending      = false;
+
+		for (PeerChannelInfo& channel : peer->m_Channels)
+			channel = {};
+		for (std::uint32_t& slot : peer->m_CoalesceSlots)
+			slot = ~0U;
+		// A restarted sender must not reuse IDs still in the receiver's window
+		peer->m_SendPacketID = static_cast<std::uint16_t>(rand()) | 1U;
+		peer->m_HandledPacketIDs.reset();
+		peer->m_HandledPacketTime = {};
+		peer->m_Stats             = {};
+		return peer;
+	}
+
+	PeerInfo& PacketHandler::packetPeer(WritePacketInfo& info)
+	{
+		if (info.m_Peer < m_MaxPeers && m_PeerInfos[info.m_Peer].m_Endpoint == info.m_Endpoint)
+			return m_PeerInfos[info.m_Peer];
+		if (info.m_Peer < m_MaxPeers)
+			unusePeer(info.m_Peer);
+
+		// Every other slot uses at most one peer, so one is always unused
+		PeerInfo* acquired { acquirePeer(info.m_Endpoint) };
+		assert(acquired);
+		PeerInfo& peer { *acquired };
+		info.m_Peer = static_cast<std::uint32_t>(&peer - m_PeerInfos);
+		usePeer(info.m_Peer);
+		if (!peer.m_Sending)
+		{
+			peer.m_Sending = true;
+			schedulePeer(peer, Clock::now());
+		}
+		return peer;
+	}
+
+	void PacketHandler::usePeer(std::uint32_t peer)
+	{
+		if (!m_PeerInfos[peer].m_Slots++)
+			unlinkPeer(peer);
+	}
+
+	void PacketHandler::unusePeer(std::uint32_t peer)
+	{
+		if (!--m_PeerInfos[peer].m_Slots)
+			linkPeer(peer);
+	}
+
+	void PacketHandler::touchPeer(PeerInfo& peer, Clock::time_point now)
+	{
+		peer.m_LastSeen = now;
+		if (peer.m_Slots)
+			return;
+
+		std::uint32_t index { static_cast<std::uint32_t>(&peer - m_PeerInfos) };
+		unlinkPeer(index);
+		linkPeer(index);
+	}
+
+	void PacketHandler::peerLost(PeerInfo& peer, Clock::time_point now)
+	{
+		if (now - peer.m_LastLoss < Seconds(peer.m_RoundTrip.getSmoothedRTT()))
+			return;
+		peer.m_Congestion.lost();
+		peer.m_LastLoss = now;
+		m_Stats.m_LossEvents.add();
+		peer.m_Stats.m_LossEvents.add();
+	}
+
+	void PacketHandler::linkPeer(std::uint32_t peer)
+	{
+		m_PeerInfos[peer].m_Older = m_NewestPeer;
+		m_PeerInfos[peer].m_Newer = ~0U;
+		if (m_NewestPeer != ~0U)
+			m_PeerInfos[m_NewestPeer].m_Newer = peer;
+		else
+			m_OldestPeer = peer;
+		m_NewestPeer = peer;
+	}
+
+	void PacketHandler::unlinkPeer(std::uint32_t peer)
+	{
+		PeerInfo& info { m_PeerInfos[peer] };
+		if (info.m_Older != ~0U)
+			m_PeerInfos[info.m_Older].m_Newer = info.m_Newer;
+		else
+			m_OldestPeer = info.m_Newer;
+		if (info.m_Newer != ~0U)
+			m_PeerInfos[info.m_Newer].m_Older = info.m_Older;
+		else
+			m_NewestPeer = info.m_Older;
+		info.m_Older = ~0U;
+		info.m_Newer = ~0U;
+	}
+
+	void PacketHandler::updatePeer(PeerInfo& peer, Clock::time_point now)
+	{
+		if (!peer.m_Sending)
+			return;
+
+		if (!peer.m_MaxDatagramSize)
+		{
+			if (peer.m_RequestCount >= Utils::PathMTUSearch::s_MaxProbes)
+				return;
+
+			Clock::time_point due { peer.m_RequestTime + Seconds(peer.m_RoundTrip.getBackoffTimeout(peer.m_RequestCount)) };
+			if (peer.m_RequestCount && now < due)
+			{
+				schedulePeer(peer, due);
+				return;
+			}
+
+			requestMaxSize(peer.m_Endpoint);
+			++peer.m_RequestCount;
+			peer.m_RequestTime = now;
+			schedulePeer(peer, now + Seconds(peer.m_RoundTrip.getBackoffTimeout(peer.m_RequestCount)));
+			return;
+		}
+
+		if (!m_PathProbing)
+			return;
+
+		if (peer.m_ProbeSize)
+		{
+			Clock::time_point due { peer.m_RequestTime + Seconds(peer.m_RoundTrip.getRetransmitTimeout()) };
+			if (now < due)
+			{
+				schedulePeer(peer, due);
+				return;
+			}
+
+			peer.m_PathMTU.probeLost(peer.m_ProbeSize);
+			peer.m_ProbeSize = 0U;
+		}
+
+		std::uint32_t probeSize { peer.m_PathMTU.nextProbe() };
+		if (!probeSize)
+			return;
+
+		std::uint8_t* datagram { beginDatagram() };
+		auto          header { reinterpret_cast<MaxSizePacketHeader*>(datagram) };
+		*header                = {};
+		header->m_ID           = 0U;
+		header->m_Size         = 0U;
+		header->m_DatagramSize = static_cast<std::uint16_t>(probeSize);
+		header->m_Probe        = EMaxSizeProbe::Probe;
+		std::memset(datagram + sizeof(MaxSizePacketHeader), 0, probeSize - sizeof(MaxSizePacketHeader));
+		endDatagram(probeSize, peer);
+
+		peer.m_ProbeSize   = probeSize;
+		peer.m_RequestTime = now;
+		schedulePeer(peer, now + Seconds(peer.m_RoundTrip.getRetransmitTimeout()));
+	}
+
+	void PacketHandler::schedulePeer(const PeerInfo& peer, Clock::time_point time)
+	{
+		m_Timers.schedule(m_MaxReadPackets + 2U * m_MaxWritePackets + static_cast<std::uint32_t>(&peer - m_PeerInfos), deadlineTick(time));
+	}
+
+	void PacketHandler::peerMaxSize(PeerInfo& peer, std::uint32_t maxPacketSize, std::uint32_t maxDatagramSize)
+	{
+		if (maxPacketSize)
+			peer.m_MaxPacketSize = maxPacketSize;
+		if (!maxDatagramSize || maxDatagramSize == peer.m_MaxDatagramSize)
+			return;
+
+		peer.m_MaxDatagramSize = maxDatagramSize;
+		peer.m_PathMTU.reset(std::min(m_MaxDatagramSize, maxDatagramSize));
+		peer.m_ProbeSize = 0U;
+		if (peer.m_Sending && m_PathProbing)
+			schedulePeer(peer, Clock::now());
+	}
+
+	std::uint32_t PacketHandler::maxReadPacketSize() const
+	{
+		std::uint32_t size { m_ReadAllocator.getSize() - Utils::BlockAllocator::s_HeaderSize };
+		return m_StreamCallback && m_StreamMinSize <= size ? ~0U : size;
+	}
+
+	std::uint32_t PacketHandler::peerDatagramSize(const PeerInfo& peer) const
+	{
+		if (!peer.m_MaxDatagramSize)
+			return std::min(Utils::PathMTUSearch::s_BaseSize, m_MaxDatagramSize);
+		if (m_PathProbing)
+			return peer.m_PathMTU.getSize();
+		return std::min(m_MaxDatagramSize, peer.m_MaxDatagramSize);
+	}
+
+	bool PacketHandler::fitsPeer(const PeerInfo* peer, std::uint32_t size) const
+	{
+		if (peer && peer->m_MaxPacketSize && size > peer->m_MaxPacketSize)
+			return false;
+
+		std::uint32_t datagramSize { peer ? peerDatagramSize(*peer) : std::min(Utils::PathMTUSearch::s_BaseSize, m_MaxDatagramSize) };
+		return RequiredSections(size, datagramSize - static_cast<std::uint32_t>(sizeof(PacketHeader))) <= 1U << 20;
 	}
-} // namespace ReliableUDP
\ No newline at end of file
+} // namespace ReliableUDP
@@ -0,0 +1,100 @@
+#include "ReliableUDP/PcapReplay.h"
+
+#include <algorithm>
+
+namespace ReliableUDP
+{
+	PcapReplay::PcapReplay(PacketHandler& handler, float speed)
+	    : m_Handler(handler),
+	      m_Speed(speed) {}
+
+	PcapReplay::~PcapReplay()
+	{
+		close();
+	}
+
+	bool PcapReplay::open(std::string_view path, Networking::Endpoint endpoint, std::uint32_t queueSize)
+	{
+		if (m_Reader.isOpen() || m_Handler.isThreaded() || m_Handler.getSocket().isBound())
+			return false;
+
+		if (!m_Reader.open(path))
+			return false;
+		if (!m_Handler.getSocket().bindMemory(endpoint, queueSize))
+		{
+			m_Reader.close();
+			return false;
+		}
+
+		m_Endpoint   = endpoint;
+		m_AnyAddress = !endpoint.m_Address.isValid() || endpoint.m_Address == Networking::Address { Networking::IPv4Address {} };
+		m_Start      = Clock::now();
+		m_Started    = false;
+		m_Injected   = 0U;
+		readNext();
+		m_FirstTime = m_Next.m_Time;
+		return true;
+	}
+
+	void PcapReplay::close()
+	{
+		if (!m_Reader.isOpen())
+			return;
+
+		m_Reader.close();
+		m_Handler.getSocket().close();
+		m_HasNext = false;
+	}
+
+	bool PcapReplay::step()
+	{
+		Networking::Socket& socket { m_Handler.getSocket() };
+		if (!socket.isMemory())
+			return false;
+
+		if (!m_Started)
+		{
+			m_Start   = Clock::now();
+			m_Started = true;
+		}
+
+		// A full queue keeps the rest for the next step
+		Clock::time_point now { Clock::now() };
+		while (m_HasNext && getNextTime() <= now && socket.inject(m_Next.m_Data, m_Next.m_Size, m_Next.m_Source))
+		{
+			++m_Injected;
+			readNext();
+		}
+		m_Handler.updatePackets();
+		return m_HasNext;
+	}
+
+	void PcapReplay::run()
+	{
+		while (step())
+		{
+			Clock::time_point now { Clock::now() };
+			Clock::time_point next { std::min({ getNextTime(), m_Handler.getNextDeadline(now), now + std::chrono::seconds(1) }) };
+			if (next > now)
+				std::this_thread::sleep_until(next);
+		}
+	}
+
+	Clock::time_point PcapReplay::getNextTime() const
+	{
+		if (!m_HasNext)
+			return Clock::time_point::max();
+		if (m_Speed <= 0.0f || m_Next.m_Time <= m_FirstTime)
+			return m_Start;
+		return m_Start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::nano>(static_cast<double>(m_Next.m_Time - m_FirstTime) / m_Speed));
+	}
+
+	void PcapReplay::readNext()
+	{
+		while ((m_HasNext = m_Reader.next(m_Next)))
+		{
+			if (m_Next.m_Destination.m_Port == m_Endpoint.m_Port && (m_AnyAddress || m_Next.m_Destination.m_Address == m_Endpoint.m_Address))
+				return;
+		}
+	}
+} // namespace ReliableUDP
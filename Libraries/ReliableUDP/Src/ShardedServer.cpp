@@ -0,0 +1,204 @@
+#include "ReliableUDP/ShardedServer.h"
+
+#include <algorithm>
+
+#if BUILD_IS_SYSTEM_WINDOWS
+#include <Windows.h>
+#elif BUILD_IS_SYSTEM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ReliableUDP
+{
+	static void PinThread(PacketHandler& handler, std::uint32_t core)
+	{
+		std::uint32_t cores { std::max(std::thread::hardware_concurrency(), 1U) };
+		core %= cores;
+#if BUILD_IS_SYSTEM_WINDOWS
+		if (core < 64U)
+			::SetThreadAffinityMask(handler.getThreadHandle(), static_cast<DWORD_PTR>(1ULL << core));
+#elif BUILD_IS_SYSTEM_LINUX
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(core, &set);
+		::pthread_setaffinity_np(handler.getThreadHandle(), sizeof(set), &set);
+#else
+		// macOS only takes affinity hints
+		(void) handler;
+		(void) core;
+#endif
+	}
+
+	ShardedServer::ShardedServer(std::uint32_t shardCount, std::uint32_t readBufferSize, std::uint32_t writeBufferSize, std::uint32_t maxReadPackets, std::uint32_t maxWritePackets, std::uint32_t sendCount, HandleCallback handleCallback, void* userData, std::uint32_t batchSize, std::uint32_t maxDatagramSize, std::uint32_t inboxSize)
+	    : m_ShardCount(shardCount ? shardCount : std::max(std::thread::hardware_concurrency(), 1U)),
+	      m_Shards(new Shard[m_ShardCount]),
+	      m_PeerCount((maxReadPackets + maxWritePackets) * 2U),
+	      m_InboxSize(inboxSize),
+	      m_HandleCallback(handleCallback),
+	      m_UserData(userData)
+	{
+		for (std::uint32_t i { 0 }; i < m_ShardCount; ++i)
+		{
+			Shard& shard { m_Shards[i] };
+			shard.m_Server   = this;
+			shard.m_Index    = i;
+			shard.m_Handler  = new PacketHandler(readBufferSize, writeBufferSize, maxReadPackets, maxWritePackets, sendCount, &HandlePacket, &shard, batchSize, maxDatagramSize);
+			shard.m_Peers[0] = new PeerIndex(m_PeerCount);
+			shard.m_Peers[1] = new PeerIndex(m_PeerCount);
+		}
+	}
+
+	ShardedServer::~ShardedServer()
+	{
+		stop();
+		if (m_Shards)
+		{
+			for (std::uint32_t i { 0 }; i < m_ShardCount; ++i)
+			{
+				Shard& shard { m_Shards[i] };
+				delete shard.m_Handler;
+				delete shard.m_Peers[0];
+				delete shard.m_Peers[1];
+			}
+			delete[] m_Shards;
+		}
+		m_Shards     = nullptr;
+		m_ShardCount = 0U;
+	}
+
+	bool ShardedServer::start(Networking::Endpoint endpoint, bool pinThreads)
+	{
+		if (m_Running.load())
+			return false;
+
+		for (std::uint32_t i { 0 }; i < m_ShardCount; ++i)
+		{
+			Shard&              shard { m_Shards[i] };
+			Networking::Socket& socket { shard.m_Handler->getSocket() };
+			socket.setNonBlocking();
+			socket.setReusePort(m_ShardCount > 1U);
+			if (!socket.bind(endpoint))
+			{
+				for (std::uint32_t j { 0 }; j <= i; ++j)
+					m_Shards[j].m_Handler->getSocket().close();
+				return false;
+			}
+		}
+
+		for (std::uint32_t i { 0 }; i < m_ShardCount; ++i)
+		{
+			PacketHandler& handler { *m_Shards[i].m_Handler };
+			if (!handler.startThread(0U, m_InboxSize))
+			{
+				for (std::uint32_t j { 0 }; j < m_ShardCount; ++j)
+				{
+					m_Shards[j].m_Handler->stopThread();
+					m_Shards[j].m_Handler->getSocket().close();
+				}
+				return false;
+			}
+			if (pinThreads)
+				PinThread(handler, i);
+		}
+		m_Running.store(true);
+		return true;
+	}
+
+	void ShardedServer::stop()
+	{
+		if (!m_Running.exchange(false))
+			return;
+
+		for (std::uint32_t i { 0 }; i < m_ShardCount; ++i)
+		{
+			Shard&                      shard { m_Shards[i] };
+			std::lock_guard<std::mutex> lock { shard.m_SendMutex };
+			shard.m_Handler->stopThread();
+			shard.m_Handler->getSocket().close();
+		}
+	}
+
+	bool ShardedServer::post(Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery, std::uint16_t channel)
+	{
+		std::uint32_t shard { findShard(endpoint) };
+		return shard != ~0U && post(shard, endpoint, data, size, delivery, channel);
+	}
+
+	bool ShardedServer::post(std::uint32_t shard, Networking::Endpoint endpoint, const void* data, std::uint32_t size, EDelivery delivery, std::uint16_t channel)
+	{
+		if (shard >= m_ShardCount || channel >= s_MaxChannels)
+			return false;
+
+		// The shard's own thread queues directly
+		PacketHandler& handler { *m_Shards[shard].m_Handler };
+		if (handler.isNetworkThread())
+			return handler.sendPacket(endpoint, data, size, delivery, channel);
+
+		std::lock_guard<std::mutex> lock { m_Shards[shard].m_SendMutex };
+		return handler.isThreaded() && handler.sendPacket(endpoint, data, size, delivery, channel);
+	}
+
+	std::uint32_t ShardedServer::findShard(Networking::Endpoint endpoint) const
+	{
+		for (std::uint32_t i { 0 }; i < m_ShardCount; ++i)
+		{
+			// Announces the reader before the copy is read, retrying if it stopped being published meanwhile
+			Shard&        shard { m_Shards[i] };
+			std::uint32_t published { shard.m_PublishedPeers.load() };
+			shard.m_PeerReaders[published].fetch_add(1U);
+			while (shard.m_PublishedPeers.load() != published)
+			{
+				shard.m_PeerReaders[published].fetch_sub(1U);
+				published = shard.m_PublishedPeers.load();
+				shard.m_PeerReaders[published].fetch_add(1U);
+			}
+			bool found { shard.m_Peers[published]->contains(endpoint) };
+			shard.m_PeerReaders[published].fetch_sub(1U, std::memory_order_release);
+			if (found)
+				return i;
+		}
+		return ~0U;
+	}
+
+	void ShardedServer::HandlePacket(PacketHandler* handler, Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
+	{
+		Shard&         shard { *static_cast<Shard*>(handler->getUserData()) };
+		ShardedServer* server { shard.m_Server };
+		server->recordPeer(shard, endpoint);
+		if (server->m_HandleCallback)
+			server->m_HandleCallback(server, shard.m_Index, endpoint, packet, size);
+	}
+
+	void ShardedServer::recordPeer(Shard& shard, Networking::Endpoint endpoint)
+	{
+		// The shard's own thread is the only writer, so it reads without announcing itself
+		if (shard.m_Peers[shard.m_PublishedPeers.load(std::memory_order_relaxed)]->contains(endpoint))
+			return;
+
+		// Updates the idle copy and publishes it, then does the same for the other one
+		for (std::uint32_t pass { 0 }; pass < 2U; ++pass)
+		{
+			std::uint32_t idle { 1U - shard.m_PublishedPeers.load(std::memory_order_relaxed) };
+			while (shard.m_PeerReaders[idle].load(std::memory_order_acquire))
+				std::this_thread::yield();
+			insertPeer(shard, *shard.m_Peers[idle], endpoint);
+			shard.m_PublishedPeers.store(idle);
+		}
+	}
+
+	void ShardedServer::insertPeer(Shard& shard, PeerIndex& peers, Networking::Endpoint endpoint)
+	{
+		// Rebuilt from the handler's current peers once full, which include the endpoint and fill at most half
+		if (peers.size() < m_PeerCount && peers.insert(endpoint, shard.m_Index))
+			return;
+
+		const PeerInfo* infos { shard.m_Handler->getPeerInfos() };
+		peers.clear();
+		for (std::uint32_t i { 0 }; i < shard.m_Handler->getMaxPeers(); ++i)
+		{
+			if (infos[i].m_LastSeen.time_since_epoch().count())
+				peers.insert(infos[i].m_Endpoint, shard.m_Index);
+		}
+	}
+} // namespace ReliableUDP
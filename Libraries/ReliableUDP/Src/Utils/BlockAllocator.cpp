@@ -0,0 +1,170 @@
+#include "ReliableUDP/Utils/BlockAllocator.h"
+
+#include <bit>
+
+namespace ReliableUDP::Utils
+{
+	static std::uint32_t AlignUp(std::uint32_t value, std::uint32_t alignment)
+	{
+		return (value + alignment - 1U) & ~(alignment - 1U);
+	}
+
+	static std::uint32_t SizeClass(std::uint32_t size)
+	{
+		return static_cast<std::uint32_t>(std::bit_width(size)) - 1U;
+	}
+
+	BlockAllocator::BlockAllocator(std::uint8_t* memory, std::uint32_t size)
+	    : m_Memory(memory), m_Size(size & ~(s_Alignment - 1U)), m_Used(0U), m_ClassMask(0U)
+	{
+		for (std::uint32_t i = 0; i < s_Classes; ++i)
+			m_FreeLists[i] = s_Invalid;
+
+		if (m_Size < s_MinBlock)
+		{
+			m_Size = 0U;
+			return;
+		}
+
+		BlockHeader* block = header(0U);
+		block->m_Size      = m_Size | 1U;
+		block->m_PrevSize  = 0U;
+		link(0U, m_Size);
+	}
+
+	std::uint32_t BlockAllocator::allocate(std::uint32_t size)
+	{
+		if (size > m_Size)
+			return s_Invalid;
+
+		std::uint32_t total = AlignUp(size + s_HeaderSize, s_Alignment);
+		if (total < s_MinBlock)
+			total = s_MinBlock;
+		if (total > m_Size - m_Used)
+			return s_Invalid;
+
+		// Any block of a larger class fits
+		std::uint32_t sizeClass = SizeClass(total);
+		std::uint32_t larger    = sizeClass + 1U < s_Classes ? m_ClassMask & (~0U << (sizeClass + 1U)) : 0U;
+		std::uint32_t block     = s_Invalid;
+		if (larger)
+		{
+			block = m_FreeLists[std::countr_zero(larger)];
+		}
+		else
+		{
+			for (std::uint32_t next = m_FreeLists[sizeClass]; next != s_Invalid; next = links(next)->m_Next)
+			{
+				if ((header(next)->m_Size & ~1U) >= total)
+				{
+					block = next;
+					break;
+				}
+			}
+		}
+		if (block == s_Invalid)
+			return s_Invalid;
+
+		std::uint32_t blockSize = header(block)->m_Size & ~1U;
+		unlink(block, blockSize);
+		if (blockSize - total >= s_MinBlock)
+		{
+			std::uint32_t rest     = block + total;
+			std::uint32_t restSize = blockSize - total;
+			BlockHeader*  restInfo = header(rest);
+			restInfo->m_Size       = restSize | 1U;
+			restInfo->m_PrevSize   = total;
+			if (rest + restSize < m_Size)
+				header(rest + restSize)->m_PrevSize = restSize;
+			link(rest, restSize);
+			blockSize = total;
+		}
+
+		header(block)->m_Size = blockSize;
+		m_Used += blockSize;
+		return block + s_HeaderSize;
+	}
+
+	void BlockAllocator::free(std::uint32_t offset)
+	{
+		if (offset == s_Invalid || offset < s_HeaderSize || offset > m_Size)
+			return;
+
+		std::uint32_t block = offset - s_HeaderSize;
+		BlockHeader*  info  = header(block);
+		if (info->m_Size & 1U)
+			return;
+
+		std::uint32_t size = info->m_Size;
+		m_Used -= size;
+
+		if (block + size < m_Size)
+		{
+			BlockHeader* next = header(block + size);
+			if (next->m_Size & 1U)
+			{
+				std::uint32_t nextSize = next->m_Size & ~1U;
+				unlink(block + size, nextSize);
+				size += nextSize;
+			}
+		}
+		if (block)
+		{
+			std::uint32_t prev = block - info->m_PrevSize;
+			if (header(prev)->m_Size & 1U)
+			{
+				std::uint32_t prevSize = header(prev)->m_Size & ~1U;
+				unlink(prev, prevSize);
+				block = prev;
+				size += prevSize;
+			}
+		}
+
+		header(block)->m_Size = size | 1U;
+		if (block + size < m_Size)
+			header(block + size)->m_PrevSize = size;
+		link(block, size);
+	}
+
+	std::uint32_t BlockAllocator::largestAllocation() const
+	{
+		if (!m_ClassMask)
+			return 0U;
+
+		std::uint32_t largest = 0U;
+		for (std::uint32_t next = m_FreeLists[SizeClass(m_ClassMask)]; next != s_Invalid; next = links(next)->m_Next)
+		{
+			std::uint32_t size = header(next)->m_Size & ~1U;
+			if (size > largest)
+				largest = size;
+		}
+		return largest - s_HeaderSize;
+	}
+
+	void BlockAllocator::link(std::uint32_t block, std::uint32_t size)
+	{
+		std::uint32_t sizeClass = SizeClass(size);
+		std::uint32_t head      = m_FreeLists[sizeClass];
+		FreeLinks*    entry     = links(block);
+		entry->m_Next           = head;
+		entry->m_Prev           = s_Invalid;
+		if (head != s_Invalid)
+			links(head)->m_Prev = block;
+		m_FreeLists[sizeClass] = block;
+		m_ClassMask |= 1U << sizeClass;
+	}
+
+	void BlockAllocator::unlink(std::uint32_t block, std::uint32_t size)
+	{
+		std::uint32_t sizeClass = SizeClass(size);
+		FreeLinks*    entry     = links(block);
+		if (entry->m_Prev != s_Invalid)
+			links(entry->m_Prev)->m_Next = entry->m_Next;
+		else
+			m_FreeLists[sizeClass] = entry->m_Next;
+		if (entry->m_Next != s_Invalid)
+			links(entry->m_Next)->m_Prev = entry->m_Prev;
+		if (m_FreeLists[sizeClass] == s_Invalid)
+			m_ClassMask &= ~(1U << sizeClass);
+	}
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,20 @@
+#include "ReliableUDP/Utils/Clock.h"
+
+namespace ReliableUDP::Utils
+{
+	static thread_local Clock::Source t_Source { nullptr };
+	static thread_local void*         t_UserData { nullptr };
+
+	Clock::time_point Clock::now()
+	{
+		if (t_Source)
+			return t_Source(t_UserData);
+		return time_point { std::chrono::steady_clock::now().time_since_epoch() };
+	}
+
+	void Clock::SetSource(Source source, void* userData)
+	{
+		t_Source   = source;
+		t_UserData = userData;
+	}
+} // namespace ReliableUDP::Utils
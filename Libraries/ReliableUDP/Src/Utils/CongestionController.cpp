@@ -0,0 +1,109 @@
+#include "ReliableUDP/Utils/CongestionController.h"
+
+#include <algorithm>
+
+namespace ReliableUDP::Utils
+{
+	void CongestionController::reset(ECongestionControl control, std::uint32_t fixedCount, float fixedInterval)
+	{
+		m_Control            = control;
+		m_SlowStartThreshold = s_MaxWindow;
+		m_MinRTT             = 0.0f;
+		m_InFlight           = 0U;
+		m_FixedCount         = std::max<std::uint32_t>(fixedCount, 1U);
+		m_FixedInterval      = fixedInterval;
+		if (m_Control == ECongestionControl::Fixed)
+		{
+			m_Window = s_MaxWindow;
+			m_Tokens = static_cast<float>(m_FixedCount);
+		}
+		else
+		{
+			m_Window = s_InitialWindow;
+			m_Tokens = s_InitialWindow;
+		}
+	}
+
+	void CongestionController::acknowledged(std::uint32_t sections, float rtt, const RoundTripEstimator& roundTrip)
+	{
+		if (rtt > 0.0f && (m_MinRTT == 0.0f || rtt < m_MinRTT))
+			m_MinRTT = rtt;
+
+		switch (m_Control)
+		{
+		case ECongestionControl::Fixed:
+			break;
+		case ECongestionControl::AIMD:
+		{
+			if (m_Window < m_SlowStartThreshold)
+				m_Window += static_cast<float>(sections);
+			else
+				m_Window += static_cast<float>(sections) / m_Window;
+			break;
+		}
+		case ECongestionControl::Delay:
+		{
+			// Vegas, estimates how many sections are queued
+			float queued { 0.0f };
+			if (m_MinRTT > 0.0f && roundTrip.getSmoothedRTT() > 0.0f)
+				queued = m_Window * (1.0f - m_MinRTT / roundTrip.getSmoothedRTT());
+
+			if (m_Window < m_SlowStartThreshold)
+			{
+				if (queued > s_DelayBeta)
+					m_SlowStartThreshold = m_Window;
+				else
+					m_Window += static_cast<float>(sections);
+			}
+			else if (queued < s_DelayAlpha)
+			{
+				m_Window += static_cast<float>(sections) / m_Window;
+			}
+			else if (queued > s_DelayBeta)
+			{
+				m_Window -= static_cast<float>(sections) / m_Window;
+			}
+			break;
+		}
+		}
+
+		m_Window = std::clamp(m_Window, s_MinWindow, s_MaxWindow);
+	}
+
+	void CongestionController::lost()
+	{
+		if (m_Control == ECongestionControl::Fixed)
+			return;
+
+		m_SlowStartThreshold = std::max(m_Window * 0.5f, s_MinWindow);
+		m_Window             = m_SlowStartThreshold;
+	}
+
+	void CongestionController::refill(float elapsed, const RoundTripEstimator& roundTrip)
+	{
+		if (elapsed <= 0.0f)
+			return;
+
+		// A quarter window burst, so pacing does not starve between updates
+		float burst { m_Control == ECongestionControl::Fixed ? static_cast<float>(m_FixedCount) : std::max(s_MinWindow, m_Window * 0.25f) };
+		m_Tokens = std::min(m_Tokens + getPacingRate(roundTrip) * elapsed, burst);
+	}
+
+	void CongestionController::sent()
+	{
+		m_Tokens -= 1.0f;
+		++m_InFlight;
+	}
+
+	float CongestionController::getPacingRate(const RoundTripEstimator& roundTrip) const
+	{
+		if (m_Control == ECongestionControl::Fixed)
+			return m_FixedInterval > 0.0f ? static_cast<float>(m_FixedCount) / m_FixedInterval : s_MaxWindow;
+
+		float rtt { roundTrip.getSampleCount() ? roundTrip.getSmoothedRTT() : roundTrip.getRetransmitTimeout() };
+		rtt = std::max(rtt, RoundTripEstimator::s_Granularity);
+		// Slow start paces faster to fill the window within one RTT
+		float gain { m_Window < m_SlowStartThreshold ? 2.0f : s_PacingGain };
+		return gain * m_Window / rtt;
+	}
+} // namespace ReliableUDP::Utils
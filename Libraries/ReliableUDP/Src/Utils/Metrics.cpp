@@ -0,0 +1,53 @@
+#include "ReliableUDP/Utils/Metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace ReliableUDP::Utils
+{
+	float Histogram::BucketLimit(std::uint32_t bucket)
+	{
+		return std::ldexp(1e-6f, static_cast<int>(bucket));
+	}
+
+	void Histogram::add(float seconds)
+	{
+		std::uint64_t microseconds { seconds > 0.0f ? static_cast<std::uint64_t>(seconds * 1e6f) : 0U };
+		m_Buckets[std::min<std::uint32_t>(static_cast<std::uint32_t>(std::bit_width(microseconds)), s_Buckets - 1U)].add();
+	}
+
+	void Histogram::reset()
+	{
+		for (Counter& bucket : m_Buckets)
+			bucket.set(0U);
+	}
+
+	std::uint64_t Histogram::getCount() const
+	{
+		std::uint64_t count { 0U };
+		for (const Counter& bucket : m_Buckets)
+			count += bucket.get();
+		return count;
+	}
+
+	float Histogram::getPercentile(float fraction) const
+	{
+		std::uint64_t buckets[s_Buckets];
+		std::uint64_t count { 0U };
+		for (std::uint32_t i { 0 }; i < s_Buckets; ++i)
+			count += buckets[i] = m_Buckets[i].get();
+		if (!count)
+			return 0.0f;
+
+		std::uint64_t target { static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0f, 1.0f) * static_cast<float>(count))) };
+		std::uint64_t seen { 0U };
+		for (std::uint32_t i { 0 }; i < s_Buckets; ++i)
+		{
+			seen += buckets[i];
+			if (seen >= std::max<std::uint64_t>(target, 1U))
+				return BucketLimit(i);
+		}
+		return BucketLimit(s_Buckets - 1U);
+	}
+} // namespace ReliableUDP::Utils
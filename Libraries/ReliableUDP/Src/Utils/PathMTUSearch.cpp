@@ -0,0 +1,47 @@
+#include "ReliableUDP/Utils/PathMTUSearch.h"
+
+#include <algorithm>
+
+namespace ReliableUDP::Utils
+{
+	void PathMTUSearch::reset(std::uint32_t maxSize)
+	{
+		m_Low        = std::min(s_BaseSize, maxSize);
+		m_High       = maxSize;
+		m_ProbeCount = 0U;
+		m_TriedMax   = false;
+	}
+
+	std::uint32_t PathMTUSearch::nextProbe() const
+	{
+		if (m_High <= m_Low || m_High - m_Low < s_MinStep)
+			return 0U;
+
+		// Try the top first
+		if (!m_TriedMax)
+			return m_High;
+		return (m_Low + m_High + 1U) / 2U;
+	}
+
+	void PathMTUSearch::probeAcknowledged(std::uint32_t size)
+	{
+		if (size <= m_Low)
+			return;
+
+		m_Low        = std::min(size, m_High);
+		m_ProbeCount = 0U;
+	}
+
+	void PathMTUSearch::probeLost(std::uint32_t size)
+	{
+		if (size <= m_Low || size > m_High)
+			return;
+
+		if (++m_ProbeCount < s_MaxProbes)
+			return;
+
+		m_High       = size - 1U;
+		m_ProbeCount = 0U;
+		m_TriedMax   = true;
+	}
+} // namespace ReliableUDP::Utils
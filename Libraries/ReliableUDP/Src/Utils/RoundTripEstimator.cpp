@@ -0,0 +1,43 @@
+#include "ReliableUDP/Utils/RoundTripEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ReliableUDP::Utils
+{
+	void RoundTripEstimator::addSample(float rtt)
+	{
+		if (rtt < 0.0f)
+			return;
+
+		if (!m_SampleCount)
+		{
+			m_SmoothedRTT = rtt;
+			m_RTTVariance = rtt * 0.5f;
+		}
+		else
+		{
+			m_RTTVariance = 0.75f * m_RTTVariance + 0.25f * std::abs(m_SmoothedRTT - rtt);
+			m_SmoothedRTT = 0.875f * m_SmoothedRTT + 0.125f * rtt;
+		}
+		++m_SampleCount;
+
+		m_RetransmitTimeout = std::clamp(m_SmoothedRTT + std::max(s_Granularity, 4.0f * m_RTTVariance), s_MinTimeout, s_MaxTimeout);
+	}
+
+	void RoundTripEstimator::reset()
+	{
+		m_SmoothedRTT       = 0.0f;
+		m_RTTVariance       = 0.0f;
+		m_RetransmitTimeout = s_InitialTimeout;
+		m_SampleCount       = 0U;
+	}
+
+	float RoundTripEstimator::getBackoffTimeout(std::uint32_t retransmissions) const
+	{
+		float timeout = m_RetransmitTimeout;
+		for (std::uint32_t i = 0; i < retransmissions && timeout < s_MaxTimeout; ++i)
+			timeout *= 2.0f;
+		return std::min(timeout, s_MaxTimeout);
+	}
+} // namespace ReliableUDP::Utils
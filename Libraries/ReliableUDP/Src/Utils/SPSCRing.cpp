@@ -0,0 +1,96 @@
+#include "ReliableUDP/Utils/SPSCRing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace ReliableUDP::Utils
+{
+	static constexpr std::uint32_t s_Padding = ~0U;
+
+	static std::uint32_t AlignUp(std::uint32_t value, std::uint32_t alignment)
+	{
+		return (value + alignment - 1U) & ~(alignment - 1U);
+	}
+
+	SPSCRing::SPSCRing(std::uint32_t size)
+	    : m_Memory(nullptr), m_Size(std::bit_ceil(std::max(size, 64U)))
+	{
+		m_Memory = new std::uint8_t[m_Size];
+	}
+
+	SPSCRing::~SPSCRing()
+	{
+		if (m_Memory)
+			delete[] m_Memory;
+		m_Memory = nullptr;
+		m_Size   = 0U;
+	}
+
+	bool SPSCRing::canReserve(std::uint32_t size) const
+	{
+		std::uint32_t head { m_Head.load(std::memory_order_relaxed) };
+		std::uint32_t tail { m_Tail.load(std::memory_order_acquire) };
+		std::uint32_t space { requiredSpace(head, size) };
+		return space <= m_Size && head - tail + space <= m_Size;
+	}
+
+	std::uint8_t* SPSCRing::reserve(std::uint32_t size)
+	{
+		if (!canReserve(size))
+			return nullptr;
+
+		std::uint32_t head { m_Head.load(std::memory_order_relaxed) };
+		std::uint32_t offset { head & (m_Size - 1U) };
+		std::uint32_t total { AlignUp(size + s_HeaderSize, s_Alignment) };
+		if (m_Size - offset < total)
+		{
+			std::memcpy(m_Memory + offset, &s_Padding, sizeof(s_Padding));
+			head += m_Size - offset;
+			offset = 0U;
+		}
+
+		std::memcpy(m_Memory + offset, &size, sizeof(size));
+		m_ReservedHead = head + total;
+		return m_Memory + offset + s_HeaderSize;
+	}
+
+	void SPSCRing::commit()
+	{
+		m_Head.store(m_ReservedHead, std::memory_order_release);
+	}
+
+	std::uint8_t* SPSCRing::front(std::uint32_t& size)
+	{
+		std::uint32_t tail { m_Tail.load(std::memory_order_relaxed) };
+		std::uint32_t head { m_Head.load(std::memory_order_acquire) };
+		if (tail == head)
+			return nullptr;
+
+		std::uint32_t offset { tail & (m_Size - 1U) };
+		std::memcpy(&size, m_Memory + offset, sizeof(size));
+		if (size == s_Padding)
+		{
+			tail += m_Size - offset;
+			m_Tail.store(tail, std::memory_order_release);
+			offset = 0U;
+			std::memcpy(&size, m_Memory, sizeof(size));
+		}
+
+		m_FrontSize = size;
+		return m_Memory + offset + s_HeaderSize;
+	}
+
+	void SPSCRing::pop()
+	{
+		std::uint32_t tail { m_Tail.load(std::memory_order_relaxed) };
+		m_Tail.store(tail + AlignUp(m_FrontSize + s_HeaderSize, s_Alignment), std::memory_order_release);
+	}
+
+	std::uint32_t SPSCRing::requiredSpace(std::uint32_t head, std::uint32_t size) const
+	{
+		std::uint32_t offset { head & (m_Size - 1U) };
+		std::uint32_t total { AlignUp(size + s_HeaderSize, s_Alignment) };
+		return m_Size - offset < total ? m_Size - offset + total : total;
+	}
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,61 @@
+#include "ReliableUDP/Utils/SequenceWindow.h"
+
+#include <cstring>
+
+namespace ReliableUDP::Utils
+{
+	void SequenceWindow::reset()
+	{
+		std::memset(m_Bits, 0, sizeof(m_Bits));
+		m_Newest = 0U;
+		m_Empty  = true;
+	}
+
+	ESequenceState SequenceWindow::getState(std::uint16_t sequence) const
+	{
+		if (m_Empty)
+			return ESequenceState::New;
+
+		std::uint16_t ahead { static_cast<std::uint16_t>(sequence - m_Newest) };
+		if (ahead && ahead < 0x8000U)
+			return ESequenceState::New;
+
+		std::uint16_t behind { static_cast<std::uint16_t>(m_Newest - sequence) };
+		if (behind >= s_Size)
+			return ESequenceState::Stale;
+
+		std::uint32_t bit { sequence % s_Size };
+		return (m_Bits[bit / 64U] >> (bit % 64U)) & 1U ? ESequenceState::Handled : ESequenceState::New;
+	}
+
+	bool SequenceWindow::mark(std::uint16_t sequence)
+	{
+		std::uint16_t ahead { static_cast<std::uint16_t>(sequence - m_Newest) };
+		bool          moved { m_Empty || (ahead && ahead < 0x8000U) };
+		if (moved)
+		{
+			if (m_Empty || ahead >= s_Size)
+			{
+				std::memset(m_Bits, 0, sizeof(m_Bits));
+			}
+			else
+			{
+				for (std::uint16_t i { 1U }; i <= ahead; ++i)
+				{
+					std::uint32_t bit { static_cast<std::uint16_t>(m_Newest + i) % s_Size };
+					m_Bits[bit / 64U] &= ~(1ULL << (bit % 64U));
+				}
+			}
+			m_Newest = sequence;
+			m_Empty  = false;
+		}
+		else if (static_cast<std::uint16_t>(m_Newest - sequence) >= s_Size)
+		{
+			return false;
+		}
+
+		std::uint32_t bit { sequence % s_Size };
+		m_Bits[bit / 64U] |= 1ULL << (bit % 64U);
+		return moved;
+	}
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,191 @@
+#include "ReliableUDP/Utils/TimerWheel.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace ReliableUDP::Utils
+{
+	// Bucket value of timers in the firing list
+	static constexpr std::uint32_t s_Firing = ~0U;
+
+	TimerWheel::TimerWheel(std::uint32_t maxTimers)
+	    : m_MaxTimers(maxTimers),
+	      m_Next(new std::uint32_t[maxTimers + s_Levels * s_Buckets + 1U]),
+	      m_Prev(new std::uint32_t[maxTimers + s_Levels * s_Buckets + 1U]),
+	      m_Ticks(new std::uint64_t[maxTimers]),
+	      m_Buckets(new std::uint32_t[maxTimers]),
+	      m_Scheduled(new bool[maxTimers])
+	{
+		for (std::uint32_t i { 0 }; i < maxTimers + s_Levels * s_Buckets + 1U; ++i)
+		{
+			m_Next[i] = i;
+			m_Prev[i] = i;
+		}
+		for (std::uint32_t i { 0 }; i < maxTimers; ++i)
+		{
+			m_Ticks[i]     = 0U;
+			m_Buckets[i]   = s_Firing;
+			m_Scheduled[i] = false;
+		}
+	}
+
+	TimerWheel::~TimerWheel()
+	{
+		delete[] m_Next;
+		delete[] m_Prev;
+		delete[] m_Ticks;
+		delete[] m_Buckets;
+		delete[] m_Scheduled;
+		m_Next      = nullptr;
+		m_Prev      = nullptr;
+		m_Ticks     = nullptr;
+		m_Buckets   = nullptr;
+		m_Scheduled = nullptr;
+		m_MaxTimers = 0U;
+	}
+
+	void TimerWheel::schedule(std::uint32_t timer, std::uint64_t tick)
+	{
+		if (timer >= m_MaxTimers)
+			return;
+
+		if (m_Scheduled[timer])
+			unlink(timer);
+		else
+			++m_Count;
+		m_Scheduled[timer] = true;
+		m_Ticks[timer]     = std::clamp<std::uint64_t>(tick, m_Current + 1U, m_Current + (1ULL << (s_Levels * s_Bits)) - 1U);
+		insert(timer);
+	}
+
+	void TimerWheel::cancel(std::uint32_t timer)
+	{
+		if (timer >= m_MaxTimers || !m_Scheduled[timer])
+			return;
+
+		unlink(timer);
+		m_Scheduled[timer] = false;
+		--m_Count;
+	}
+
+	std::uint32_t TimerWheel::popExpired(std::uint64_t tick)
+	{
+		while (true)
+		{
+			std::uint32_t head { firingHead() };
+			if (m_Next[head] != head)
+			{
+				std::uint32_t timer { m_Next[head] };
+				unlink(timer);
+				m_Scheduled[timer] = false;
+				--m_Count;
+				return timer;
+			}
+			if (m_Current >= tick)
+				return s_Invalid;
+
+			std::uint64_t next { nextTick() };
+			if (next > tick)
+			{
+				m_Current = tick;
+				return s_Invalid;
+			}
+			m_Current = next - 1U;
+			step();
+		}
+	}
+
+	std::uint64_t TimerWheel::nextTick() const
+	{
+		if (!m_Count)
+			return ~0ULL;
+		if (m_Next[firingHead()] != firingHead())
+			return m_Current;
+
+		std::uint64_t next { ~0ULL };
+		for (std::uint32_t level { 0 }; level < s_Levels; ++level)
+		{
+			if (!m_Occupied[level])
+				continue;
+
+			// The current bucket is a full turn ahead
+			std::uint32_t shift { level * s_Bits };
+			std::uint64_t base { (m_Current >> shift) << shift };
+			std::uint32_t current { static_cast<std::uint32_t>(m_Current >> shift) & (s_Buckets - 1U) };
+			std::uint32_t offset { static_cast<std::uint32_t>(std::countr_zero(std::rotr(m_Occupied[level], static_cast<int>((current + 1U) & (s_Buckets - 1U))))) };
+			next = std::min(next, base + ((static_cast<std::uint64_t>(offset) + 1U) << shift));
+		}
+		return next;
+	}
+
+	void TimerWheel::insert(std::uint32_t timer)
+	{
+		std::uint64_t tick { m_Ticks[timer] };
+		std::uint64_t delta { tick > m_Current ? tick - m_Current : 0U };
+
+		std::uint32_t level { 0 };
+		while (level + 1U < s_Levels && delta >= (1ULL << ((level + 1U) * s_Bits)))
+			++level;
+
+		std::uint32_t bucket { static_cast<std::uint32_t>(std::max(tick, m_Current) >> (level * s_Bits)) & (s_Buckets - 1U) };
+		m_Buckets[timer] = level * s_Buckets + bucket;
+		m_Occupied[level] |= 1ULL << bucket;
+		link(bucketHead(level, bucket), timer);
+	}
+
+	void TimerWheel::unlink(std::uint32_t timer)
+	{
+		m_Next[m_Prev[timer]] = m_Next[timer];
+		m_Prev[m_Next[timer]] = m_Prev[timer];
+		m_Next[timer]         = timer;
+		m_Prev[timer]         = timer;
+
+		std::uint32_t bucket { m_Buckets[timer] };
+		m_Buckets[timer] = s_Firing;
+		if (bucket == s_Firing)
+			return;
+
+		std::uint32_t head { m_MaxTimers + bucket };
+		if (m_Next[head] == head)
+			m_Occupied[bucket / s_Buckets] &= ~(1ULL << (bucket % s_Buckets));
+	}
+
+	void TimerWheel::link(std::uint32_t head, std::uint32_t timer)
+	{
+		m_Prev[timer]        = m_Prev[head];
+		m_Next[timer]        = head;
+		m_Next[m_Prev[head]] = timer;
+		m_Prev[head]         = timer;
+	}
+
+	void TimerWheel::step()
+	{
+		++m_Current;
+
+		// Higher levels first, so timers cascade down several levels at once
+		for (std::uint32_t level { s_Levels - 1U }; level > 0U; --level)
+		{
+			std::uint32_t shift { level * s_Bits };
+			if (m_Current & ((1ULL << shift) - 1U))
+				continue;
+
+			std::uint32_t bucket { static_cast<std::uint32_t>(m_Current >> shift) & (s_Buckets - 1U) };
+			std::uint32_t head { bucketHead(level, bucket) };
+			while (m_Next[head] != head)
+			{
+				std::uint32_t timer { m_Next[head] };
+				unlink(timer);
+				insert(timer);
+			}
+		}
+
+		std::uint32_t bucket { static_cast<std::uint32_t>(m_Current) & (s_Buckets - 1U) };
+		std::uint32_t head { bucketHead(0U, bucket) };
+		while (m_Next[head] != head)
+		{
+			std::uint32_t timer { m_Next[head] };
+			unlink(timer);
+			link(firingHead(), timer);
+		}
+	}
+} // namespace ReliableUDP::Utils
@@ -0,0 +1,94 @@
+#include "Tests.h"
+
+#include <ReliableUDP/Utils/BlockAllocator.h>
+
+#include <cstring>
+#include <random>
+
+namespace Tests
+{
+	using ReliableUDP::Utils::BlockAllocator;
+
+	struct Allocation
+	{
+	public:
+		std::uint32_t m_Offset { BlockAllocator::s_Invalid };
+		std::uint32_t m_Size { 0U };
+		std::uint8_t  m_Fill { 0U };
+	};
+
+	static bool IsFilled(const BlockAllocator& allocator, const Allocation& allocation)
+	{
+		for (std::uint32_t i { 0 }; i < allocation.m_Size; ++i)
+		{
+			if (allocator.getMemory()[allocation.m_Offset + i] != allocation.m_Fill)
+				return false;
+		}
+		return true;
+	}
+
+	bool TestBlockAllocator()
+	{
+		static std::uint8_t s_Memory[1U << 16];
+		BlockAllocator      allocator { s_Memory, sizeof(s_Memory) };
+		std::uint32_t       largest { allocator.largestAllocation() };
+		TEST_EXPECT(largest == sizeof(s_Memory) - BlockAllocator::s_HeaderSize);
+		TEST_EXPECT(allocator.allocate(largest + 1U) == BlockAllocator::s_Invalid);
+
+		// Freed neighbours merge back into one range
+		std::uint32_t first { allocator.allocate(100U) };
+		std::uint32_t second { allocator.allocate(200U) };
+		std::uint32_t third { allocator.allocate(300U) };
+		TEST_EXPECT(first != BlockAllocator::s_Invalid && second != BlockAllocator::s_Invalid && third != BlockAllocator::s_Invalid);
+		TEST_EXPECT(first % BlockAllocator::s_Alignment == 0U && second % BlockAllocator::s_Alignment == 0U);
+		allocator.free(second);
+		allocator.free(first);
+		allocator.free(third);
+		TEST_EXPECT(allocator.getUsed() == 0U && allocator.largestAllocation() == largest);
+
+		// One long lived block must not keep the rest of the buffer from being reused
+		std::uint32_t pinned { allocator.allocate(64U) };
+		TEST_EXPECT(pinned != BlockAllocator::s_Invalid);
+		for (std::uint32_t i { 0 }; i < 1000U; ++i)
+		{
+			std::uint32_t offset { allocator.allocate(20000U) };
+			TEST_EXPECT(offset != BlockAllocator::s_Invalid);
+			allocator.free(offset);
+		}
+		allocator.free(pinned);
+
+		constexpr std::uint32_t s_Count { 64U };
+		Allocation              allocations[s_Count];
+		std::mt19937            random { 2U };
+		for (std::uint32_t i { 0 }; i < 20000U; ++i)
+		{
+			Allocation& allocation { allocations[random() % s_Count] };
+			if (allocation.m_Offset != BlockAllocator::s_Invalid)
+			{
+				TEST_EXPECT(IsFilled(allocator, allocation));
+				allocator.free(allocation.m_Offset);
+				allocation = {};
+				continue;
+			}
+
+			std::uint32_t size { 1U + static_cast<std::uint32_t>(random() % 4000U) };
+			std::uint32_t offset { allocator.allocate(size) };
+			if (offset == BlockAllocator::s_Invalid)
+				continue;
+			TEST_EXPECT(offset % BlockAllocator::s_Alignment == 0U && offset + size <= allocator.getSize());
+			allocation = { offset, size, static_cast<std::uint8_t>(i) };
+			std::memset(s_Memory + offset, allocation.m_Fill, size);
+		}
+
+		// Overlapping blocks would have overwritten each other's fill
+		for (Allocation& allocation : allocations)
+		{
+			if (allocation.m_Offset == BlockAllocator::s_Invalid)
+				continue;
+			TEST_EXPECT(IsFilled(allocator, allocation));
+			allocator.free(allocation.m_Offset);
+		}
+		TEST_EXPECT(allocator.getUsed() == 0U && allocator.largestAllocation() == largest);
+		return true;
+	}
+} // namespace Tests
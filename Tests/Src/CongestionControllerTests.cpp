@@ -0,0 +1,78 @@
+#include "Tests.h"
+
+#include <ReliableUDP/Utils/CongestionController.h>
+
+#include <cmath>
+
+namespace Tests
+{
+	using ReliableUDP::Utils::CongestionController;
+	using ReliableUDP::Utils::ECongestionControl;
+	using ReliableUDP::Utils::RoundTripEstimator;
+
+	static bool IsNear(float value, float expected)
+	{
+		return std::fabs(value - expected) < 0.001f;
+	}
+
+	bool TestCongestionController()
+	{
+		RoundTripEstimator roundTrip;
+		roundTrip.addSample(0.01f);
+
+		// The initial window is sent at once, then the window blocks
+		CongestionController controller;
+		controller.reset(ECongestionControl::AIMD, 0U, 0.0f);
+		TEST_EXPECT(IsNear(controller.getWindow(), CongestionController::s_InitialWindow));
+		for (std::uint32_t i { 0 }; i < 10U; ++i)
+		{
+			TEST_EXPECT(controller.canSend());
+			controller.sent();
+		}
+		TEST_EXPECT(!controller.canSend() && controller.getInFlight() == 10U);
+
+		// Slow start grows by one section per acknowledged section
+		controller.acknowledged(10U, 0.01f, roundTrip);
+		controller.removeInFlight(10U);
+		TEST_EXPECT(IsNear(controller.getWindow(), 20.0f) && controller.getInFlight() == 0U);
+
+		// Tokens refill at twice the window per RTT in slow start, up to a quarter window
+		controller.refill(0.001f, roundTrip);
+		TEST_EXPECT(IsNear(controller.getTokens(), 4.0f));
+		controller.refill(1.0f, roundTrip);
+		TEST_EXPECT(IsNear(controller.getTokens(), 5.0f) && controller.canSend());
+
+		// Loss halves the window, then it grows by one section per window
+		controller.lost();
+		TEST_EXPECT(IsNear(controller.getWindow(), 10.0f) && IsNear(controller.getSlowStartThreshold(), 10.0f));
+		controller.acknowledged(10U, 0.01f, roundTrip);
+		TEST_EXPECT(IsNear(controller.getWindow(), 11.0f));
+
+		for (std::uint32_t i { 0 }; i < 10U; ++i)
+			controller.lost();
+		TEST_EXPECT(IsNear(controller.getWindow(), CongestionController::s_MinWindow));
+		controller.removeInFlight(100U);
+		TEST_EXPECT(controller.getInFlight() == 0U);
+
+		// Delay leaves slow start once the RTT grew past the lowest seen
+		RoundTripEstimator queued;
+		queued.addSample(0.02f);
+		controller.reset(ECongestionControl::Delay, 0U, 0.0f);
+		controller.acknowledged(1U, 0.01f, queued);
+		TEST_EXPECT(IsNear(controller.getWindow(), 10.0f) && IsNear(controller.getSlowStartThreshold(), 10.0f));
+		controller.acknowledged(1U, 0.01f, queued);
+		TEST_EXPECT(IsNear(controller.getWindow(), 9.9f) && IsNear(controller.getMinRTT(), 0.01f));
+
+		// Fixed sends fixedCount sections per interval and ignores loss
+		controller.reset(ECongestionControl::Fixed, 4U, 0.01f);
+		for (std::uint32_t i { 0 }; i < 4U; ++i)
+			controller.sent();
+		TEST_EXPECT(!controller.canSend());
+		controller.lost();
+		controller.refill(0.005f, roundTrip);
+		TEST_EXPECT(IsNear(controller.getTokens(), 2.0f) && IsNear(controller.getWindow(), CongestionController::s_MaxWindow));
+		controller.refill(1.0f, roundTrip);
+		TEST_EXPECT(IsNear(controller.getTokens(), 4.0f));
+		return true;
+	}
+} // namespace Tests
@@ -1,3 +1,5 @@
+#include "Tests.h"
+
 #include <ReliableUDP/PacketHandler.h>
 #include <ReliableUDP/Utils/Core.h>
 
@@ -14,13 +16,7 @@
 
 void serverPacketHandler(ReliableUDP::PacketHandler* handler, ReliableUDP::Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
 {
-	std::uint16_t id       = 0U;
-	std::uint8_t* response = handler->allocateWritePacket(size, id);
-	if (!response)
-		return;
-	std::memcpy(response, packet, size);
-	handler->setPacketEndpoint(id, endpoint);
-	handler->markWritePacketReady(id);
+	handler->sendPacket(endpoint, packet, size);
 }
 
 void clientPacketHandler([[maybe_unused]] ReliableUDP::PacketHandler* handler, [[maybe_unused]] ReliableUDP::Networking::Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
@@ -62,7 +58,7 @@ void serverFunc()
 	serverUp = true;
 	while (socket.isBound() && running)
 	{
-		server.updatePackets();
+		server.waitAndUpdate(0.1f);
 	}
 }
 
@@ -82,8 +78,11 @@ static bool IsCINReady()
 #endif
 }
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
+int main(int argc, char** argv)
 {
+	if (argc > 1 && std::string_view { argv[1] } == "--test")
+		return Tests::RunTests() ? 0 : 1;
+
 	std::signal(SIGINT, &signalHandler);
 
 	std::thread serverThread { &serverFunc };
@@ -122,7 +121,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 			client.markWritePacketReady(id);
 		}
 
-		client.updatePackets();
+		client.waitAndUpdate(0.01f);
 	}
 
 	serverThread.join();
@@ -0,0 +1,98 @@
+#include "SimulatedLink.h"
+#include "Tests.h"
+
+#include <cstring>
+
+namespace Tests
+{
+	using ReliableUDP::LinkConditions;
+	using ReliableUDP::PacketHandler;
+	using ReliableUDP::SimulatorStats;
+	using namespace ReliableUDP::Networking;
+
+	struct Delivered
+	{
+	public:
+		bool          m_Packets[1000] {};
+		std::uint32_t m_Count { 0U };
+		bool          m_Corrupt { false };
+	};
+
+	static void DeliverPacket(PacketHandler* handler, [[maybe_unused]] Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
+	{
+		Delivered&    delivered { *static_cast<Delivered*>(handler->getUserData()) };
+		std::uint32_t index { 0U };
+		std::memcpy(&index, packet, sizeof(index));
+		for (std::uint32_t i { sizeof(index) }; i < size; ++i)
+		{
+			if (packet[i] != static_cast<std::uint8_t>(i * 7U + size))
+				delivered.m_Corrupt = true;
+		}
+		if (index >= sizeof(delivered.m_Packets) || delivered.m_Packets[index])
+		{
+			delivered.m_Corrupt = true;
+			return;
+		}
+		delivered.m_Packets[index] = true;
+		++delivered.m_Count;
+	}
+
+	// Sends packets over a lossy, reordering link and returns the simulated seconds it took
+	static bool Transfer(std::uint32_t packets, SimulatorStats& stats, double& seconds)
+	{
+		LinkConditions conditions;
+		conditions.m_Loss         = 0.05f;
+		conditions.m_Delay        = 0.01f;
+		conditions.m_Jitter       = 0.002f;
+		conditions.m_Reorder      = 0.05f;
+		conditions.m_ReorderDelay = 0.01f;
+		conditions.m_Duplicate    = 0.01f;
+
+		Delivered     delivered;
+		SimulatedLink link { &DeliverPacket, &delivered, conditions };
+		TEST_EXPECT(link.m_Attached);
+
+		std::uint8_t                   packet[3000];
+		std::uint32_t                  sent { 0U };
+		ReliableUDP::Clock::time_point start { link.m_Simulator->now() };
+		while (delivered.m_Count < packets && link.m_Simulator->now() - start < std::chrono::seconds(60))
+		{
+			// Small packets and a few that need splitting
+			for (; sent < packets; ++sent)
+			{
+				std::uint32_t size { sent % 37U == 5U ? 3000U : 10U + (sent * 13U) % 300U };
+				std::memcpy(packet, &sent, sizeof(sent));
+				for (std::uint32_t i { sizeof(sent) }; i < size; ++i)
+					packet[i] = static_cast<std::uint8_t>(i * 7U + size);
+				if (!link.m_Client->sendPacket(link.m_ServerEndpoint, packet, size))
+					break;
+			}
+			link.run(0.05f);
+		}
+		TEST_EXPECT(delivered.m_Count == packets && !delivered.m_Corrupt);
+		TEST_EXPECT(!link.m_Client->getStats().m_WriteTimeouts.get());
+		stats   = link.m_Simulator->getStats();
+		seconds = std::chrono::duration<double>(link.m_Simulator->now() - start).count();
+		return true;
+	}
+
+	bool TestNetworkSimulator()
+	{
+		constexpr std::uint32_t s_Packets { 1000U };
+		SimulatorStats          stats;
+		double                  seconds { 0.0 };
+		if (!Transfer(s_Packets, stats, seconds))
+			return false;
+		TEST_EXPECT(stats.m_Lost && stats.m_Reordered && stats.m_Duplicated);
+		TEST_EXPECT(stats.m_Delivered + stats.m_Lost <= stats.m_Sent + stats.m_Duplicated);
+		TEST_EXPECT(!stats.m_Overflowed && !stats.m_Unroutable);
+
+		// The same seed gives the same run
+		SimulatorStats repeated;
+		double         repeatedSeconds { 0.0 };
+		if (!Transfer(s_Packets, repeated, repeatedSeconds))
+			return false;
+		TEST_EXPECT(!std::memcmp(&stats, &repeated, sizeof(stats)) && seconds == repeatedSeconds);
+		return true;
+	}
+} // namespace Tests
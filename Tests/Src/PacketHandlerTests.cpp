@@ -0,0 +1,553 @@
+#include "SimulatedLink.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace Tests
+{
+	using ReliableUDP::LinkConditions;
+	using ReliableUDP::PacketHandler;
+	using namespace ReliableUDP::Networking;
+
+	struct ReceivedPackets
+	{
+	public:
+		std::uint32_t m_Count { 0U };
+		std::uint32_t m_Order[256] {};
+		bool          m_Corrupt { false };
+	};
+
+	// Packets start with their index, followed by bytes derived from the size
+	static void FillPacket(std::uint8_t* packet, std::uint32_t index, std::uint32_t size)
+	{
+		std::memcpy(packet, &index, sizeof(index));
+		for (std::uint32_t i { sizeof(index) }; i < size; ++i)
+			packet[i] = static_cast<std::uint8_t>(i * 7U + size);
+	}
+
+	static void ReceivePacket(PacketHandler* handler, [[maybe_unused]] Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
+	{
+		ReceivedPackets& received { *static_cast<ReceivedPackets*>(handler->getUserData()) };
+		std::uint32_t    index { 0U };
+		std::memcpy(&index, packet, sizeof(index));
+		for (std::uint32_t i { sizeof(index) }; i < size; ++i)
+		{
+			if (packet[i] != static_cast<std::uint8_t>(i * 7U + size))
+				received.m_Corrupt = true;
+		}
+		if (received.m_Count < sizeof(received.m_Order) / sizeof(*received.m_Order))
+			received.m_Order[received.m_Count] = index;
+		++received.m_Count;
+	}
+
+	// Sends the packet back, counts the calls that happened off the application thread
+	static void EchoPacket(PacketHandler* handler, Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
+	{
+		std::uint32_t& misplaced { *static_cast<std::uint32_t*>(handler->getUserData()) };
+		if (handler->isNetworkThread())
+			++misplaced;
+		while (!handler->sendPacket(endpoint, packet, size))
+			std::this_thread::yield();
+	}
+
+	// Hands out m_Data through a read callback, checking that sections are read once and in order
+	struct StreamedData
+	{
+	public:
+		const std::uint8_t* m_Data { nullptr };
+		std::uint32_t       m_Next { 0U };
+		std::uint32_t       m_Reads { 0U };
+		bool                m_InOrder { true };
+		std::uint32_t       m_Done { 0U };
+		bool                m_Delivered { false };
+	};
+
+	static bool ReadStream(void* userData, std::uint32_t offset, std::uint8_t* buffer, std::uint32_t size)
+	{
+		StreamedData& stream { *static_cast<StreamedData*>(userData) };
+		if (offset != stream.m_Next)
+			stream.m_InOrder = false;
+		std::memcpy(buffer, stream.m_Data + offset, size);
+		stream.m_Next = offset + size;
+		++stream.m_Reads;
+		return true;
+	}
+
+	static void StreamDone(void* userData, bool delivered)
+	{
+		StreamedData& stream { *static_cast<StreamedData*>(userData) };
+		stream.m_Delivered = delivered;
+		++stream.m_Done;
+	}
+
+	// Checks the parts of a received stream against m_Data
+	struct ReceivedStream
+	{
+	public:
+		const std::uint8_t* m_Data { nullptr };
+		std::uint32_t       m_Next { 0U };
+		std::uint32_t       m_Parts { 0U };
+		std::uint32_t       m_Complete { 0U };
+		std::uint32_t       m_TimedOut { 0U };
+		bool                m_Corrupt { false };
+	};
+
+	static void ReceiveStreamPart(PacketHandler* handler, [[maybe_unused]] Endpoint endpoint, [[maybe_unused]] std::uint16_t id, std::uint32_t offset, std::uint8_t* packet, std::uint32_t size, std::uint32_t totalSize)
+	{
+		ReceivedStream& stream { *static_cast<ReceivedStream*>(handler->getUserData()) };
+		if (!packet)
+		{
+			++stream.m_TimedOut;
+			return;
+		}
+		if (offset != stream.m_Next || std::memcmp(packet, stream.m_Data + offset, size))
+			stream.m_Corrupt = true;
+		stream.m_Next = offset + size;
+		++stream.m_Parts;
+		if (stream.m_Next == totalSize)
+			++stream.m_Complete;
+	}
+
+	bool TestPathProbing()
+	{
+		// The link drops datagrams over 1400 bytes instead of fragmenting them
+		constexpr std::uint32_t s_LinkMTU { 1400U };
+		LinkConditions          conditions;
+		conditions.m_Delay           = 0.01f;
+		conditions.m_MaxDatagramSize = s_LinkMTU;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, conditions };
+		TEST_EXPECT(link.m_Attached);
+		link.m_Server->setPathProbing(true);
+		link.m_Client->setPathProbing(true);
+
+		std::uint8_t packet[6000];
+		FillPacket(packet, 0U, sizeof(packet));
+		TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, sizeof(packet)));
+		bool delivered { link.runUntil([&] { return received.m_Count == 1U; }) };
+		TEST_EXPECT(delivered);
+
+		// Settles right below the link MTU
+		const PacketHandler& client { *link.m_Client };
+		bool                 settled { link.runUntil([&] { return client.getPeerInfos()[0].m_PathMTU.isDone(); }) };
+		TEST_EXPECT(settled);
+		std::uint32_t datagramSize { client.getSectionSize(link.m_ServerEndpoint) + static_cast<std::uint32_t>(sizeof(ReliableUDP::PacketHeader)) };
+		TEST_EXPECT(datagramSize <= s_LinkMTU && datagramSize + ReliableUDP::Utils::PathMTUSearch::s_MinStep > s_LinkMTU);
+		TEST_EXPECT(link.m_Simulator->getStats().m_Oversized);
+
+		// Later packets fit the link
+		std::uint64_t oversized { link.m_Simulator->getStats().m_Oversized };
+		FillPacket(packet, 1U, sizeof(packet));
+		TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, sizeof(packet)));
+		delivered = link.runUntil([&] { return received.m_Count == 2U; });
+		TEST_EXPECT(delivered);
+		TEST_EXPECT(!received.m_Corrupt && link.m_Simulator->getStats().m_Oversized == oversized);
+		return true;
+	}
+
+	bool TestPeerCapacity()
+	{
+		// 4 read and 4 write slots give the server 8 peers, more clients still get through
+		constexpr std::uint32_t s_Clients { 14U };
+		ReceivedPackets         received;
+		SimulatedLink           link { &ReceivePacket, &received, {}, 4U };
+		TEST_EXPECT(link.m_Attached);
+
+		PacketHandler* handlers[s_Clients + 1U] { link.m_Server };
+		for (std::uint32_t i { 0 }; i < s_Clients; ++i)
+		{
+			handlers[i + 1U] = link.addClient({ IPv4Address { 10, 0, 1, static_cast<std::uint8_t>(i) }, 5000U });
+			TEST_EXPECT(handlers[i + 1U]);
+		}
+
+		std::uint8_t packet[100];
+		for (std::uint32_t round { 0 }; round < 2U; ++round)
+		{
+			for (std::uint32_t i { 0 }; i < s_Clients; ++i)
+			{
+				FillPacket(packet, round * s_Clients + i, sizeof(packet));
+				TEST_EXPECT(handlers[i + 1U]->sendPacket(link.m_ServerEndpoint, packet, sizeof(packet)));
+			}
+			link.m_Simulator->run(handlers, s_Clients + 1U, std::chrono::seconds(1));
+		}
+		TEST_EXPECT(received.m_Count == 2U * s_Clients && !received.m_Corrupt);
+		TEST_EXPECT(!link.m_Server->getStats().m_PeersExhausted.get());
+		return true;
+	}
+
+	bool TestRangeAcknowledge()
+	{
+		// Only the client's datagrams get lost, so every retransmit follows a real loss
+		LinkConditions lossy;
+		lossy.m_Loss  = 0.1f;
+		lossy.m_Delay = 0.01f;
+		LinkConditions clean;
+		clean.m_Delay = 0.01f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, clean };
+		TEST_EXPECT(link.m_Attached);
+		link.m_Simulator->setConditions(link.m_ClientEndpoint, link.m_ServerEndpoint, lossy);
+
+		// About 180 sections
+		static std::uint8_t packet[200000];
+		FillPacket(packet, 0U, sizeof(packet));
+		TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, sizeof(packet)));
+		bool delivered { link.runUntil([&] { return received.m_Count == 1U; }) };
+		TEST_EXPECT(delivered && !received.m_Corrupt);
+		link.run(0.1f);
+
+		// Each acknowledge covers a range of sections, and the holes in its bitmap are all that get resent
+		ReliableUDP::PacketStats client { link.m_Client->getStats() };
+		ReliableUDP::PacketStats server { link.m_Server->getStats() };
+		TEST_EXPECT(server.m_AcknowledgesSent.get() * 3U < server.m_SectionsReceived.get());
+		TEST_EXPECT(client.m_AcknowledgesReceived.get() == server.m_AcknowledgesSent.get());
+		TEST_EXPECT(client.m_SectionsRetransmitted.get() && client.m_SectionsRetransmitted.get() <= link.m_Simulator->getStats().m_Lost);
+		return true;
+	}
+
+	bool TestRoundTrip()
+	{
+		// 40 ms each way
+		LinkConditions conditions;
+		conditions.m_Delay  = 0.04f;
+		conditions.m_Jitter = 0.002f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, conditions };
+		TEST_EXPECT(link.m_Attached);
+
+		std::uint8_t packet[100];
+		for (std::uint32_t i { 0 }; i < 20U; ++i)
+		{
+			FillPacket(packet, i, sizeof(packet));
+			TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, sizeof(packet)));
+			bool delivered { link.runUntil([&] { return received.m_Count == i + 1U; }) };
+			TEST_EXPECT(delivered);
+		}
+		link.run(0.2f);
+
+		// The smoothed RTT settles on the link's 80 ms, the RTO stays above it by the variance
+		const ReliableUDP::Utils::RoundTripEstimator* roundTrip { link.m_Client->getRoundTrip(link.m_ServerEndpoint) };
+		TEST_EXPECT(roundTrip && roundTrip->getSampleCount() >= 20U);
+		TEST_EXPECT(roundTrip->getSmoothedRTT() >= 0.08f && roundTrip->getSmoothedRTT() < 0.1f);
+		TEST_EXPECT(roundTrip->getRTTVariance() < 0.02f);
+		TEST_EXPECT(roundTrip->getRetransmitTimeout() > roundTrip->getSmoothedRTT() && roundTrip->getRetransmitTimeout() < 0.2f);
+		TEST_EXPECT(!link.m_Client->getStats().m_SectionsRetransmitted.get());
+		return true;
+	}
+	bool TestSequencedStale()
+	{
+		// Reordered datagrams arrive after newer ones
+		LinkConditions conditions;
+		conditions.m_Delay        = 0.01f;
+		conditions.m_Reorder      = 0.3f;
+		conditions.m_ReorderDelay = 0.02f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, conditions };
+		TEST_EXPECT(link.m_Attached);
+
+		constexpr std::uint32_t s_Packets { 100U };
+		std::uint8_t            packet[100];
+		for (std::uint32_t i { 0 }; i < s_Packets; ++i)
+		{
+			FillPacket(packet, i, sizeof(packet));
+			TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, sizeof(packet), ReliableUDP::EDelivery::Sequenced));
+			link.run(0.005f);
+		}
+		link.run(0.1f);
+
+		// Only ever newer packets get delivered, the ones that fell behind are dropped
+		std::uint64_t stale { link.m_Server->getStats().m_StalePackets.get() };
+		TEST_EXPECT(received.m_Count < s_Packets && !received.m_Corrupt);
+		TEST_EXPECT(stale && received.m_Count + stale == s_Packets);
+		for (std::uint32_t i { 1 }; i < received.m_Count; ++i)
+			TEST_EXPECT(received.m_Order[i] > received.m_Order[i - 1U]);
+		return true;
+	}
+	bool TestChannels()
+	{
+		LinkConditions conditions;
+		conditions.m_Loss         = 0.05f;
+		conditions.m_Delay        = 0.01f;
+		conditions.m_Reorder      = 0.1f;
+		conditions.m_ReorderDelay = 0.01f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, conditions };
+		TEST_EXPECT(link.m_Attached);
+		PacketHandler& client { *link.m_Client };
+		client.setChannel(0U, 0U);
+		client.setChannel(1U, 1U, 1U, true);
+		client.setChannel(2U, 2U);
+
+		// Bulk is queued first, then ordered packets of mixed sizes, then a control packet
+		constexpr std::uint32_t s_Bulk { 1000U };
+		constexpr std::uint32_t s_Control { 999U };
+		constexpr std::uint32_t s_Ordered { 40U };
+		static std::uint8_t     packet[40000];
+		for (std::uint32_t i { 0 }; i < 3U; ++i)
+		{
+			FillPacket(packet, s_Bulk + i, sizeof(packet));
+			TEST_EXPECT(client.sendPacket(link.m_ServerEndpoint, packet, sizeof(packet), ReliableUDP::EDelivery::Reliable, 2U));
+		}
+		for (std::uint32_t i { 0 }; i < s_Ordered; ++i)
+		{
+			std::uint32_t size { i % 4U ? 20U : 6000U };
+			FillPacket(packet, i, size);
+			TEST_EXPECT(client.sendPacket(link.m_ServerEndpoint, packet, size, ReliableUDP::EDelivery::Reliable, 1U));
+		}
+		FillPacket(packet, s_Control, 20U);
+		TEST_EXPECT(client.sendPacket(link.m_ServerEndpoint, packet, 20U, ReliableUDP::EDelivery::Reliable, 0U));
+		bool delivered { link.runUntil([&] { return received.m_Count == s_Ordered + 4U; }) };
+		TEST_EXPECT(delivered && !received.m_Corrupt && link.m_Simulator->getStats().m_Lost);
+
+		// The control packet overtakes the bulk, the ordered channel arrives in send order despite loss
+		std::uint32_t nextOrdered { 0U };
+		std::uint32_t bulk { 0U };
+		for (std::uint32_t i { 0 }; i < received.m_Count; ++i)
+		{
+			std::uint32_t index { received.m_Order[i] };
+			if (index == s_Control)
+				TEST_EXPECT(!bulk);
+			else if (index >= s_Bulk)
+				++bulk;
+			else
+				TEST_EXPECT(index == nextOrdered++);
+		}
+		TEST_EXPECT(nextOrdered == s_Ordered && bulk == 3U);
+		return true;
+	}
+	bool TestParity()
+	{
+		// Only the client's datagrams get lost
+		LinkConditions lossy;
+		lossy.m_Loss  = 0.05f;
+		lossy.m_Delay = 0.01f;
+		LinkConditions clean;
+		clean.m_Delay = 0.01f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, clean };
+		TEST_EXPECT(link.m_Attached);
+		link.m_Simulator->setConditions(link.m_ClientEndpoint, link.m_ServerEndpoint, lossy);
+		link.m_Client->setChannelParity(0U, 4U);
+
+		constexpr std::uint32_t s_Packets { 30U };
+		std::uint8_t            packet[20000];
+		for (std::uint32_t i { 0 }; i < s_Packets; ++i)
+		{
+			std::uint32_t size { 3000U + i * 531U };
+			FillPacket(packet, i, size);
+			TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, size));
+			link.run(0.01f);
+		}
+		bool delivered { link.runUntil([&] { return received.m_Count == s_Packets; }) };
+		TEST_EXPECT(delivered && !received.m_Corrupt);
+
+		// Lost sections get rebuilt from parity instead of waiting for a retransmit
+		ReliableUDP::PacketStats client { link.m_Client->getStats() };
+		ReliableUDP::PacketStats server { link.m_Server->getStats() };
+		TEST_EXPECT(client.m_ParitySent.get() && server.m_SectionsRecovered.get());
+		TEST_EXPECT(client.m_SectionsRetransmitted.get() < link.m_Simulator->getStats().m_Lost);
+		return true;
+	}
+	bool TestThreaded()
+	{
+		// Simulated time belongs to one thread, so the network threads use loopback sockets
+		std::uint32_t   misplaced { 0U };
+		ReceivedPackets received;
+		PacketHandler   server { 200000, 200000, 64, 64, 8, &EchoPacket, &misplaced };
+		PacketHandler   client { 200000, 200000, 64, 64, 8, &ReceivePacket, &received };
+		server.getSocket().setNonBlocking();
+		client.getSocket().setNonBlocking();
+		TEST_EXPECT(server.getSocket().bind({ "127.0.0.1", "0", EAddressType::IPv4 }));
+		TEST_EXPECT(client.getSocket().bind({ "127.0.0.1", "0", EAddressType::IPv4 }));
+		Endpoint serverEndpoint { server.getSocket().getLocalEndpoint() };
+		TEST_EXPECT(server.startThread(1U << 16, 1U << 16) && client.startThread(1U << 16, 1U << 16));
+
+		// Both handlers' callbacks run here, sends cross the rings to the network threads
+		constexpr std::uint32_t        s_Packets { 140U };
+		std::uint8_t                   packet[20000];
+		std::uint32_t                  sent { 0U };
+		ReliableUDP::Clock::time_point start { ReliableUDP::Clock::now() };
+		while (received.m_Count < s_Packets && ReliableUDP::Clock::now() - start < std::chrono::seconds(10))
+		{
+			for (; sent < s_Packets; ++sent)
+			{
+				std::uint32_t size { sent % 7U == 3U ? 20000U : 10U + (sent * 13U) % 1500U };
+				FillPacket(packet, sent, size);
+				if (!client.sendPacket(serverEndpoint, packet, size))
+					break;
+			}
+			std::uint32_t handled { server.handleReceivedPackets() };
+			handled += client.handleReceivedPackets();
+			if (!handled)
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		client.stopThread();
+		server.stopThread();
+		TEST_EXPECT(received.m_Count == s_Packets && !received.m_Corrupt && !misplaced);
+		TEST_EXPECT(!server.isThreaded() && !client.isThreaded());
+		return true;
+	}
+	bool TestCoalescing()
+	{
+		LinkConditions conditions;
+		conditions.m_Delay = 0.01f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, conditions };
+		TEST_EXPECT(link.m_Attached);
+		link.m_Client->setChannel(1U, 0U, 1U, true);
+		link.m_Client->setCoalescing(1200U, 0.002f);
+
+		// Small messages and one too large to share a packet
+		constexpr std::uint32_t s_Packets { 200U };
+		std::uint8_t            packet[5000];
+		for (std::uint32_t i { 0 }; i < s_Packets; ++i)
+		{
+			std::uint32_t size { i == 97U ? 5000U : 10U + (i * 13U) % 31U };
+			FillPacket(packet, i, size);
+			TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, size, ReliableUDP::EDelivery::Reliable, 1U));
+		}
+		bool delivered { link.runUntil([&] { return received.m_Count == s_Packets; }) };
+		TEST_EXPECT(delivered && !received.m_Corrupt);
+
+		// Every message arrives on its own and in order, a few sections carry them all
+		for (std::uint32_t i { 0 }; i < s_Packets; ++i)
+			TEST_EXPECT(received.m_Order[i] == i);
+		TEST_EXPECT(link.m_Client->getStats().m_SectionsSent.get() < s_Packets / 10U);
+		return true;
+	}
+	bool TestMetrics()
+	{
+		// 20 ms each way, only the client's datagrams get lost
+		LinkConditions lossy;
+		lossy.m_Loss  = 0.05f;
+		lossy.m_Delay = 0.02f;
+		LinkConditions clean;
+		clean.m_Delay = 0.02f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, clean };
+		TEST_EXPECT(link.m_Attached);
+		link.m_Simulator->setConditions(link.m_ClientEndpoint, link.m_ServerEndpoint, lossy);
+
+		constexpr std::uint32_t s_Packets { 20U };
+		std::uint8_t            packet[10000];
+		for (std::uint32_t i { 0 }; i < s_Packets; ++i)
+		{
+			std::uint32_t size { i % 2U ? 100U : 10000U };
+			FillPacket(packet, i, size);
+			TEST_EXPECT(link.m_Client->sendPacket(link.m_ServerEndpoint, packet, size));
+		}
+		bool delivered { link.runUntil([&] { return received.m_Count == s_Packets; }) };
+		TEST_EXPECT(delivered && !received.m_Corrupt);
+		bool acknowledged { link.runUntil([&] { return link.m_Client->getStats().m_PacketsAcknowledged.get() == s_Packets; }) };
+		TEST_EXPECT(acknowledged);
+		link.run(0.1f);
+
+		// The handlers' counters agree with each other and with what the simulator carried
+		ReliableUDP::PacketStats    client { link.m_Client->getStats() };
+		ReliableUDP::PacketStats    server { link.m_Server->getStats() };
+		ReliableUDP::SimulatorStats simulator { link.m_Simulator->getStats() };
+		TEST_EXPECT(client.m_DatagramsSent.get() + server.m_DatagramsSent.get() == simulator.m_Sent);
+		TEST_EXPECT(client.m_DatagramsReceived.get() + server.m_DatagramsReceived.get() == simulator.m_Delivered);
+		TEST_EXPECT(server.m_PacketsDelivered.get() == s_Packets && !client.m_DatagramsDropped.get());
+		TEST_EXPECT(client.m_SectionsSent.get() == server.m_SectionsReceived.get() + simulator.m_Lost);
+		TEST_EXPECT(client.m_AcknowledgesReceived.get() == server.m_AcknowledgesSent.get());
+		TEST_EXPECT(!client.m_WritePacketsUsed.get() && !server.m_ReadPacketsUsed.get());
+
+		// Round trips land in the 40 ms range, every packet took at least one
+		float roundTrip { client.m_RoundTrip.getPercentile(0.5f) };
+		TEST_EXPECT(client.m_RoundTrip.getCount() && roundTrip >= 0.04f && roundTrip < 0.1f);
+		TEST_EXPECT(client.m_DeliveryLatency.getCount() == s_Packets && client.m_DeliveryLatency.getPercentile(0.0f) >= 0.04f);
+
+		// The peer's share matches with a single peer
+		ReliableUDP::PeerStats peer;
+		TEST_EXPECT(link.m_Client->getPeerStats(link.m_ServerEndpoint, peer));
+		TEST_EXPECT(peer.m_PacketsAcknowledged.get() == s_Packets && peer.m_SectionsSent.get() == client.m_SectionsSent.get());
+		TEST_EXPECT(peer.m_RoundTrip.getCount() == client.m_RoundTrip.getCount());
+		TEST_EXPECT(!link.m_Client->getPeerStats({ IPv4Address { 10, 0, 0, 9 }, 4000U }, peer));
+		return true;
+	}
+	bool TestSendStream()
+	{
+		// Only the client's datagrams get lost
+		LinkConditions lossy;
+		lossy.m_Loss  = 0.02f;
+		lossy.m_Delay = 0.01f;
+		LinkConditions clean;
+		clean.m_Delay = 0.01f;
+
+		ReceivedPackets received;
+		SimulatedLink   link { &ReceivePacket, &received, clean };
+		TEST_EXPECT(link.m_Attached);
+		link.m_Simulator->setConditions(link.m_ClientEndpoint, link.m_ServerEndpoint, lossy);
+
+		// Pulled from the callback a window at a time instead of copied into the write buffer
+		constexpr std::uint32_t s_Size { 150000U };
+		static std::uint8_t     data[s_Size];
+		FillPacket(data, 0U, s_Size);
+		StreamedData              stream { data };
+		ReliableUDP::StreamSource source;
+		source.m_Read     = &ReadStream;
+		source.m_Done     = &StreamDone;
+		source.m_UserData = &stream;
+		TEST_EXPECT(link.m_Client->sendStream(link.m_ServerEndpoint, s_Size, source));
+
+		std::uint64_t buffered { 0U };
+		for (std::uint32_t step { 0 }; !stream.m_Done && step < 3000U; ++step)
+		{
+			link.run(0.01f);
+			buffered = std::max(buffered, link.m_Client->getStats().m_WriteBufferUsed.get());
+		}
+		TEST_EXPECT(stream.m_Done == 1U && stream.m_Delivered);
+		TEST_EXPECT(received.m_Count == 1U && !received.m_Corrupt);
+		TEST_EXPECT(stream.m_InOrder && stream.m_Next == s_Size && stream.m_Reads > 1U);
+		TEST_EXPECT(buffered && buffered < s_Size / 4U && link.m_Simulator->getStats().m_Lost);
+		return true;
+	}
+	bool TestReceiveStream()
+	{
+		// Only the client's datagrams get lost or reordered
+		LinkConditions lossy;
+		lossy.m_Loss         = 0.02f;
+		lossy.m_Delay        = 0.01f;
+		lossy.m_Reorder      = 0.1f;
+		lossy.m_ReorderDelay = 0.01f;
+		LinkConditions clean;
+		clean.m_Delay = 0.01f;
+
+		// Five times the server's read buffer
+		constexpr std::uint32_t s_Size { 1000000U };
+		static std::uint8_t     data[s_Size];
+		FillPacket(data, 0U, s_Size);
+		ReceivedStream received { data };
+		SimulatedLink  link { nullptr, &received, clean };
+		TEST_EXPECT(link.m_Attached);
+		link.m_Simulator->setConditions(link.m_ClientEndpoint, link.m_ServerEndpoint, lossy);
+		link.m_Server->setStreamReceive(&ReceiveStreamPart, 1U << 16, 1U << 16);
+
+		StreamedData              stream;
+		ReliableUDP::StreamSource source;
+		source.m_Data     = data;
+		source.m_Done     = &StreamDone;
+		source.m_UserData = &stream;
+		TEST_EXPECT(link.m_Client->sendStream(link.m_ServerEndpoint, s_Size, source));
+		bool done { link.runUntil([&] { return stream.m_Done != 0U; }) };
+		TEST_EXPECT(done && stream.m_Delivered);
+
+		// The parts line up into the whole stream although its sections arrived out of order
+		ReliableUDP::SimulatorStats simulator { link.m_Simulator->getStats() };
+		TEST_EXPECT(received.m_Complete == 1U && received.m_Parts > 1U && !received.m_TimedOut && !received.m_Corrupt);
+		TEST_EXPECT(simulator.m_Lost && simulator.m_Reordered);
+		TEST_EXPECT(!link.m_Server->getStats().m_ReadPacketsUsed.get());
+		return true;
+	}
+} // namespace Tests
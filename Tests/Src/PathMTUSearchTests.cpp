@@ -0,0 +1,51 @@
+#include "Tests.h"
+
+#include <ReliableUDP/Utils/PathMTUSearch.h>
+
+namespace Tests
+{
+	using ReliableUDP::Utils::PathMTUSearch;
+
+	bool TestPathMTUSearch()
+	{
+		PathMTUSearch search;
+		search.reset(1000U);
+		TEST_EXPECT(search.isDone() && search.getSize() == 1000U);
+
+		// A size is only too large after s_MaxProbes losses
+		search.reset(9000U);
+		TEST_EXPECT(search.nextProbe() == 9000U);
+		for (std::uint32_t i { 1 }; i < PathMTUSearch::s_MaxProbes; ++i)
+			search.probeLost(9000U);
+		TEST_EXPECT(search.getMaxSize() == 9000U && search.nextProbe() == 9000U);
+		search.probeLost(9000U);
+		TEST_EXPECT(search.getMaxSize() == 8999U && search.nextProbe() == (PathMTUSearch::s_BaseSize + 8999U + 1U) / 2U);
+
+		// Late answers for sizes outside the range are ignored
+		search.probeAcknowledged(PathMTUSearch::s_BaseSize - 100U);
+		search.probeLost(9000U);
+		TEST_EXPECT(search.getSize() == PathMTUSearch::s_BaseSize && search.getMaxSize() == 8999U);
+
+		// Converges next to every path MTU, losing every probe above it
+		for (std::uint32_t mtu { PathMTUSearch::s_BaseSize }; mtu <= 9000U; mtu += 37U)
+		{
+			search.reset(9000U);
+			std::uint32_t probes { 0U };
+			for (std::uint32_t size { search.nextProbe() }; size; size = search.nextProbe())
+			{
+				TEST_EXPECT(size > search.getSize() && size <= search.getMaxSize() && ++probes < 64U);
+				if (size <= mtu)
+				{
+					search.probeAcknowledged(size);
+					continue;
+				}
+				for (std::uint32_t i { 0 }; i < PathMTUSearch::s_MaxProbes; ++i)
+					search.probeLost(size);
+			}
+			TEST_EXPECT(search.getSize() <= mtu && mtu <= search.getMaxSize());
+			TEST_EXPECT(search.getMaxSize() - search.getSize() < PathMTUSearch::s_MinStep);
+			TEST_EXPECT(probes <= 10U);
+		}
+		return true;
+	}
+} // namespace Tests
@@ -0,0 +1,128 @@
+#include "Tests.h"
+
+#include <ReliableUDP/PcapReplay.h>
+
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace Tests
+{
+	using ReliableUDP::PacketHandler;
+	using namespace ReliableUDP::Networking;
+
+	struct Received
+	{
+	public:
+		std::uint32_t m_Count { 0U };
+		bool          m_Corrupt { false };
+	};
+
+	static void FillPacket(std::uint8_t* packet, std::uint32_t size)
+	{
+		for (std::uint32_t i { 0 }; i < size; ++i)
+			packet[i] = static_cast<std::uint8_t>(i * 7U + size);
+	}
+
+	static void ReceivePacket(PacketHandler* handler, [[maybe_unused]] Endpoint endpoint, std::uint8_t* packet, std::uint32_t size)
+	{
+		Received& received { *static_cast<Received*>(handler->getUserData()) };
+		for (std::uint32_t i { 0 }; i < size; ++i)
+		{
+			if (packet[i] != static_cast<std::uint8_t>(i * 7U + size))
+				received.m_Corrupt = true;
+		}
+		++received.m_Count;
+	}
+
+	// Records the datagrams of a loopback transfer, returns the server's endpoint
+	static bool CaptureTransfer(const std::string& path, std::uint32_t packets, Endpoint& serverEndpoint)
+	{
+		PcapWriter    writer;
+		Received      received;
+		PacketHandler server { 200000, 200000, 64, 64, 8, &ReceivePacket, &received };
+		PacketHandler client { 200000, 200000, 64, 64, 8, nullptr, nullptr };
+		server.getSocket().setNonBlocking();
+		client.getSocket().setNonBlocking();
+		TEST_EXPECT(writer.open(path));
+		TEST_EXPECT(server.getSocket().bind({ "127.0.0.1", "0", EAddressType::IPv4 }));
+		TEST_EXPECT(client.getSocket().bind({ "127.0.0.1", "0", EAddressType::IPv4 }));
+		writer.attach(server.getSocket());
+		writer.attach(client.getSocket());
+		serverEndpoint = server.getSocket().getLocalEndpoint();
+
+		std::uint8_t                   packet[9000];
+		std::uint32_t                  sent { 0U };
+		ReliableUDP::Clock::time_point start { ReliableUDP::Clock::now() };
+		while (received.m_Count < packets && ReliableUDP::Clock::now() - start < std::chrono::seconds(10))
+		{
+			// Small packets and a few that need splitting
+			for (; sent < packets; ++sent)
+			{
+				std::uint32_t size { sent % 37U == 5U ? 9000U : 10U + (sent * 13U) % 300U };
+				FillPacket(packet, size);
+				if (!client.sendPacket(serverEndpoint, packet, size))
+					break;
+			}
+			client.updatePackets();
+			server.updatePackets();
+			std::this_thread::sleep_for(std::chrono::microseconds(300));
+		}
+		writer.close();
+		TEST_EXPECT(received.m_Count == packets && !received.m_Corrupt);
+		TEST_EXPECT(!writer.getDropped() && writer.getRecorded() >= packets);
+		return true;
+	}
+
+	bool TestPcap()
+	{
+		std::string path { (std::filesystem::temp_directory_path() / "ReliableUDPTests.pcap").string() };
+
+		// Scattered IPv4 and IPv6 datagrams read back as written
+		Endpoint     local { IPv4Address { 127, 0, 0, 1 }, 1000U };
+		Endpoint     remote { IPv4Address { 10, 1, 2, 3 }, 2000U };
+		Endpoint     local6 { IPv6Address { 0, 0, 0, 0, 0, 0, 0, 1 }, 3000U };
+		Endpoint     remote6 { IPv6Address { 0x2001, 0xDB8, 0, 0, 0, 0, 0, 7 }, 4000U };
+		std::uint8_t data[1400];
+		FillPacket(data, sizeof(data));
+		{
+			PcapWriter writer;
+			TEST_EXPECT(writer.open(path));
+			Buffer buffers[2] { { data, 100U }, { data + 100U, 1300U } };
+			writer.record(true, local, remote, buffers, 2U);
+			writer.record(false, local, remote, buffers, 1U);
+			writer.record(true, local6, remote6, buffers + 1U, 1U);
+			writer.close();
+			TEST_EXPECT(writer.getRecorded() == 3U);
+		}
+
+		PcapReader reader;
+		PcapRecord record;
+		TEST_EXPECT(reader.open(path));
+		TEST_EXPECT(reader.next(record) && record.m_Source == local && record.m_Destination == remote);
+		TEST_EXPECT(record.m_Size == 1400U && !std::memcmp(record.m_Data, data, 1400U));
+		std::uint64_t time { record.m_Time };
+		TEST_EXPECT(reader.next(record) && record.m_Source == remote && record.m_Destination == local);
+		TEST_EXPECT(record.m_Size == 100U && !std::memcmp(record.m_Data, data, 100U) && record.m_Time >= time);
+		TEST_EXPECT(reader.next(record) && record.m_Source == local6 && record.m_Destination == remote6);
+		TEST_EXPECT(record.m_Size == 1300U && !std::memcmp(record.m_Data, data + 100U, 1300U));
+		TEST_EXPECT(!reader.next(record));
+		reader.close();
+
+		// A replayed transfer delivers every packet again
+		constexpr std::uint32_t s_Packets { 200U };
+		Endpoint                serverEndpoint;
+		if (!CaptureTransfer(path, s_Packets, serverEndpoint))
+			return false;
+
+		Received                received;
+		PacketHandler           replayed { 200000, 200000, 64, 64, 8, &ReceivePacket, &received };
+		ReliableUDP::PcapReplay replay { replayed, 0.0f };
+		TEST_EXPECT(replay.open(path, { IPv4Address {}, serverEndpoint.m_Port }));
+		replay.run();
+		TEST_EXPECT(replay.getInjected() >= s_Packets && received.m_Count == s_Packets && !received.m_Corrupt);
+		replay.close();
+		std::filesystem::remove(path);
+		return true;
+	}
+} // namespace Tests
@@ -0,0 +1,64 @@
+#include "Tests.h"
+
+#include <ReliableUDP/Utils/SequenceWindow.h>
+
+#include <random>
+#include <set>
+
+namespace Tests
+{
+	using ReliableUDP::Utils::ESequenceState;
+	using ReliableUDP::Utils::SequenceWindow;
+
+	bool TestSequenceWindow()
+	{
+		SequenceWindow window;
+		TEST_EXPECT(window.isEmpty() && window.getState(0U) == ESequenceState::New);
+		TEST_EXPECT(window.mark(10U));
+		TEST_EXPECT(window.getState(10U) == ESequenceState::Handled);
+		TEST_EXPECT(window.getState(9U) == ESequenceState::New && window.getState(11U) == ESequenceState::New);
+		TEST_EXPECT(!window.mark(9U) && window.getState(9U) == ESequenceState::Handled);
+		TEST_EXPECT(window.getState(static_cast<std::uint16_t>(10U - SequenceWindow::s_Size)) == ESequenceState::Stale);
+
+		// Across the wrap
+		window.reset();
+		TEST_EXPECT(window.mark(65530U) && window.mark(3U));
+		TEST_EXPECT(window.getState(65530U) == ESequenceState::Handled && window.getState(65535U) == ESequenceState::New);
+		TEST_EXPECT(window.getState(3U) == ESequenceState::Handled && window.getState(4U) == ESequenceState::New);
+
+		// Against absolute sequence numbers, forgotten once the window jumped past them
+		std::set<std::uint64_t> marked;
+		std::uint64_t           newest { 0U };
+		std::mt19937            random { 4U };
+		window.reset();
+		window.mark(0U);
+		marked.insert(0U);
+		for (std::uint32_t i { 0 }; i < 20000U; ++i)
+		{
+			std::uint32_t choice { static_cast<std::uint32_t>(random() % 8U) };
+			std::uint64_t sequence { newest };
+			if (choice < 3U)
+				sequence = newest + 1U + random() % (choice == 2U ? 2000U : 8U);
+			else if (newest >= 1500U)
+				sequence = newest - random() % 1500U;
+
+			bool ahead { sequence > newest };
+			bool stale { sequence + SequenceWindow::s_Size <= newest };
+			TEST_EXPECT(window.mark(static_cast<std::uint16_t>(sequence)) == ahead);
+			if (ahead)
+				newest = sequence;
+			if (!stale)
+				marked.insert(sequence);
+
+			for (std::uint64_t back { 0 }; back < 1100U && back <= newest; back += 1U + random() % 16U)
+			{
+				std::uint64_t  other { newest - back };
+				ESequenceState expected { back >= SequenceWindow::s_Size ? ESequenceState::Stale : marked.count(other) ? ESequenceState::Handled :
+					                                                                                                     ESequenceState::New };
+				TEST_EXPECT(window.getState(static_cast<std::uint16_t>(other)) == expected);
+			}
+			TEST_EXPECT(window.getState(static_cast<std::uint16_t>(newest + 1U)) == ESequenceState::New);
+		}
+		return true;
+	}
+} // namespace Tests
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ReliableUDP/NetworkSimulator.h>
+
+namespace Tests
+{
+	// A client sending to a server over a simulated link, both on simulated time
+	struct SimulatedLink
+	{
+	public:
+		// The server gets maxPackets read and write slots
+		SimulatedLink(ReliableUDP::PacketHandler::HandleCallback handleCallback, void* userData, const ReliableUDP::LinkConditions& conditions, std::uint32_t maxPackets = 64U)
+		    : m_Simulator(new ReliableUDP::NetworkSimulator { 7U })
+		{
+			m_Simulator->useSimulatedTime();
+			m_Server   = new ReliableUDP::PacketHandler { 200000, 200000, maxPackets, maxPackets, 8, handleCallback, userData };
+			m_Client   = new ReliableUDP::PacketHandler { 200000, 200000, 64, 64, 8, nullptr, nullptr };
+			m_Attached = m_Simulator->attach(m_Server->getSocket(), m_ServerEndpoint) && m_Simulator->attach(m_Client->getSocket(), m_ClientEndpoint);
+			m_Simulator->setConditions(conditions);
+		}
+
+		SimulatedLink(const SimulatedLink&) = delete;
+
+		// The simulator goes first, it still touches the sockets
+		~SimulatedLink()
+		{
+			delete m_Simulator;
+			for (std::uint32_t i { 0 }; i < m_ExtraCount; ++i)
+				delete m_Extra[i];
+			delete m_Client;
+			delete m_Server;
+		}
+
+		SimulatedLink& operator=(const SimulatedLink&) = delete;
+
+		// Another client at endpoint, nullptr if the simulator has no room for it
+		ReliableUDP::PacketHandler* addClient(ReliableUDP::Networking::Endpoint endpoint)
+		{
+			if (m_ExtraCount >= ReliableUDP::NetworkSimulator::s_MaxSockets)
+				return nullptr;
+			ReliableUDP::PacketHandler* client { new ReliableUDP::PacketHandler { 20000, 20000, 4, 4, 8, nullptr, nullptr } };
+			m_Extra[m_ExtraCount++] = client;
+			return m_Simulator->attach(client->getSocket(), endpoint) ? client : nullptr;
+		}
+
+		// Updates both handlers in 10 ms steps until done returns true, false after timeout simulated seconds
+		template <class Done>
+		bool runUntil(Done&& done, float timeout = 30.0f)
+		{
+			ReliableUDP::Clock::time_point end { m_Simulator->now() + std::chrono::duration_cast<ReliableUDP::Clock::duration>(std::chrono::duration<float>(timeout)) };
+			while (!done())
+			{
+				if (m_Simulator->now() >= end)
+					return false;
+				run(0.01f);
+			}
+			return true;
+		}
+
+		void run(float seconds)
+		{
+			ReliableUDP::PacketHandler* handlers[2] { m_Client, m_Server };
+			m_Simulator->run(handlers, 2U, std::chrono::duration_cast<ReliableUDP::Clock::duration>(std::chrono::duration<float>(seconds)));
+		}
+
+	public:
+		ReliableUDP::NetworkSimulator*    m_Simulator;
+		ReliableUDP::PacketHandler*       m_Server { nullptr };
+		ReliableUDP::PacketHandler*       m_Client { nullptr };
+		ReliableUDP::PacketHandler*       m_Extra[ReliableUDP::NetworkSimulator::s_MaxSockets] {};
+		std::uint32_t                     m_ExtraCount { 0U };
+		ReliableUDP::Networking::Endpoint m_ServerEndpoint { ReliableUDP::Networking::IPv4Address { 10, 0, 0, 1 }, 4000U };
+		ReliableUDP::Networking::Endpoint m_ClientEndpoint { ReliableUDP::Networking::IPv4Address { 10, 0, 0, 2 }, 5000U };
+		bool                              m_Attached { false };
+	};
+} // namespace Tests
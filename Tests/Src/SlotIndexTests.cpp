@@ -0,0 +1,74 @@
+#include "Tests.h"
+
+#include <ReliableUDP/Utils/SlotIndex.h>
+
+#include <random>
+
+namespace Tests
+{
+	using Index = ReliableUDP::Utils::SlotIndex<std::uint32_t>;
+
+	static bool MatchesReference(const Index& index, const std::uint32_t* reference, std::uint32_t keys)
+	{
+		std::uint32_t size { 0U };
+		for (std::uint32_t key { 0 }; key < keys; ++key)
+		{
+			TEST_EXPECT(index.find(key) == reference[key]);
+			if (reference[key] != Index::s_Invalid)
+				++size;
+		}
+		TEST_EXPECT(index.size() == size);
+		return true;
+	}
+
+	bool TestSlotIndex()
+	{
+		// 16 buckets, at most 15 entries
+		Index index { 8U };
+		TEST_EXPECT(index.capacity() == 16U);
+		TEST_EXPECT(index.insert(1U, 10U));
+		TEST_EXPECT(!index.insert(1U, 11U));
+		TEST_EXPECT(index.find(1U) == 10U);
+		TEST_EXPECT(index.erase(1U));
+		TEST_EXPECT(!index.erase(1U));
+		TEST_EXPECT(index.empty());
+
+		for (std::uint32_t key { 0 }; key < 15U; ++key)
+			TEST_EXPECT(index.insert(key, key));
+		TEST_EXPECT(!index.insert(15U, 15U));
+		index.clear();
+		TEST_EXPECT(index.empty() && index.find(0U) == Index::s_Invalid);
+
+		// Nearly full with few keys, so erases keep shifting wrapped probe chains back
+		constexpr std::uint32_t s_Keys { 48U };
+		std::uint32_t           reference[s_Keys];
+		for (std::uint32_t& slot : reference)
+			slot = Index::s_Invalid;
+
+		std::mt19937 random { 1U };
+		for (std::uint32_t i { 0 }; i < 20000U; ++i)
+		{
+			std::uint32_t key { static_cast<std::uint32_t>(random() % s_Keys) };
+			if (reference[key] != Index::s_Invalid)
+			{
+				TEST_EXPECT(index.erase(key));
+				reference[key] = Index::s_Invalid;
+			}
+			else if (index.size() + 2U < index.capacity())
+			{
+				TEST_EXPECT(index.insert(key, i));
+				reference[key] = i;
+			}
+			if (!MatchesReference(index, reference, s_Keys))
+				return false;
+		}
+
+		for (std::uint32_t key { 0 }; key < s_Keys; ++key)
+		{
+			if (reference[key] != Index::s_Invalid)
+				TEST_EXPECT(index.erase(key));
+		}
+		TEST_EXPECT(index.empty());
+		return true;
+	}
+} // namespace Tests
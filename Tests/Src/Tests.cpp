@@ -0,0 +1,50 @@
+#include "Tests.h"
+
+#include <cstdint>
+
+namespace Tests
+{
+	struct TestCase
+	{
+	public:
+		const char* m_Name;
+		bool (*m_Function)();
+	};
+
+	static constexpr TestCase s_Tests[] {
+		{ "SlotIndex", &TestSlotIndex },
+		{ "BlockAllocator", &TestBlockAllocator },
+		{ "TimerWheel", &TestTimerWheel },
+		{ "SequenceWindow", &TestSequenceWindow },
+		{ "PathMTUSearch", &TestPathMTUSearch },
+		{ "CongestionController", &TestCongestionController },
+		{ "Pcap", &TestPcap },
+		{ "NetworkSimulator", &TestNetworkSimulator },
+		{ "PathProbing", &TestPathProbing },
+		{ "PeerCapacity", &TestPeerCapacity },
+		{ "RangeAcknowledge", &TestRangeAcknowledge },
+		{ "RoundTrip", &TestRoundTrip },
+		{ "SequencedStale", &TestSequencedStale },
+		{ "Channels", &TestChannels },
+		{ "Parity", &TestParity },
+		{ "Threaded", &TestThreaded },
+		{ "Coalescing", &TestCoalescing },
+		{ "Metrics", &TestMetrics },
+		{ "SendStream", &TestSendStream },
+		{ "ReceiveStream", &TestReceiveStream }
+	};
+
+	bool RunTests()
+	{
+		std::uint32_t failed { 0U };
+		for (const TestCase& test : s_Tests)
+		{
+			bool passed { test.m_Function() };
+			std::cout << (passed ? "passed " : "FAILED ") << test.m_Name << '\n';
+			if (!passed)
+				++failed;
+		}
+		std::cout << (sizeof(s_Tests) / sizeof(*s_Tests) - failed) << '/' << (sizeof(s_Tests) / sizeof(*s_Tests)) << " tests passed\n";
+		return !failed;
+	}
+} // namespace Tests
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+
+// Prints the failed expression and fails the test
+#define TEST_EXPECT(expression)                                                      \
+	do                                                                               \
+	{                                                                                \
+		if (!(expression))                                                           \
+		{                                                                            \
+			std::cout << __FILE__ << ':' << __LINE__ << ": " << #expression << '\n'; \
+			return false;                                                            \
+		}                                                                            \
+	} while (false)
+
+namespace Tests
+{
+	bool TestSlotIndex();
+	bool TestBlockAllocator();
+	bool TestTimerWheel();
+	bool TestSequenceWindow();
+	bool TestPathMTUSearch();
+	bool TestCongestionController();
+	bool TestPcap();
+	bool TestNetworkSimulator();
+	bool TestPathProbing();
+	bool TestPeerCapacity();
+	bool TestRangeAcknowledge();
+	bool TestRoundTrip();
+	bool TestSequencedStale();
+	bool TestChannels();
+	bool TestParity();
+	bool TestThreaded();
+	bool TestCoalescing();
+	bool TestMetrics();
+	bool TestSendStream();
+	bool TestReceiveStream();
+
+	// Returns false if any test failed
+	bool RunTests();
+} // namespace Tests
@@ -0,0 +1,94 @@
+#include "Tests.h"
+
+#include <ReliableUDP/Utils/TimerWheel.h>
+
+#include <random>
+
+namespace Tests
+{
+	using ReliableUDP::Utils::TimerWheel;
+
+	static constexpr std::uint64_t s_Idle { ~0ULL };
+
+	// Pops everything due at tick and checks it against the expected deadlines
+	static bool PopDue(TimerWheel& wheel, std::uint64_t* deadlines, std::uint32_t timers, std::uint64_t tick)
+	{
+		for (std::uint32_t timer { wheel.popExpired(tick) }; timer != TimerWheel::s_Invalid; timer = wheel.popExpired(tick))
+		{
+			TEST_EXPECT(timer < timers && deadlines[timer] <= tick);
+			deadlines[timer] = s_Idle;
+		}
+
+		std::uint64_t earliest { s_Idle };
+		for (std::uint32_t timer { 0 }; timer < timers; ++timer)
+		{
+			TEST_EXPECT(deadlines[timer] > tick);
+			TEST_EXPECT(wheel.isScheduled(timer) == (deadlines[timer] != s_Idle));
+			if (deadlines[timer] < earliest)
+				earliest = deadlines[timer];
+		}
+		TEST_EXPECT(wheel.nextTick() <= earliest);
+		return true;
+	}
+
+	bool TestTimerWheel()
+	{
+		constexpr std::uint32_t s_Timers { 64U };
+		TimerWheel              wheel { s_Timers };
+		std::uint64_t           deadlines[s_Timers];
+		for (std::uint64_t& deadline : deadlines)
+			deadline = s_Idle;
+		TEST_EXPECT(wheel.popExpired(100U) == TimerWheel::s_Invalid && wheel.nextTick() == s_Idle);
+
+		// Each level boundary cascades down to the tick it was scheduled for
+		std::uint64_t start { wheel.getCurrentTick() };
+		for (std::uint32_t level { 0 }; level < TimerWheel::s_Levels; ++level)
+		{
+			std::uint64_t offset { 1ULL << (level * TimerWheel::s_Bits) };
+			wheel.schedule(level * 3U, start + offset - 1U);
+			wheel.schedule(level * 3U + 1U, start + offset);
+			wheel.schedule(level * 3U + 2U, start + offset + 1U);
+			deadlines[level * 3U]      = start + offset - 1U;
+			deadlines[level * 3U + 1U] = start + offset;
+			deadlines[level * 3U + 2U] = start + offset + 1U;
+		}
+		// A deadline of now is moved to the next tick
+		deadlines[0] = start + 1U;
+		std::uint64_t end { start + (1ULL << 18) + 1U };
+		for (std::uint64_t tick { start }; tick < end; tick += 1U + (tick - start) / 512U)
+		{
+			if (!PopDue(wheel, deadlines, s_Timers, tick))
+				return false;
+		}
+		if (!PopDue(wheel, deadlines, s_Timers, end))
+			return false;
+		TEST_EXPECT(!wheel.getCount());
+
+		// Random deadlines across every level, moved and cancelled on the way
+		std::mt19937_64 random { 3U };
+		std::uint64_t   tick { wheel.getCurrentTick() };
+		for (std::uint32_t i { 0 }; i < 20000U; ++i)
+		{
+			std::uint32_t timer { static_cast<std::uint32_t>(random() % s_Timers) };
+			switch (random() % 4U)
+			{
+			case 0:
+				wheel.cancel(timer);
+				deadlines[timer] = s_Idle;
+				break;
+			default:
+			{
+				std::uint64_t ahead { 1U + random() % (1ULL << (6U * (1U + random() % 3U))) };
+				wheel.schedule(timer, tick + ahead);
+				deadlines[timer] = tick + ahead;
+				break;
+			}
+			}
+
+			tick += random() % 64U;
+			if (!PopDue(wheel, deadlines, s_Timers, tick))
+				return false;
+		}
+		return true;
+	}
+} // namespace Tests
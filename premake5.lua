@@ -48,4 +48,26 @@ workspace("ModRGB")
 
 		filter({})
 
+		common:addActions()
+
+	group("Benchmarks")
+	project("Benchmarks")
+		location("Benchmarks/")
+		warnings("Extra")
+
+		common:outDirs()
+		common:debugDir()
+
+		kind("ConsoleApp")
+
+		libs.ReliableUDP:setupDep()
+
+		files({ "%{prj.location}/Src/**" })
+		removefiles({ "*.DS_Store" })
+
+		filter("system:linux")
+			linkoptions({ "-pthread" })
+
+		filter({})
+
 		common:addActions()
\ No newline at end of file